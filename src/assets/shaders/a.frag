@@ -8,20 +8,21 @@
 
 out vec4 FRAG_COL;
 
-struct A {
+// Shared by every instance of the material, see Renderer::MaterialData.
+struct Material {
     uvec2 diffuse;
     uvec2 normal;
     uvec2 metallic;
     uvec2 roughness;
     uvec2 emissive;
-    vec4 channels;
-    mat4 transform;
+    uint metallic_channel;
+    uint roughness_channel;
 };
 
-layout(std430, binding = 0) buffer VT { A a[]; };
+layout(std430, binding = 11) readonly buffer MATERIALS { Material materials[]; };
 layout(binding=5) uniform sampler2D texas;
 
-flat in uint idx;
+flat in uint material;
 flat in mat3 TBN;
 in V_OUT { vec3 v_pos; vec3 v_normal; } v_out;
 
@@ -65,13 +66,15 @@ float GeometrySchlickGGX(float NoV, float NoL, float roughness)
 
 vec4 BRDF(vec3 v) {
     vec2 tc = v_out.v_normal.xy;
-    vec3 diffuse_color = texture(sampler2D(a[idx].diffuse),   tc).rgb;
-    vec3 normal_color  = texture(sampler2D(a[idx].normal),    tc).rgb;
-	vec3 emissive_color  = texture(sampler2D(a[idx].emissive),tc).rgb;
-    float metalness    = texture(sampler2D(a[idx].metallic),  tc)[int(a[idx].channels[1])];
-    float roughness    = texture(sampler2D(a[idx].roughness), tc)[int(a[idx].channels[2])];
-
-    const vec3 n = TBN * (2.0 * normal_color - 1.0);
+    Material m = materials[material];
+    vec3 diffuse_color = texture(sampler2D(m.diffuse),   tc).rgb;
+    vec2 normal_xy     = texture(sampler2D(m.normal),    tc).rg * 2.0 - 1.0;
+	vec3 emissive_color  = texture(sampler2D(m.emissive),tc).rgb;
+    float metalness    = texture(sampler2D(m.metallic),  tc)[m.metallic_channel];
+    float roughness    = texture(sampler2D(m.roughness), tc)[m.roughness_channel];
+
+    // z is rebuilt from x and y, baked normal maps are BC5 and only store those.
+    const vec3 n = TBN * vec3(normal_xy, sqrt(saturate(1.0 - dot(normal_xy, normal_xy))));
     const float a = clamp(pow(roughness, 2.0), 0.089, 1.0);
     const float a2 = a*a;
 
@@ -1,37 +1,56 @@
 #version 460 core
 #extension GL_ARB_bindless_texture : require
 
+// Packed vertices, position and uv are in [-1, 1] of their mesh's ranges (see PackedVertex).
 layout(location = 0) in vec3 vPos;
-layout(location = 1) in vec3 vNorm;
+layout(location = 1) in vec2 vNorm;
 layout(location = 2) in vec3 vTan;
 layout(location = 3) in vec3 vBTan;
 
-struct A {
-    uvec2 diffuse;
-    uvec2 normal;
-    uvec2 metallic;
-    uvec2 roughness;
-    uvec2 emissive;
-    vec4 channels;
-    mat4 transform;
+// First three rows of the instance's transform and the index of its material's entry in the
+// material table.
+struct Instance {
+    float transform[12];
+    uint material;
 };
 
-layout(std430, binding = 0) buffer VT { A a[]; };
+layout(std430, binding = 0) readonly buffer INSTANCES { Instance instances[]; };
+// Instances that survived culling, filled per draw command by cull.comp.
+layout(std430, binding = 1) readonly buffer VISIBLE { uint visible[]; };
+layout(std430, binding = 3) readonly buffer INSTANCE_BATCHES { uint instance_batches[]; };
+
+// Per indirect batch ranges of its mesh, value = offset + packed * scale.
+struct Quantization {
+    vec4 position_offset;
+    vec4 position_scale;
+    vec4 uv; // xy offset, zw scale
+};
+layout(std430, binding = 5) readonly buffer QUANTIZATION { Quantization quantization[]; };
 
 uniform mat4 v;
 uniform mat4 p;
 
-flat out uint idx;
+flat out uint material;
 flat out mat3 TBN;
 out V_OUT { vec3 v_pos; vec3 v_normal; } v_out;
 
+mat4 instance_transform(uint i) {
+    float r[12] = instances[i].transform;
+    return transpose(mat4(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[8], r[9], r[10], r[11],
+                          0.0, 0.0, 0.0, 1.0));
+}
+
 void main() {
-    idx         = gl_BaseInstance + gl_InstanceID;
-    v_out.v_pos = (a[idx].transform * vec4(vPos, 1.0)).xyz;
-    v_out.v_normal = vNorm;
+    uint idx       = visible[gl_BaseInstance + gl_InstanceID];
+    mat4 transform = instance_transform(idx);
+    material       = instances[idx].material;
+    Quantization q = quantization[instance_batches[idx]];
+    vec3 pos       = q.position_offset.xyz + vPos * q.position_scale.xyz;
+    v_out.v_pos    = (transform * vec4(pos, 1.0)).xyz;
+    v_out.v_normal = vec3(q.uv.xy + vNorm * q.uv.zw, 0.0);
     
     vec3 N = cross(vTan, vBTan);
     TBN = mat3(vTan, vBTan, N);
 
-    gl_Position = p * v * a[idx].transform * vec4(vPos, 1.0);
+    gl_Position = p * v * vec4(v_out.v_pos, 1.0);
 }
\ No newline at end of file
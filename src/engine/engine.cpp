@@ -19,6 +19,8 @@ void eng::Engine::_update() {
     _renderer->render();
     _gui->draw();
     _window->swap_buffers();
+    _gpu_res_mgr->next_frame();
+    ShaderProgram::next_frame();
 }
 
 void eng::Engine::start() {
@@ -34,10 +36,14 @@ void eng::Engine::initialise(std::string_view window_name, uint32_t size_x, uint
     eng::Engine::_instance = std::make_unique<eng::Engine>();
     auto this_             = eng::Engine::_instance.get();
 
-    this_->_window      = std::make_unique<Window>(window_name, size_x, size_y);
-    this_->_camera      = std::make_unique<Camera>();
-    this_->_controller  = std::make_unique<Keyboard>();
-    this_->_gpu_res_mgr = std::make_unique<GpuResMgr>();
-    this_->_renderer    = std::make_unique<Renderer>();
-    this_->_gui         = std::make_unique<GUI>();
+    this_->_window         = std::make_unique<Window>(window_name, size_x, size_y);
+    this_->_camera         = std::make_unique<Camera>();
+    this_->_controller     = std::make_unique<Keyboard>();
+    this_->_gpu_res_mgr    = std::make_unique<GpuResMgr>();
+    this_->_program_cache  = std::make_unique<ProgramCache>("cache/programs/");
+    this_->_renderer       = std::make_unique<Renderer>();
+    this_->_gui            = std::make_unique<GUI>();
+    this_->_thread_pool    = std::make_unique<ThreadPool>();
+    this_->_texture_loader = std::make_unique<TextureLoader>(*this_->_thread_pool);
+    this_->_texture_cache  = std::make_unique<TextureCache>(*this_->_texture_loader);
 }
\ No newline at end of file
@@ -6,12 +6,16 @@
 #include <engine/window/window.hpp>
 #include <engine/controller/controller.hpp>
 #include <engine/gpu/shaderprogram/shader.hpp>
+#include <engine/gpu/shaderprogram/program_cache.hpp>
 #include <engine/gpu/buffers/buffer.hpp>
 #include <engine/gpu/buffers/ubo.hpp>
 #include <engine/gpu/resource_manager/gpu_res_mgr.hpp>
 #include <engine/renderer/renderer.hpp>
 #include <engine/gui/gui.hpp>
 #include <engine/camera/camera.hpp>
+#include <engine/types/thread_pool.hpp>
+#include <engine/gpu/texture/texture_loader.hpp>
+#include <engine/gpu/texture/texture_cache.hpp>
 
 namespace eng {
     class Engine {
@@ -25,8 +29,12 @@ namespace eng {
         Camera *get_camera() { return _camera.get(); }
         Controller *get_controller() { return _controller.get(); }
         GpuResMgr *get_gpu_res_mgr() { return _gpu_res_mgr.get(); }
+        ProgramCache *get_program_cache() { return _program_cache.get(); }
         Renderer *get_renderer() { return _renderer.get(); }
         GUI *get_gui() { return _gui.get(); }
+        ThreadPool *get_thread_pool() { return _thread_pool.get(); }
+        TextureLoader *get_texture_loader() { return _texture_loader.get(); }
+        TextureCache *get_texture_cache() { return _texture_cache.get(); }
 
         static void initialise(std::string_view window_name, uint32_t size_x, uint32_t size_y);
         static Engine &instance() { return *_instance; }
@@ -35,8 +43,12 @@ namespace eng {
         std::unique_ptr<Camera> _camera;
         std::unique_ptr<Controller> _controller;
         std::unique_ptr<GpuResMgr> _gpu_res_mgr;
+        std::unique_ptr<ProgramCache> _program_cache;
         std::unique_ptr<Renderer> _renderer;
         std::unique_ptr<GUI> _gui;
+        std::unique_ptr<ThreadPool> _thread_pool;
+        std::unique_ptr<TextureLoader> _texture_loader;
+        std::unique_ptr<TextureCache> _texture_cache;
 
       private:
         void _update();
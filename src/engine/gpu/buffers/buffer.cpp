@@ -2,6 +2,8 @@
 
 #include <stdexcept>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
 
 #include <glad/glad.h>
 
@@ -15,20 +17,28 @@ namespace eng {
     }
 
     void GLBuffer::push_data(const void *data, size_t data_size) {
-        if (_capacity < _size + data_size) { _resize(_size + data_size); }
+        write_data(_size, data, data_size);
+    }
+
+    void GLBuffer::write_data(size_t offset, const void *data, size_t data_size) {
+        if (_capacity < offset + data_size) { _resize(offset + data_size); }
 
         if ((_flags & GL_DYNAMIC_STORAGE_BIT) != GL_DYNAMIC_STORAGE_BIT) {
             GLuint temp_buffer;
             glCreateBuffers(1, &temp_buffer);
             glNamedBufferStorage(temp_buffer, data_size, data, 0);
 
-            glCopyNamedBufferSubData(temp_buffer, _handle, 0, _size, data_size);
+            glCopyNamedBufferSubData(temp_buffer, _handle, 0, offset, data_size);
             glDeleteBuffers(1, &temp_buffer);
         } else {
-            glNamedBufferSubData(_handle, _size, data_size, data);
+            glNamedBufferSubData(_handle, offset, data_size, data);
         }
 
-        _size += data_size;
+        _size = std::max(_size, offset + data_size);
+    }
+
+    void GLBuffer::reserve(size_t size_bytes) {
+        if (_capacity < size_bytes) { _resize(size_bytes); }
     }
 
     void GLBuffer::clear_invalidate() {
@@ -61,6 +71,92 @@ namespace eng {
 
     GLBuffer::~GLBuffer() { glDeleteBuffers(1, &_handle); }
 
+    GLRingBuffer::GLRingBuffer(size_t region_size, uint32_t region_count)
+        : _region_count{region_count} {
+        _fences.resize(_region_count, nullptr);
+        _create_storage(region_size);
+    }
+
+    GLRingBuffer::~GLRingBuffer() {
+        for (auto f : _fences) {
+            if (f != nullptr) { glDeleteSync((GLsync)f); }
+        }
+        if (_mapped != nullptr) { glUnmapNamedBuffer(_handle); }
+        glDeleteBuffers(1, &_handle);
+    }
+
+    void GLRingBuffer::begin_frame() {
+        _region = (_region + 1u) % _region_count;
+        _size   = 0;
+        _wait_fence(_region);
+    }
+
+    void GLRingBuffer::end_frame() {
+        if (_fences[_region] != nullptr) { glDeleteSync((GLsync)_fences[_region]); }
+        _fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void *GLRingBuffer::allocate(size_t size_bytes) {
+        if (_region_size < _size + size_bytes) { _create_storage(_size + size_bytes); }
+
+        auto ptr = _mapped + region_offset() + _size;
+        _size += size_bytes;
+        return ptr;
+    }
+
+    void GLRingBuffer::push_data(const void *data, size_t size_bytes) {
+        memcpy(allocate(size_bytes), data, size_bytes);
+    }
+
+    void GLRingBuffer::bind(uint32_t GL_TARGET) { glBindBuffer(GL_TARGET, _handle); }
+
+    void GLRingBuffer::bind_base(uint32_t GL_TARGET, uint32_t base) {
+        glBindBufferRange(GL_TARGET, base, _handle, region_offset(), _region_size);
+    }
+
+    void GLRingBuffer::_create_storage(size_t region_size) {
+        static constexpr auto flags
+            = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        if (_handle != 0u) { region_size = fmaxl(region_size * GROWTH_FACTOR, 1.); }
+        region_size = (region_size + REGION_ALIGNMENT - 1u) / REGION_ALIGNMENT * REGION_ALIGNMENT;
+
+        uint32_t new_handle;
+        glCreateBuffers(1, &new_handle);
+        glNamedBufferStorage(new_handle, region_size * _region_count, nullptr, flags);
+        auto new_mapped = (uint8_t *)glMapNamedBufferRange(
+            new_handle, 0, region_size * _region_count, flags);
+        assert(new_mapped != nullptr && "Could not map ring buffer");
+
+        // Growing mid-frame: keep what was already written to the current region, other regions
+        // are still being read by the GPU and have to be finished before old storage goes away.
+        if (_handle != 0u) {
+            memcpy(new_mapped + _region * region_size, _mapped + region_offset(), _size);
+            for (auto i = 0u; i < _region_count; ++i) { _wait_fence(i); }
+            glUnmapNamedBuffer(_handle);
+            glDeleteBuffers(1, &_handle);
+        }
+
+        _handle      = new_handle;
+        _mapped      = new_mapped;
+        _region_size = region_size;
+
+        on_handle_change.emit(new_handle);
+    }
+
+    void GLRingBuffer::_wait_fence(uint32_t region) {
+        auto &fence = _fences[region];
+        if (fence == nullptr) { return; }
+
+        while (true) {
+            const auto res = glClientWaitSync((GLsync)fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+            if (res == GL_ALREADY_SIGNALED || res == GL_CONDITION_SATISFIED) { break; }
+            assert(res != GL_WAIT_FAILED && "Waiting on ring buffer fence failed");
+        }
+        glDeleteSync((GLsync)fence);
+        fence = nullptr;
+    }
+
     GLVao::GLVao(std::initializer_list<GLVaoBinding> bindings,
                  std::initializer_list<GLVaoAttribute> attributes,
                  Handle<GLBuffer> ebo)
@@ -105,7 +201,7 @@ namespace eng {
         for (auto &a : _attributes) {
             uint32_t &offset = attr_offset[a.binding_id];
             a.byte_offset    = offset;
-            offset += a.size * sizeof(float); // TODO: Probably need to support more byte sizes...
+            offset += _get_attr_byte_size(a);
         }
     }
 
@@ -133,7 +229,30 @@ namespace eng {
     uint32_t GLVao::_get_gl_attr_format(ATTR_FORMAT format) {
         switch (format) {
         case eng::ATTR_FORMAT::FLOAT: return GL_FLOAT;
-        default: assert(false && "unsupported format");
+        case eng::ATTR_FORMAT::HALF_FLOAT: return GL_HALF_FLOAT;
+        case eng::ATTR_FORMAT::BYTE: return GL_BYTE;
+        case eng::ATTR_FORMAT::UNSIGNED_BYTE: return GL_UNSIGNED_BYTE;
+        case eng::ATTR_FORMAT::SHORT: return GL_SHORT;
+        case eng::ATTR_FORMAT::UNSIGNED_SHORT: return GL_UNSIGNED_SHORT;
+        case eng::ATTR_FORMAT::INT_2_10_10_10_REV: return GL_INT_2_10_10_10_REV;
+        case eng::ATTR_FORMAT::UNSIGNED_INT_2_10_10_10_REV: return GL_UNSIGNED_INT_2_10_10_10_REV;
+        default: assert(false && "unsupported format"); return GL_FLOAT;
+        }
+    }
+
+    uint32_t GLVao::_get_attr_byte_size(const GLVaoAttribute &attribute) {
+        switch (attribute.format) {
+        case eng::ATTR_FORMAT::FLOAT: return attribute.size * 4u;
+        case eng::ATTR_FORMAT::HALF_FLOAT:
+        case eng::ATTR_FORMAT::SHORT:
+        case eng::ATTR_FORMAT::UNSIGNED_SHORT: return attribute.size * 2u;
+        case eng::ATTR_FORMAT::BYTE:
+        case eng::ATTR_FORMAT::UNSIGNED_BYTE: return attribute.size;
+        case eng::ATTR_FORMAT::INT_2_10_10_10_REV:
+        case eng::ATTR_FORMAT::UNSIGNED_INT_2_10_10_10_REV:
+            assert(attribute.size == 4u && "packed formats need all four components");
+            return 4u;
+        default: assert(false && "unsupported format"); return 0u;
         }
     }
 
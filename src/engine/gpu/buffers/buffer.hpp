@@ -30,6 +30,11 @@ namespace eng {
         ~GLBuffer();
 
         void push_data(const void *data, size_t size_bytes);
+        // Writes at given byte offset, growing the buffer if needed. size() becomes the furthest
+        // byte written to.
+        void write_data(size_t offset, const void *data, size_t size_bytes);
+        // Grows capacity to at least size_bytes, for buffers that only the GPU writes to.
+        void reserve(size_t size_bytes);
         void clear_invalidate();
         void bind(uint32_t GL_TARGET);
         void bind_base(uint32_t GL_TARGET, uint32_t base);
@@ -37,6 +42,7 @@ namespace eng {
         uint32_t handle() const { return _handle; }
         size_t size() const { return _size; }
         size_t capacity() const { return _capacity; }
+        size_t byte_size() const { return _capacity; }
 
         Signal<uint32_t> on_handle_change;
 
@@ -49,6 +55,64 @@ namespace eng {
         static constexpr float GROWTH_FACTOR{1.61f};
     };
 
+    // Persistently mapped buffer split into regions, CPU writes one region per frame directly into
+    // mapped memory. Every region is guarded by a fence, CPU only waits when it laps the GPU.
+    struct GLRingBuffer : public IdResource<GLRingBuffer> {
+        explicit GLRingBuffer() = default;
+        explicit GLRingBuffer(size_t region_size, uint32_t region_count = DEFAULT_REGION_COUNT);
+        GLRingBuffer(GLRingBuffer &&b) noexcept {
+            id               = b.id;
+            _handle          = b._handle;
+            _mapped          = b._mapped;
+            _fences          = std::move(b._fences);
+            _region          = b._region;
+            _region_count    = b._region_count;
+            _region_size     = b._region_size;
+            _size            = b._size;
+            on_handle_change = std::move(b.on_handle_change);
+
+            b.id      = 0;
+            b._handle = 0;
+            b._mapped = nullptr;
+        }
+        ~GLRingBuffer();
+
+        // Moves to the next region, waiting for the GPU if it still reads from it.
+        void begin_frame();
+        // Fences the region written this frame.
+        void end_frame();
+
+        // Returns memory for size_bytes inside the current region. It stays valid until the next
+        // allocate call, which may have to grow the buffer.
+        void *allocate(size_t size_bytes);
+        void push_data(const void *data, size_t size_bytes);
+        void bind(uint32_t GL_TARGET);
+        void bind_base(uint32_t GL_TARGET, uint32_t base);
+
+        uint32_t handle() const { return _handle; }
+        // Byte offset of the current region from the start of the buffer.
+        size_t region_offset() const { return _region * _region_size; }
+        size_t size() const { return _size; }
+        size_t capacity() const { return _region_size; }
+        size_t byte_size() const { return _region_size * _region_count; }
+
+        Signal<uint32_t> on_handle_change;
+
+      private:
+        void _create_storage(size_t region_size);
+        void _wait_fence(uint32_t region);
+
+        uint32_t _handle{0};
+        uint8_t *_mapped{nullptr};
+        std::vector<void *> _fences;
+        uint32_t _region{0}, _region_count{DEFAULT_REGION_COUNT};
+        size_t _region_size{0}, _size{0};
+
+        static constexpr uint32_t DEFAULT_REGION_COUNT{3u};
+        static constexpr size_t REGION_ALIGNMENT{256u};
+        static constexpr float GROWTH_FACTOR{1.61f};
+    };
+
     struct GLVaoBinding {
         explicit GLVaoBinding(uint32_t binding_id,
                               Handle<GLBuffer> buffer_handle,
@@ -62,7 +126,18 @@ namespace eng {
         size_t stride{0u}, offset{0u};
     };
 
-    enum class ATTR_FORMAT { FLOAT };
+    // Component type of a vertex attribute. The 2_10_10_10 formats pack all four components into
+    // one uint32 and need size 4.
+    enum class ATTR_FORMAT {
+        FLOAT,
+        HALF_FLOAT,
+        BYTE,
+        UNSIGNED_BYTE,
+        SHORT,
+        UNSIGNED_SHORT,
+        INT_2_10_10_10_REV,
+        UNSIGNED_INT_2_10_10_10_REV
+    };
 
     struct GLVaoAttribute {
         explicit GLVaoAttribute(uint32_t attr_id,
@@ -109,6 +184,7 @@ namespace eng {
         void _configure_bindings();
         void _configure_attributes();
         uint32_t _get_gl_attr_format(ATTR_FORMAT format);
+        uint32_t _get_attr_byte_size(const GLVaoAttribute &attribute);
 
         uint32_t _handle;
         std::vector<GLVaoBinding> _bindings;
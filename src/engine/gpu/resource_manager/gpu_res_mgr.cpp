@@ -1,7 +1,25 @@
 #include "gpu_res_mgr.hpp"
 
 eng::GpuResMgr::~GpuResMgr() {
-    for (auto &[_, c] : _containers) {
-        for (auto &e : c) { delete e; }
+    for (const auto &pd : _pending_deletions) { pd.pool->destroy(pd.slot); }
+    for (auto it = _pools.rbegin(); it != _pools.rend(); ++it) { it->reset(); }
+}
+
+void eng::GpuResMgr::next_frame() {
+    ++_frame;
+
+    // Delay may change between frames, so the queue is not strictly ordered by frame.
+    std::erase_if(_pending_deletions, [this](const PendingDeletion &pd) {
+        if (pd.frame > _frame) { return false; }
+        pd.pool->destroy(pd.slot);
+        return true;
+    });
+}
+
+std::vector<eng::GpuResourceStats> eng::GpuResMgr::get_stats() const {
+    std::vector<GpuResourceStats> stats;
+    for (const auto &p : _pools) {
+        if (p != nullptr) { stats.push_back(p->stats()); }
     }
+    return stats;
 }
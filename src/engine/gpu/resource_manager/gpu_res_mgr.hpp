@@ -2,11 +2,12 @@
 
 #include <concepts>
 #include <type_traits>
-#include <typeindex>
-#include <unordered_map>
+#include <memory>
+#include <vector>
+#include <deque>
 
-#include <engine/types/sorted_vec.hpp>
 #include <engine/types/idresource.hpp>
+#include <engine/gpu/resource_manager/resource_pool.hpp>
 #include <engine/gpu/buffers/buffer.hpp>
 #include <engine/gpu/texture/texture.hpp>
 
@@ -20,56 +21,69 @@ namespace eng {
         ~GpuResMgr();
 
         template <GpuResource Resource> Resource *create_resource(Resource &&rsc) {
-            return static_cast<Resource *>(
-                _get_storage<Resource>().insert(new Resource{std::move(rsc)}));
+            return _get_pool<Resource>().insert(std::move(rsc));
+        }
+        template <typename Resource> Resource *get_resource(Handle<Resource> handle) {
+            return _get_pool<Resource>().get(handle);
+        }
+        // For handles that may have been destroyed meanwhile: returns nullptr instead of asserting.
+        template <typename Resource> Resource *try_get_resource(Handle<Resource> handle) {
+            return _get_pool<Resource>().try_get(handle);
+        }
+        template <typename Resource> bool contains(Handle<Resource> handle) {
+            return _get_pool<Resource>().contains(handle);
         }
-        template <typename Resource> Resource *get_resource(Handle<Resource>);
         template <typename Resource> Resource *get_resource(size_t idx) {
-            return _get_storage<Resource>()[idx];
+            return _get_pool<Resource>().alive()[idx];
         }
-        template <typename Resource> auto count() { return _get_storage<Resource>().size(); };
+        template <typename Resource> auto count() { return _get_pool<Resource>().size(); };
 
-        // Don't like this idea, but didn't have time to make something safer.
-        // Casting from vec<B*> to vec<D*>: no object slicing, containers are always homogenous.
-        // B - base, D - Derived
-        template <typename Resource> auto &get_storage() {
-            return *reinterpret_cast<SortedVector<Resource *, _sort_func_t> *>(
-                &_get_storage<Resource>());
+        // Alive resources of given type, in no particular order - destroying one moves the last one
+        // into its place.
+        template <typename Resource> const std::vector<Resource *> &get_storage() {
+            return _get_pool<Resource>().alive();
         }
 
-      private:
-        using _sort_func_t = decltype([](auto &&a, auto &&b) { return a->id < b->id; });
-        using _storage_t   = SortedVector<IdWrapper *, _sort_func_t>;
-
-        template <typename Resource> _storage_t &_get_storage() {
-            auto ti = std::type_index{typeid(Resource)};
-
-            if (_containers.contains(ti) == false) { _containers[ti]; }
-
-            return _containers.at(ti);
+        // The handle stops resolving immediately. The object, and GL objects it owns, are
+        // destroyed deletion_delay frames later, so draws already submitted can still use them.
+        template <GpuResource Resource> void destroy_resource(Handle<Resource> handle) {
+            auto &pool = _get_pool<Resource>();
+            _pending_deletions.push_back(
+                PendingDeletion{_frame + _deletion_delay, &pool, pool.release(handle)});
         }
 
-        std::unordered_map<std::type_index, _storage_t> _containers;
-    };
-
-    template <typename Resource> Resource *GpuResMgr::get_resource(Handle<Resource> handle) {
-        auto &storage = _get_storage<Resource>();
-        auto p_data   = storage.try_find(handle, [](auto &&a, auto &&b) {
-            uint32_t _a, _b;
-
-            // clang-format off
-            if constexpr (std::is_pointer_v<std::remove_reference_t<decltype(a)>>) { _a = a->id; } 
-            else { _a = a.id; }
-            if constexpr (std::is_pointer_v<std::remove_reference_t<decltype(b)>>) { _b = b->id; } 
-            else { _b = b.id; }
-            // clang-format on
+        // Call once per frame, after the frame's commands were submitted.
+        void next_frame();
+        void set_deletion_delay(uint32_t frames) { _deletion_delay = frames; }
+        uint32_t deletion_delay() const { return _deletion_delay; }
 
-            return _a < _b;
-        });
+        std::vector<GpuResourceStats> get_stats() const;
 
-        assert(p_data != nullptr && "Bad handle");
+      private:
+        struct PendingDeletion {
+            uint64_t frame;
+            ResourcePoolBase *pool;
+            uint32_t slot;
+        };
+
+        // Every resource type gets its own slot in _pools, the index is fixed per type before main.
+        static inline uint32_t _pool_count{0u};
+        template <typename Resource> static inline const uint32_t _pool_index = _pool_count++;
+
+        template <typename Resource> ResourcePool<Resource> &_get_pool() {
+            const auto idx = _pool_index<Resource>;
+            if (idx >= _pools.size()) { _pools.resize(idx + 1u); }
+            if (_pools[idx] == nullptr) {
+                _pools[idx] = std::make_unique<ResourcePool<Resource>>();
+            }
+            return *static_cast<ResourcePool<Resource> *>(_pools[idx].get());
+        }
 
-        return static_cast<Resource *>(*p_data);
-    }
+        std::vector<std::unique_ptr<ResourcePoolBase>> _pools;
+        std::deque<PendingDeletion> _pending_deletions;
+        uint64_t _frame{0u};
+        uint32_t _deletion_delay{DEFAULT_DELETION_DELAY};
 
-} // namespace eng
\ No newline at end of file
+        static constexpr uint32_t DEFAULT_DELETION_DELAY{3u};
+    };
+} // namespace eng
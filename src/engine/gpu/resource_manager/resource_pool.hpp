@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+#include <utility>
+#include <typeinfo>
+#include <string_view>
+#include <cassert>
+
+#include <engine/types/idresource.hpp>
+
+namespace eng {
+    struct GpuResourceStats {
+        std::string_view type_name;
+        size_t live_count{0u}, live_bytes{0u};
+        size_t pending_count{0u}, pending_bytes{0u};
+    };
+
+    class ResourcePoolBase {
+      public:
+        virtual ~ResourcePoolBase() = default;
+
+        // Runs destructor of a previously released resource and makes its slot reusable.
+        virtual void destroy(uint32_t slot_idx) = 0;
+        virtual GpuResourceStats stats() const  = 0;
+    };
+
+    // Storage for all resources of one type. Objects live in fixed-size chunks, so they are laid
+    // out contiguously and never move once created - pointers returned by insert stay valid.
+    // Resource id is overwritten with its handle: slot index in lower INDEX_BITS, slot
+    // generation in the upper ones. Resolving a handle is a single load from _slots.
+    template <typename Resource> class ResourcePool : public ResourcePoolBase {
+      public:
+        static constexpr uint32_t INDEX_BITS = 24u;
+        static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1u;
+        static constexpr uint32_t GEN_MASK   = (1u << (32u - INDEX_BITS)) - 1u;
+        static constexpr uint32_t CHUNK_SIZE = 64u;
+
+        ResourcePool() = default;
+        ResourcePool(const ResourcePool &) = delete;
+        ResourcePool &operator=(const ResourcePool &) = delete;
+        ~ResourcePool() override {
+            for (auto r : _alive) { r->~Resource(); }
+        }
+
+        Resource *insert(Resource &&rsc) {
+            uint32_t idx;
+            if (_free_slots.empty() == false) {
+                idx = _free_slots.back();
+                _free_slots.pop_back();
+            } else {
+                idx = (uint32_t)_slots.size();
+                assert(idx <= INDEX_MASK && "ResourcePool ran out of slots");
+
+                if (idx % CHUNK_SIZE == 0u) { _chunks.push_back(std::make_unique<Chunk>()); }
+                _slots.push_back(Slot{
+                    reinterpret_cast<Resource *>(
+                        &_chunks.back()->data[(idx % CHUNK_SIZE) * sizeof(Resource)]),
+                    1u});
+            }
+
+            auto &slot       = _slots[idx];
+            auto r           = new (slot.ptr) Resource{std::move(rsc)};
+            r->id            = (slot.generation << INDEX_BITS) | idx;
+            slot.alive_index = (uint32_t)_alive.size();
+            _alive.push_back(r);
+
+            return r;
+        }
+
+        Resource *get(Handle<Resource> h) const {
+            const auto idx = h.id & INDEX_MASK;
+            assert(idx < _slots.size() && _slots[idx].generation == (h.id >> INDEX_BITS)
+                   && "Bad handle");
+            return _slots[idx].ptr;
+        }
+
+        bool contains(Handle<Resource> h) const {
+            const auto idx = h.id & INDEX_MASK;
+            return idx < _slots.size() && _slots[idx].generation == (h.id >> INDEX_BITS);
+        }
+
+        // Like get(), but a stale handle resolves to nullptr instead of asserting.
+        Resource *try_get(Handle<Resource> h) const {
+            return contains(h) ? _slots[h.id & INDEX_MASK].ptr : nullptr;
+        }
+
+        // Invalidates the handle right away, the object itself stays untouched until destroy().
+        uint32_t release(Handle<Resource> h) {
+            assert(contains(h) && "Bad handle");
+
+            const auto idx  = h.id & INDEX_MASK;
+            auto &slot      = _slots[idx];
+            slot.generation = (slot.generation + 1u) & GEN_MASK;
+            if (slot.generation == 0u) { slot.generation = 1u; }
+
+            // Swap and pop, the resource moved into the hole gets its new position patched.
+            const auto last                           = _alive.back();
+            _alive[slot.alive_index]                  = last;
+            _slots[last->id & INDEX_MASK].alive_index = slot.alive_index;
+            _alive.pop_back();
+            _pending_count++;
+            _pending_bytes += byte_size(*slot.ptr);
+
+            return idx;
+        }
+
+        void destroy(uint32_t slot_idx) override {
+            auto r = _slots[slot_idx].ptr;
+            _pending_count--;
+            _pending_bytes -= byte_size(*r);
+            r->~Resource();
+            _free_slots.push_back(slot_idx);
+        }
+
+        GpuResourceStats stats() const override {
+            GpuResourceStats s{.type_name     = typeid(Resource).name(),
+                               .live_count    = _alive.size(),
+                               .pending_count = _pending_count,
+                               .pending_bytes = _pending_bytes};
+            for (const auto r : _alive) { s.live_bytes += byte_size(*r); }
+            return s;
+        }
+
+        const std::vector<Resource *> &alive() const { return _alive; }
+        size_t size() const { return _alive.size(); }
+
+        // Resources that own GPU memory report it through byte_size(), the rest count as their
+        // CPU-side size.
+        static size_t byte_size(const Resource &r) {
+            if constexpr (requires { r.byte_size(); }) {
+                return r.byte_size();
+            } else {
+                return sizeof(Resource);
+            }
+        }
+
+      private:
+        struct Chunk {
+            alignas(Resource) std::byte data[sizeof(Resource) * CHUNK_SIZE];
+        };
+        struct Slot {
+            Resource *ptr{nullptr};
+            uint32_t generation{1u};
+            uint32_t alive_index{0u};
+        };
+
+        std::vector<std::unique_ptr<Chunk>> _chunks;
+        std::vector<Slot> _slots;
+        std::vector<uint32_t> _free_slots;
+        std::vector<Resource *> _alive;
+        size_t _pending_count{0u}, _pending_bytes{0u};
+    };
+} // namespace eng
@@ -0,0 +1,119 @@
+#include "program_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+
+#include <glad/glad.h>
+
+namespace eng {
+    // FNV-1a, continued from hash.
+    static uint64_t fnv1a(const void *data, size_t size, uint64_t hash) {
+        const auto bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0u; i < size; ++i) { hash = (hash ^ bytes[i]) * 1099511628211ull; }
+        return hash;
+    }
+
+    ProgramCache::ProgramCache(std::filesystem::path cache_dir) : _cache_dir{std::move(cache_dir)} {
+        GLint formats{0};
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        _enabled = formats > 0;
+
+        _driver_hash = 14695981039346656037ull;
+        for (const auto name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+            const auto str = reinterpret_cast<const char *>(glGetString(name));
+            if (str != nullptr) { _driver_hash = fnv1a(str, strlen(str) + 1u, _driver_hash); }
+        }
+    }
+
+    uint64_t ProgramCache::key(const std::vector<Stage> &stages) const {
+        auto hash = _driver_hash;
+        for (const auto &[type, source] : stages) {
+            hash = fnv1a(&type, sizeof(type), hash);
+            hash = fnv1a(source.data(), source.size() + 1u, hash);
+        }
+        return hash;
+    }
+
+    std::filesystem::path ProgramCache::_path(uint64_t key) const {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.glprogram", (unsigned long long)key);
+        return _cache_dir / name;
+    }
+
+    bool ProgramCache::load(uint32_t program, uint64_t key) {
+        if (_enabled == false) { return false; }
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto path  = _path(key);
+        std::ifstream file{path, std::ios::binary};
+        Header h{};
+        if (file.is_open() == false || !file.read(reinterpret_cast<char *>(&h), sizeof(h))
+            || memcmp(h.magic, "HPPB", 4) != 0 || h.version != VERSION || h.key != key) {
+            _stats.misses++;
+            return false;
+        }
+        std::vector<char> binary(h.size);
+        if (!file.read(binary.data(), (std::streamsize)binary.size())) {
+            _stats.misses++;
+            return false;
+        }
+
+        glProgramBinary(program, h.format, binary.data(), (GLsizei)binary.size());
+        GLint linked{GL_FALSE};
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked == GL_FALSE) {
+            _stats.rejected++;
+            _stats.misses++;
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+            return false;
+        }
+
+        _stats.hits++;
+        _stats.binary_ms += std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+        return true;
+    }
+
+    void ProgramCache::store(uint32_t program, uint64_t key, double build_ms) {
+        _stats.source_ms += build_ms;
+        if (_enabled == false) { return; }
+
+        GLint size{0};
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+        if (size <= 0) { return; }
+
+        std::vector<char> binary((size_t)size);
+        GLenum format{0};
+        glGetProgramBinary(program, size, &size, &format, binary.data());
+        const Header h{.magic   = {'H', 'P', 'P', 'B'},
+                       .version = VERSION,
+                       .key     = key,
+                       .format  = format,
+                       .size    = (uint32_t)size};
+
+        // Written next to its place and renamed into it, so another instance reading the cache
+        // never sees half a file.
+        std::error_code ec;
+        std::filesystem::create_directories(_cache_dir, ec);
+        const auto path = _path(key);
+        auto tmp        = path;
+        tmp += ".tmp";
+        {
+            std::ofstream file{tmp, std::ios::binary | std::ios::trunc};
+            file.write(reinterpret_cast<const char *>(&h), sizeof(h));
+            file.write(binary.data(), size);
+            if (!file) {
+                file.close();
+                std::filesystem::remove(tmp, ec);
+                return;
+            }
+        }
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) { std::filesystem::remove(tmp, ec); }
+    }
+} // namespace eng
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <filesystem>
+
+namespace eng {
+    // Linked program binaries on disk, so launches after the first skip compiling and linking.
+    // Keys hash the sources of every stage together with the GL vendor, renderer and version, a
+    // driver update changes all of them and the old binaries are never looked at again. Drivers
+    // may still reject a binary, the program is then built from source and its entry rewritten.
+    class ProgramCache {
+      public:
+        // GL shader type and source of one stage.
+        using Stage = std::pair<uint32_t, std::string>;
+
+        struct Stats {
+            uint32_t hits{0u}, misses{0u}, rejected{0u};
+            // Time taken by programs created from a binary, and by those compiled and linked
+            // from source.
+            double binary_ms{0.0}, source_ms{0.0};
+        };
+
+        // Needs a current GL context. Caching is off if the driver has no binary formats.
+        explicit ProgramCache(std::filesystem::path cache_dir);
+
+        uint64_t key(const std::vector<Stage> &stages) const;
+        // Links program out of the binary cached under key. False if there is none or the driver
+        // rejected it, program can still be linked from source then.
+        bool load(uint32_t program, uint64_t key);
+        // Writes the binary of program, linked from source in build_ms, under key. The program
+        // has to be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+        void store(uint32_t program, uint64_t key, double build_ms);
+
+        bool is_enabled() const { return _enabled; }
+        const Stats &stats() const { return _stats; }
+
+      private:
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint64_t key;
+            uint32_t format;
+            uint32_t size;
+        };
+        static constexpr uint32_t VERSION{1u};
+
+        std::filesystem::path _path(uint64_t key) const;
+
+        std::filesystem::path _cache_dir;
+        uint64_t _driver_hash{0u};
+        bool _enabled{false};
+        Stats _stats;
+    };
+} // namespace eng
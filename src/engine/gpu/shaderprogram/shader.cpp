@@ -1,5 +1,4 @@
-#include "shader_dec.hpp"
-#include "shader_template.cpp"
+#include "shader.hpp"
 
 #include <filesystem>
 #include <ranges>
@@ -7,14 +6,52 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <chrono>
+#include <algorithm>
 
 #include <glad/glad.h>
 #include <vector>
 
-static unsigned compile_shader(const std::string &path, unsigned type);
+#include <engine/engine.hpp>
+
+// Not in glad's headers, the ARB and KHR versions of parallel_shader_compile share it.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+static std::string read_source(const std::string &path);
+static std::string info_log(unsigned object, bool program);
 
 namespace eng {
+    // Whether the driver compiles and links on threads of its own and can be asked if it is done
+    // without waiting for it.
+    static bool has_parallel_compile() {
+        static const bool supported = [] {
+            GLint count{0};
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (auto i = 0; i < count; ++i) {
+                const std::string_view ext{(const char *)glGetStringi(GL_EXTENSIONS, (GLuint)i)};
+                if (ext == "GL_KHR_parallel_shader_compile"
+                    || ext == "GL_ARB_parallel_shader_compile") {
+                    return true;
+                }
+            }
+            return false;
+        }();
+        return supported;
+    }
+
     ShaderProgram::ShaderProgram(const std::string &file_name) : file_name{file_name} {
+        auto stages = _read_stages(file_name);
+        if (stages.empty()) {
+            program_id = glCreateProgram();
+            return;
+        }
+        _build = std::make_unique<Build>();
+        _submit(std::move(stages));
+    }
+
+    std::vector<ProgramCache::Stage> ShaderProgram::_read_stages(const std::string &file_name) {
         // auto files = std::filesystem::directory_iterator{SHADERS_DIR} |
         // std::views::filter([&file_name](const auto &entry) {
         //                  auto fname  = entry.path().filename().string();
@@ -53,76 +90,261 @@ namespace eng {
             }
         }
 
-        program_id = glCreateProgram();
-
-        const auto link_program = [this](const std::vector<unsigned> &ids) -> void {
-            for (const auto &h : ids) { glAttachShader(program_id, h); }
-            glLinkProgram(program_id);
-            for (const auto &h : ids) { glDeleteShader(h); }
+        const auto source = [&file_name](const char *ext) {
+            return read_source(std::string{SHADERS_DIR}.append(file_name).append(ext));
         };
 
+        std::vector<ProgramCache::Stage> stages;
         if (present_shaders & ((unsigned)VERTEX | (unsigned)FRAGMENT)) {
-            std::vector<uint32_t> shader_handles{
-                compile_shader(std::string{SHADERS_DIR}.append(file_name).append(".vert"),
-                               GL_VERTEX_SHADER),
-                compile_shader(std::string{SHADERS_DIR}.append(file_name).append(".frag"),
-                               GL_FRAGMENT_SHADER)};
+            stages.emplace_back(GL_VERTEX_SHADER, source(".vert"));
+            stages.emplace_back(GL_FRAGMENT_SHADER, source(".frag"));
 
             if (present_shaders & ((unsigned)TESS_C | (unsigned)TESS_E)) {
-                shader_handles.push_back(
-                    compile_shader(std::string{SHADERS_DIR}.append(file_name).append(".tesc"),
-                                   GL_TESS_CONTROL_SHADER));
-                shader_handles.push_back(
-                    compile_shader(std::string{SHADERS_DIR}.append(file_name).append(".tese"),
-                                   GL_TESS_EVALUATION_SHADER));
+                stages.emplace_back(GL_TESS_CONTROL_SHADER, source(".tesc"));
+                stages.emplace_back(GL_TESS_EVALUATION_SHADER, source(".tese"));
             }
-
-            link_program(shader_handles);
         } else if (present_shaders & (uint32_t)(COMPUTE)) {
-            link_program({compile_shader(std::string{SHADERS_DIR}.append(file_name).append(".comp"),
-                                         GL_COMPUTE_SHADER)});
+            stages.emplace_back(GL_COMPUTE_SHADER, source(".comp"));
+        }
+        return stages;
+    }
+
+    void ShaderProgram::_submit(std::vector<ProgramCache::Stage> stages) {
+        auto &b    = *_build;
+        auto cache = Engine::instance().get_program_cache();
+        b.program  = glCreateProgram();
+        b.key      = cache->key(stages);
+        b.start    = std::chrono::steady_clock::now();
+        if (cache->load(b.program, b.key)) {
+            b.from_cache = true;
+            return;
         }
+
+        // No status queries here, they would wait for the compiler.
+        for (const auto &[type, src] : stages) {
+            const char *source = src.c_str();
+            const auto shader  = glCreateShader(type);
+            glShaderSource(shader, 1, &source, 0);
+            glCompileShader(shader);
+            glAttachShader(b.program, shader);
+            b.shaders.push_back(shader);
+        }
+        glProgramParameteri(b.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(b.program);
     }
 
+    void ShaderProgram::_poll(bool wait) {
+        if (_build == nullptr) { return; }
+        auto &b = *_build;
+
+        // Without a current program to fall back to, there is nothing to do but wait.
+        wait = wait || program_id == 0u;
+        if (b.sources.valid()) {
+            if (wait == false
+                && b.sources.wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+                return;
+            }
+            try {
+                _submit(b.sources.get());
+            } catch (std::runtime_error &error) {
+                std::cout << error.what() << '\n';
+                _build.reset();
+                return;
+            }
+        }
+        if (wait == false && has_parallel_compile()) {
+            GLint done{GL_FALSE};
+            glGetProgramiv(b.program, GL_COMPLETION_STATUS_KHR, &done);
+            if (done == GL_FALSE) { return; }
+        }
+
+        GLint linked{GL_FALSE};
+        glGetProgramiv(b.program, GL_LINK_STATUS, &linked);
+        std::string error;
+        if (linked == GL_FALSE) {
+            for (const auto shader : b.shaders) {
+                GLint compiled{GL_FALSE};
+                glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+                if (compiled == GL_FALSE) {
+                    error = std::string{"SHADER COMPILATION ERROR: \""}
+                                .append(info_log(shader, false))
+                                .append("\"");
+                    break;
+                }
+            }
+            if (error.empty()) {
+                error = std::string{"SHADER LINK ERROR: \""}
+                            .append(info_log(b.program, true))
+                            .append("\"");
+            }
+        } else if (b.from_cache == false) {
+            const auto ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - b.start)
+                                .count();
+            Engine::instance().get_program_cache()->store(b.program, b.key, ms);
+        }
+
+        for (const auto shader : b.shaders) { glDeleteShader(shader); }
+        const auto program = b.program;
+        _build.reset();
+
+        if (error.empty() == false) {
+            glDeleteProgram(program);
+            // Broken edits keep the program that was running, a first build has nothing to keep.
+            if (program_id == 0u) { throw std::runtime_error{error}; }
+            std::cout << error << '\n';
+            return;
+        }
+        glDeleteProgram(program_id);
+        program_id = program;
+        _load_uniforms();
+    }
+
+    // FNV-1a.
+    static uint64_t hash_name(std::string_view name) {
+        uint64_t hash{14695981039346656037ull};
+        for (const auto c : name) { hash = (hash ^ (uint8_t)c) * 1099511628211ull; }
+        return hash;
+    }
+
+    void ShaderProgram::_load_uniforms() {
+        _handle_locations.clear();
+        GLint count{0}, max_length{0};
+        glGetProgramInterfaceiv(program_id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+        glGetProgramInterfaceiv(program_id, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_length);
+        _frame_stats.introspection_calls += 2u;
+
+        // At most half full, arrays take two slots.
+        size_t slots{8u};
+        while (slots < 4u * (size_t)count) { slots *= 2u; }
+        _uniforms.assign(slots, Uniform{});
+
+        const auto insert = [this](std::string name, int32_t location) {
+            const auto hash = hash_name(name);
+            auto i          = hash & (_uniforms.size() - 1u);
+            while (_uniforms[i].name.empty() == false) { i = (i + 1u) & (_uniforms.size() - 1u); }
+            _uniforms[i] = Uniform{.hash = hash, .name = std::move(name), .location = location};
+        };
+
+        std::string name((size_t)std::max(max_length, 1), '\0');
+        for (auto i = 0; i < count; ++i) {
+            // Members of uniform blocks have no location.
+            const GLenum property{GL_LOCATION};
+            GLint location{-1}, length{0};
+            glGetProgramResourceiv(
+                program_id, GL_UNIFORM, (GLuint)i, 1, &property, 1, nullptr, &location);
+            _frame_stats.introspection_calls++;
+            if (location < 0) { continue; }
+            glGetProgramResourceName(
+                program_id, GL_UNIFORM, (GLuint)i, (GLsizei)name.size(), &length, name.data());
+            _frame_stats.introspection_calls++;
+
+            const std::string_view full{name.data(), (size_t)length};
+            if (full.ends_with("[0]")) {
+                insert(std::string{full.substr(0, full.size() - 3u)}, location);
+            }
+            insert(std::string{full}, location);
+        }
+    }
+
+    int32_t ShaderProgram::_location(std::string_view name) const {
+        if (_uniforms.empty()) { return -1; }
+        const auto hash = hash_name(name);
+        auto i          = hash & (_uniforms.size() - 1u);
+        while (_uniforms[i].name.empty() == false) {
+            if (_uniforms[i].hash == hash && _uniforms[i].name == name) {
+                return _uniforms[i].location;
+            }
+            i = (i + 1u) & (_uniforms.size() - 1u);
+        }
+        return -1;
+    }
+
+    // Names of UniformHandle ids, shared by all programs.
+    static std::vector<std::string> &handle_names() {
+        static std::vector<std::string> names;
+        return names;
+    }
+
+    uint32_t ShaderProgram::uniform_id(std::string_view name) {
+        auto &names  = handle_names();
+        const auto i = std::find(names.begin(), names.end(), name);
+        if (i != names.end()) { return (uint32_t)(i - names.begin()); }
+        names.emplace_back(name);
+        return (uint32_t)names.size() - 1u;
+    }
+
+    int32_t ShaderProgram::_location(uint32_t id) {
+        if (id >= _handle_locations.size()) {
+            _handle_locations.resize(handle_names().size(), UNRESOLVED);
+        }
+        auto &location = _handle_locations[id];
+        if (location == UNRESOLVED) { location = _location(handle_names()[id]); }
+        return location;
+    }
+
+    ShaderProgram::UniformStats ShaderProgram::_frame_stats, ShaderProgram::_last_frame_stats;
+
+    void ShaderProgram::next_frame() { _last_frame_stats = std::exchange(_frame_stats, {}); }
+
     ShaderProgram::ShaderProgram(const ShaderProgram &s) noexcept { *this = s; }
 
     ShaderProgram::ShaderProgram(ShaderProgram &&s) noexcept { *this = std::move(s); }
 
     ShaderProgram &ShaderProgram::operator=(const ShaderProgram &s) noexcept {
-        id         = s.id;
-        program_id = s.program_id;
-        file_name  = s.file_name;
+        id                = s.id;
+        program_id        = s.program_id;
+        file_name         = s.file_name;
+        _uniforms         = s._uniforms;
+        _handle_locations = s._handle_locations;
         return *this;
     }
 
     ShaderProgram &ShaderProgram::operator=(ShaderProgram &&s) noexcept {
-        id           = s.id;
-        program_id   = s.program_id;
-        s.program_id = 0;
-        file_name    = std::move(s.file_name);
+        if (this == &s) { return *this; }
+        // Whatever this held is replaced, not handed over.
+        glDeleteProgram(program_id);
+        _drop_build();
+
+        id                = s.id;
+        program_id        = s.program_id;
+        s.program_id      = 0;
+        file_name         = std::move(s.file_name);
+        _build            = std::move(s._build);
+        _uniforms         = std::move(s._uniforms);
+        _handle_locations = std::move(s._handle_locations);
         return *this;
     }
 
     ShaderProgram::~ShaderProgram() {
         glDeleteProgram(program_id); 
+        _drop_build();
     }
 
-    void ShaderProgram::use() { glUseProgram(program_id); }
+    void ShaderProgram::use() {
+        _poll(false);
+        glUseProgram(program_id);
+    }
 
     void ShaderProgram::recompile() {
+        // A rebuild still running is dropped for the newer sources.
+        _drop_build();
+        _build = std::make_unique<Build>();
+        _build->sources
+            = Engine::instance().get_thread_pool()->submit([name = file_name] {
+                  return _read_stages(name);
+              });
+    }
 
-        glFinish();
-        glUseProgram(0);
-        try {
-            auto prog = ShaderProgram{file_name};
-            *this     = std::move(prog);
-        } catch (std::runtime_error &error) { std::cout << error.what(); }
+    void ShaderProgram::_drop_build() {
+        if (_build == nullptr) { return; }
+        for (const auto shader : _build->shaders) { glDeleteShader(shader); }
+        glDeleteProgram(_build->program);
+        _build.reset();
     }
 } // namespace eng
 
-static unsigned compile_shader(const std::string &path, unsigned type) {
-    uint32_t shader_id;
-
+static std::string read_source(const std::string &path) {
     std::ifstream file{path};
     if (!file.is_open()) {
         throw std::runtime_error{
@@ -131,22 +353,22 @@ static unsigned compile_shader(const std::string &path, unsigned type) {
 
     std::stringstream ss;
     ss << file.rdbuf();
+    return ss.str();
+}
 
-    const auto shader_source_str   = ss.str();
-    const char *shader_source_cstr = shader_source_str.c_str();
-
-    shader_id = glCreateShader(type);
-    glShaderSource(shader_id, 1, &shader_source_cstr, 0);
-    glCompileShader(shader_id);
-
-    int shader_info;
-    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &shader_info);
-
-    if (shader_info) return shader_id;
-
-    glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &shader_info);
-    char *log = new char[shader_info];
-    glGetShaderInfoLog(shader_id, shader_info, &shader_info, log);
-
-    throw std::runtime_error{std::string{"SHADER COMPILATION ERROR: \""}.append(log).append("\"")};
+// Info log of a shader or, with program set, a program object.
+static std::string info_log(unsigned object, bool program) {
+    int length{0};
+    if (program) {
+        glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length);
+    } else {
+        glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length);
+    }
+    std::string log((size_t)std::max(length, 1), '\0');
+    if (program) {
+        glGetProgramInfoLog(object, length, &length, log.data());
+    } else {
+        glGetShaderInfoLog(object, length, &length, log.data());
+    }
+    return log.c_str();
 }
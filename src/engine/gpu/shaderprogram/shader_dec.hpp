@@ -9,12 +9,26 @@
 #include <memory>
 #include <functional>
 #include <utility>
+#include <span>
+
+#include <future>
+#include <chrono>
 
 #include <engine/types/idresource.hpp>
+#include <engine/gpu/shaderprogram/program_cache.hpp>
 #include <glm/glm.hpp>
 
 
 namespace eng {
+    // What set() uploads. Spans are vec4 arrays, set through the name of the array.
+    template <typename T>
+    concept UniformValue = std::is_integral_v<T> || std::is_floating_point_v<T>
+                           || std::is_same_v<T, glm::vec2> || std::is_same_v<T, glm::vec3>
+                           || std::is_same_v<T, glm::vec4> || std::is_same_v<T, glm::mat4>
+                           || std::is_same_v<T, std::span<const glm::vec4>>;
+
+    template <UniformValue T> struct UniformHandle;
+
     class ShaderProgram : public IdResource<ShaderProgram> {
       public:
         ShaderProgram() = default;
@@ -29,34 +43,85 @@ namespace eng {
         bool operator==(const ShaderProgram &other) const { return file_name == other.file_name; }
 
       public:
-        template <typename T>
-        requires std::is_integral_v<T>
-        void set(std::string_view name, const T &t);
-        template <typename T>
-        requires std::is_floating_point_v<T>
-        void set(std::string_view name, const T &t);
-        template <typename T>
-        requires std::is_same_v<T, glm::vec2>
-        void set(std::string_view name, const T &t);
-        template <typename T>
-        requires std::is_same_v<T, glm::vec3>
-        void set(std::string_view name, const T &t);
-        template <typename T>
-        requires std::is_same_v<T, glm::vec4>
-        void set(std::string_view name, const T &t);
-        template <typename T>
-        requires std::is_same_v<T, glm::mat4>
-        void set(std::string_view name, const T &t);
+        template <UniformValue T> void set(std::string_view name, const T &t);
+        template <UniformValue T>
+        void set(UniformHandle<T> handle, const std::type_identity_t<T> &t);
 
       public:
+        // Swaps in a program built since, if the driver is done with it.
         void use();
+        // Rebuilds from the files on disk without waiting for it: files are read on the thread
+        // pool, then compiled and linked on the driver's threads where it has
+        // KHR_parallel_shader_compile. Until the new program is linked, use() keeps binding the
+        // current one, which also stays if the new one does not compile.
         void recompile();
+        // True while a build started by the constructor or recompile() is not swapped in yet.
+        bool is_compiling() const { return _build != nullptr; }
 
         auto get_handle() const { return program_id; }
 
+        // Uniform traffic of a frame. Before locations were cached every set() also called
+        // glGetUniformLocation, GL calls went up by one per set().
+        struct UniformStats {
+            uint32_t set_by_name{0u}, set_by_handle{0u};
+            // Calls reading the active uniforms of programs linked in the frame.
+            uint32_t introspection_calls{0u};
+
+            uint32_t gl_calls() const { return set_by_name + set_by_handle + introspection_calls; }
+            uint32_t gl_calls_uncached() const { return 2u * (set_by_name + set_by_handle); }
+        };
+        // Stats of the last full frame, next_frame() is called once at the end of each.
+        static const UniformStats &uniform_stats() { return _last_frame_stats; }
+        static void next_frame();
+
+        // Small id of a uniform name, the same for every program. See UniformHandle.
+        static uint32_t uniform_id(std::string_view name);
+
       private:
+        // Program built next to program_id. Constructors submit it right away, so programs
+        // created together compile in parallel and the first use() of each only waits for its
+        // own.
+        struct Build {
+            // Stages being read by recompile(), submitted once they are.
+            std::future<std::vector<ProgramCache::Stage>> sources;
+            unsigned program{0u};
+            std::vector<unsigned> shaders;
+            uint64_t key{0u};
+            bool from_cache{false};
+            std::chrono::steady_clock::time_point start;
+        };
+
+        static std::vector<ProgramCache::Stage> _read_stages(const std::string &file_name);
+        // Starts compiling and linking stages into _build, or loads its cached binary.
+        void _submit(std::vector<ProgramCache::Stage> stages);
+        // Swaps _build in once it is linked, waits for it if wait is set or there is no program
+        // yet. Compile errors of a first build are thrown, later ones are printed.
+        void _poll(bool wait);
+        // Deletes the shaders and program of a build still running, if any, and drops it.
+        void _drop_build();
+        // Reads the active uniforms of program_id into _uniforms.
+        void _load_uniforms();
+        int32_t _location(std::string_view name) const;
+        int32_t _location(uint32_t id);
+        template <UniformValue T> static void _upload(int32_t location, const T &t);
+
         unsigned program_id{0u};
         std::string file_name;
+        std::unique_ptr<Build> _build;
+
+        // Active uniforms of program_id by name, open addressing with linear probing over a power
+        // of two slots, empty names are free slots. Array uniforms are in as "name" and "name[0]".
+        struct Uniform {
+            uint64_t hash{0u};
+            std::string name;
+            int32_t location{-1};
+        };
+        std::vector<Uniform> _uniforms;
+        // Locations by UniformHandle id, looked up on first use after each link.
+        static constexpr int32_t UNRESOLVED{-2};
+        std::vector<int32_t> _handle_locations;
+        static UniformStats _frame_stats, _last_frame_stats;
+
         static inline const std::string SHADERS_DIR = "shaders/";
         enum class SHADER_TYPE : unsigned {
             VERTEX   = 1 << 0,
@@ -66,4 +131,12 @@ namespace eng {
             TESS_E   = 1 << 4,
         };
     };
+
+    // Uniform name turned into an id once, so setting it skips hashing the name. Handles are not
+    // tied to a program: each program looks the id up on first use and again after relinking.
+    template <UniformValue T> struct UniformHandle {
+        explicit UniformHandle(std::string_view name) : id{ShaderProgram::uniform_id(name)} {}
+
+        uint32_t id;
+    };
 } // namespace eng
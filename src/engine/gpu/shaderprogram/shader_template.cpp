@@ -3,32 +3,35 @@
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
 
-static unsigned get_uniform_location(std::string_view name, unsigned program) {
-    return glGetUniformLocation(program, name.data());
-}
-
 namespace eng {
-    template <typename T> requires std::is_integral_v<T>		void ShaderProgram::set(std::string_view name, const T &t) {
-        glUniform1iv(get_uniform_location(name, program_id), 1, &t);
-    }
-
-    template <typename T> requires std::is_floating_point_v<T>	void ShaderProgram::set(std::string_view name, const T &t) {
-        glUniform1fv(get_uniform_location(name, program_id), 1, &t);
-    }
-
-    template<typename T> requires std::is_same_v<T, glm::vec2> void ShaderProgram::set(std::string_view name, const T &t) {
-        glUniform2fv(get_uniform_location(name, program_id), 1, glm::value_ptr(t));
-    }
-
-    template <typename T> requires std::is_same_v<T, glm::vec3> void ShaderProgram::set(std::string_view name, const T &t) {
-        glUniform3fv(get_uniform_location(name, program_id), 1, glm::value_ptr(t));
+    template <UniformValue T> void ShaderProgram::set(std::string_view name, const T &t) {
+        _frame_stats.set_by_name++;
+        _upload(_location(name), t);
     }
 
-    template <typename T> requires std::is_same_v<T, glm::vec4> void ShaderProgram::set(std::string_view name, const T &t) {
-        glUniform4fv(get_uniform_location(name, program_id), 1, glm::value_ptr(t));
+    template <UniformValue T>
+    void ShaderProgram::set(UniformHandle<T> handle, const std::type_identity_t<T> &t) {
+        _frame_stats.set_by_handle++;
+        _upload(_location(handle.id), t);
     }
 
-    template <typename T> requires std::is_same_v<T, glm::mat4>	void ShaderProgram::set(std::string_view name, const T &t) {
-        glUniformMatrix4fv(get_uniform_location(name, program_id), 1, GL_FALSE, glm::value_ptr(t));
+    template <UniformValue T> void ShaderProgram::_upload(int32_t location, const T &t) {
+        if constexpr (std::is_integral_v<T>) {
+            const auto value = (GLint)t;
+            glUniform1iv(location, 1, &value);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            const auto value = (GLfloat)t;
+            glUniform1fv(location, 1, &value);
+        } else if constexpr (std::is_same_v<T, glm::vec2>) {
+            glUniform2fv(location, 1, glm::value_ptr(t));
+        } else if constexpr (std::is_same_v<T, glm::vec3>) {
+            glUniform3fv(location, 1, glm::value_ptr(t));
+        } else if constexpr (std::is_same_v<T, glm::vec4>) {
+            glUniform4fv(location, 1, glm::value_ptr(t));
+        } else if constexpr (std::is_same_v<T, glm::mat4>) {
+            glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(t));
+        } else {
+            glUniform4fv(location, (GLsizei)t.size(), reinterpret_cast<const GLfloat *>(t.data()));
+        }
     }
-}
\ No newline at end of file
+} // namespace eng
@@ -0,0 +1,600 @@
+#include "block_compression.hpp"
+
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include <glad/glad.h>
+
+// EXT_texture_compression_s3tc is not core, so glad leaves it out, but every desktop driver has it.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+#include <engine/types/thread_pool.hpp>
+
+// SSE2 is part of every x86-64 CPU, so unlike culling.cpp's AVX path it needs no runtime check.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ENG_BC_X86
+#include <emmintrin.h>
+#endif
+
+namespace eng::block_compression {
+    // Texels of a block channel by channel, so SIMD loads the same channel of 4 texels at once.
+    // Channels past the ones a format stores are 0 and drop out of every distance.
+    struct BlockSoA {
+        alignas(16) float c[4][16];
+    };
+
+    static BlockSoA to_soa(const uint8_t *rgba, uint32_t channels) {
+        BlockSoA b{};
+        for (auto t = 0u; t < 16u; ++t) {
+            for (auto c = 0u; c < channels; ++c) { b.c[c][t] = (float)rgba[t * 4u + c]; }
+        }
+        return b;
+    }
+
+    // Index of the closest palette entry for every texel, returns the summed squared distance.
+    static float nearest_scalar(const BlockSoA &b,
+                                const float (*palette)[4],
+                                uint32_t count,
+                                uint8_t *indices) {
+        float error{0.f};
+        for (auto t = 0u; t < 16u; ++t) {
+            float best{FLT_MAX};
+            for (auto k = 0u; k < count; ++k) {
+                float d{0.f};
+                for (auto c = 0u; c < 4u; ++c) {
+                    const auto x = b.c[c][t] - palette[k][c];
+                    d += x * x;
+                }
+                if (d < best) {
+                    best       = d;
+                    indices[t] = (uint8_t)k;
+                }
+            }
+            error += best;
+        }
+        return error;
+    }
+
+#ifdef ENG_BC_X86
+    // Same result as nearest_scalar(), distances are sums of squared integers and exact.
+    static float nearest_sse(const BlockSoA &b,
+                             const float (*palette)[4],
+                             uint32_t count,
+                             uint8_t *indices) {
+        __m128 total = _mm_setzero_ps();
+        for (auto t = 0u; t < 16u; t += 4u) {
+            const __m128 texels[4]{_mm_load_ps(&b.c[0][t]),
+                                   _mm_load_ps(&b.c[1][t]),
+                                   _mm_load_ps(&b.c[2][t]),
+                                   _mm_load_ps(&b.c[3][t])};
+            __m128 best   = _mm_set1_ps(FLT_MAX);
+            __m128i index = _mm_setzero_si128();
+            for (auto k = 0u; k < count; ++k) {
+                __m128 d = _mm_setzero_ps();
+                for (auto c = 0u; c < 4u; ++c) {
+                    const auto x = _mm_sub_ps(texels[c], _mm_set1_ps(palette[k][c]));
+                    d            = _mm_add_ps(d, _mm_mul_ps(x, x));
+                }
+                const auto closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+                best              = _mm_min_ps(d, best);
+                index             = _mm_or_si128(_mm_andnot_si128(closer, index),
+                                                 _mm_and_si128(closer, _mm_set1_epi32((int)k)));
+            }
+            total = _mm_add_ps(total, best);
+
+            alignas(16) int32_t lanes[4];
+            _mm_store_si128((__m128i *)lanes, index);
+            for (auto i = 0u; i < 4u; ++i) { indices[t + i] = (uint8_t)lanes[i]; }
+        }
+        alignas(16) float sums[4];
+        _mm_store_ps(sums, total);
+        return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    }
+#endif
+
+    static float nearest(const BlockSoA &b,
+                         const float (*palette)[4],
+                         uint32_t count,
+                         uint8_t *indices) {
+#ifdef ENG_BC_X86
+        return nearest_sse(b, palette, count, indices);
+#else
+        return nearest_scalar(b, palette, count, indices);
+#endif
+    }
+
+    float nearest_scalar(const uint8_t *rgba,
+                         const float (*palette)[4],
+                         uint32_t count,
+                         uint8_t *indices) {
+        return nearest_scalar(to_soa(rgba, 4u), palette, count, indices);
+    }
+
+    float nearest_sse(const uint8_t *rgba,
+                      const float (*palette)[4],
+                      uint32_t count,
+                      uint8_t *indices) {
+#ifdef ENG_BC_X86
+        return nearest_sse(to_soa(rgba, 4u), palette, count, indices);
+#else
+        return nearest_scalar(to_soa(rgba, 4u), palette, count, indices);
+#endif
+    }
+
+    // Endpoints of the line through the texels' mean along their direction of largest variance,
+    // cut at the outermost texels.
+    static void fit_line(const BlockSoA &b, uint32_t channels, float *lo, float *hi) {
+        float mean[4]{}, cov[4][4]{}, axis[4]{};
+        for (auto c = 0u; c < channels; ++c) {
+            float min{255.f}, max{0.f};
+            for (auto t = 0u; t < 16u; ++t) {
+                mean[c] += b.c[c][t];
+                min = std::min(min, b.c[c][t]);
+                max = std::max(max, b.c[c][t]);
+            }
+            mean[c] /= 16.f;
+            axis[c] = max - min;
+        }
+        for (auto t = 0u; t < 16u; ++t) {
+            for (auto c = 0u; c < channels; ++c) {
+                for (auto d = 0u; d < channels; ++d) {
+                    cov[c][d] += (b.c[c][t] - mean[c]) * (b.c[d][t] - mean[d]);
+                }
+            }
+        }
+
+        // Power iteration, starting from the bounding box diagonal.
+        for (auto i = 0u; i < 8u; ++i) {
+            float next[4]{}, len{0.f};
+            for (auto c = 0u; c < channels; ++c) {
+                for (auto d = 0u; d < channels; ++d) { next[c] += cov[c][d] * axis[d]; }
+                len += next[c] * next[c];
+            }
+            if (len <= 0.f) { break; }
+            len = 1.f / std::sqrt(len);
+            for (auto c = 0u; c < channels; ++c) { axis[c] = next[c] * len; }
+        }
+
+        float tmin{0.f}, tmax{0.f};
+        for (auto t = 0u; t < 16u; ++t) {
+            float proj{0.f};
+            for (auto c = 0u; c < channels; ++c) { proj += (b.c[c][t] - mean[c]) * axis[c]; }
+            tmin = std::min(tmin, proj);
+            tmax = std::max(tmax, proj);
+        }
+        for (auto c = 0u; c < channels; ++c) {
+            lo[c] = std::clamp(mean[c] + tmin * axis[c], 0.f, 255.f);
+            hi[c] = std::clamp(mean[c] + tmax * axis[c], 0.f, 255.f);
+        }
+    }
+
+    // Least squares endpoints for fixed indices, texel t decoding to
+    //   e0 * (1 - weights[indices[t]]) + e1 * weights[indices[t]].
+    // False if every texel uses the same weight and there is nothing to solve.
+    static bool refine(const BlockSoA &b,
+                       const uint8_t *indices,
+                       const float *weights,
+                       uint32_t channels,
+                       float *e0,
+                       float *e1) {
+        float aa{0.f}, ab{0.f}, bb{0.f}, x0[4]{}, x1[4]{};
+        for (auto t = 0u; t < 16u; ++t) {
+            const auto w = weights[indices[t]], iw = 1.f - w;
+            aa += iw * iw;
+            ab += iw * w;
+            bb += w * w;
+            for (auto c = 0u; c < channels; ++c) {
+                x0[c] += iw * b.c[c][t];
+                x1[c] += w * b.c[c][t];
+            }
+        }
+        const auto det = aa * bb - ab * ab;
+        if (std::abs(det) < 1e-6f) { return false; }
+
+        for (auto c = 0u; c < channels; ++c) {
+            e0[c] = std::clamp((bb * x0[c] - ab * x1[c]) / det, 0.f, 255.f);
+            e1[c] = std::clamp((aa * x1[c] - ab * x0[c]) / det, 0.f, 255.f);
+        }
+        return true;
+    }
+
+    // Writes fields low bit first, the bit order of BC7. out must be zeroed.
+    struct BitWriter {
+        void put(uint32_t value, uint32_t count) {
+            for (auto i = 0u; i < count; ++i, ++bit) {
+                out[bit >> 3u] |= (uint8_t)(((value >> i) & 1u) << (bit & 7u));
+            }
+        }
+        uint8_t *out;
+        uint32_t bit{0u};
+    };
+
+    struct BitReader {
+        uint32_t get(uint32_t count) {
+            uint32_t value{0u};
+            for (auto i = 0u; i < count; ++i, ++bit) {
+                value |= (uint32_t)((in[bit >> 3u] >> (bit & 7u)) & 1u) << i;
+            }
+            return value;
+        }
+        const uint8_t *in;
+        uint32_t bit{0u};
+    };
+
+    // BC1 ----------------------------------------------------------------------------------------
+
+    static uint16_t to_565(const float *c) {
+        return (uint16_t)(std::lround(c[0] * 31.f / 255.f) << 11u
+                          | std::lround(c[1] * 63.f / 255.f) << 5u
+                          | std::lround(c[2] * 31.f / 255.f));
+    }
+
+    static void from_565(uint16_t v, float *c) {
+        const auto r = (v >> 11u) & 31u, g = (v >> 5u) & 63u, b = v & 31u;
+        c[0] = (float)((r << 3u) | (r >> 2u));
+        c[1] = (float)((g << 2u) | (g >> 4u));
+        c[2] = (float)((b << 3u) | (b >> 2u));
+        c[3] = 0.f;
+    }
+
+    // Four color mode palette, the one used when c0 > c1 and always in BC3.
+    static void bc1_palette(uint16_t c0, uint16_t c1, float (*palette)[4]) {
+        from_565(c0, palette[0]);
+        from_565(c1, palette[1]);
+        for (auto c = 0u; c < 3u; ++c) {
+            palette[2][c] = std::floor((2.f * palette[0][c] + palette[1][c]) / 3.f);
+            palette[3][c] = std::floor((palette[0][c] + 2.f * palette[1][c]) / 3.f);
+        }
+        palette[2][3] = palette[3][3] = 0.f;
+    }
+
+    static float encode_bc1_color(const BlockSoA &b, uint8_t *out) {
+        // Position of every palette entry between c0 and c1.
+        static constexpr float weights[4]{0.f, 1.f, 1.f / 3.f, 2.f / 3.f};
+
+        float e0[4]{}, e1[4]{};
+        fit_line(b, 3u, e1, e0);
+
+        float best{FLT_MAX};
+        uint16_t best_c0{0u}, best_c1{0u};
+        uint8_t best_indices[16]{}, indices[16]{};
+        for (auto i = 0u; i < 2u; ++i) {
+            auto c0 = to_565(e0), c1 = to_565(e1);
+            if (c0 < c1) {
+                std::swap(c0, c1);
+                std::swap(e0, e1);
+            }
+            float palette[4][4];
+            bc1_palette(c0, c1, palette);
+            // Equal endpoints would switch decoders to three color mode, index 0 is the same in
+            // both.
+            const auto error = nearest(b, palette, c0 == c1 ? 1u : 4u, indices);
+            if (error < best) {
+                best    = error;
+                best_c0 = c0;
+                best_c1 = c1;
+                memcpy(best_indices, indices, 16u);
+            }
+            if (error == 0.f || refine(b, indices, weights, 3u, e0, e1) == false) { break; }
+        }
+
+        uint32_t bits{0u};
+        for (auto t = 0u; t < 16u; ++t) { bits |= (uint32_t)best_indices[t] << (t * 2u); }
+        memcpy(out, &best_c0, 2u);
+        memcpy(out + 2u, &best_c1, 2u);
+        memcpy(out + 4u, &bits, 4u);
+        return best;
+    }
+
+    static void decode_bc1_color(const uint8_t *in, uint8_t *rgba, bool four_colors) {
+        uint16_t c0, c1;
+        uint32_t bits;
+        memcpy(&c0, in, 2u);
+        memcpy(&c1, in + 2u, 2u);
+        memcpy(&bits, in + 4u, 4u);
+
+        float palette[4][4];
+        bc1_palette(c0, c1, palette);
+        palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255.f;
+        if (four_colors == false && c0 <= c1) {
+            for (auto c = 0u; c < 3u; ++c) {
+                palette[2][c] = std::floor((palette[0][c] + palette[1][c]) / 2.f);
+                palette[3][c] = 0.f;
+            }
+            palette[3][3] = 0.f;
+        }
+        for (auto t = 0u; t < 16u; ++t) {
+            const auto &p = palette[(bits >> (t * 2u)) & 3u];
+            for (auto c = 0u; c < 4u; ++c) { rgba[t * 4u + c] = (uint8_t)p[c]; }
+        }
+    }
+
+    // BC4 ----------------------------------------------------------------------------------------
+
+    static float encode_bc4_channel(const BlockSoA &b, uint32_t channel, uint8_t *out) {
+        BlockSoA one{};
+        memcpy(one.c[0], b.c[channel], sizeof(one.c[0]));
+        const auto [min, max] = std::minmax_element(one.c[0], one.c[0] + 16u);
+
+        // Eight value mode, e0 > e1: both endpoints and six steps between them.
+        const auto e0 = (uint8_t)*max, e1 = (uint8_t)*min;
+        float palette[8][4]{};
+        palette[0][0] = e0;
+        palette[1][0] = e1;
+        for (auto i = 2u; i < 8u; ++i) {
+            palette[i][0] = std::round(((8.f - i) * e0 + (i - 1.f) * e1) / 7.f);
+        }
+
+        uint8_t indices[16];
+        const auto error = nearest(one, palette, e0 == e1 ? 1u : 8u, indices);
+
+        uint64_t bits{0u};
+        for (auto t = 0u; t < 16u; ++t) { bits |= (uint64_t)indices[t] << (t * 3u); }
+        out[0] = e0;
+        out[1] = e1;
+        for (auto i = 0u; i < 6u; ++i) { out[2u + i] = (uint8_t)(bits >> (i * 8u)); }
+        return error;
+    }
+
+    static void decode_bc4_channel(const uint8_t *in, uint8_t *rgba, uint32_t channel) {
+        const float e0 = in[0], e1 = in[1];
+        float palette[8]{e0, e1};
+        if (e0 > e1) {
+            for (auto i = 2u; i < 8u; ++i) {
+                palette[i] = std::round(((8.f - i) * e0 + (i - 1.f) * e1) / 7.f);
+            }
+        } else {
+            for (auto i = 2u; i < 6u; ++i) {
+                palette[i] = std::round(((6.f - i) * e0 + (i - 1.f) * e1) / 5.f);
+            }
+            palette[6] = 0.f;
+            palette[7] = 255.f;
+        }
+
+        uint64_t bits{0u};
+        for (auto i = 0u; i < 6u; ++i) { bits |= (uint64_t)in[2u + i] << (i * 8u); }
+        for (auto t = 0u; t < 16u; ++t) {
+            rgba[t * 4u + channel] = (uint8_t)palette[(bits >> (t * 3u)) & 7u];
+        }
+    }
+
+    // BC7 mode 6 ---------------------------------------------------------------------------------
+
+    static constexpr uint32_t bc7_weights[16]{
+        0u, 4u, 9u, 13u, 17u, 21u, 26u, 30u, 34u, 38u, 43u, 47u, 51u, 55u, 60u, 64u};
+
+    static void bc7_palette(const uint32_t (*endpoints)[4], float (*palette)[4]) {
+        for (auto k = 0u; k < 16u; ++k) {
+            for (auto c = 0u; c < 4u; ++c) {
+                palette[k][c] = (float)(((64u - bc7_weights[k]) * endpoints[0][c]
+                                         + bc7_weights[k] * endpoints[1][c] + 32u)
+                                        >> 6u);
+            }
+        }
+    }
+
+    // Single subset RGBA: a good fit for anything that is not a hard edge between two colors,
+    // and the only mode simple enough to search exhaustively over its p-bits.
+    static float encode_bc7_mode6(const BlockSoA &b, uint8_t *out) {
+        static const auto weights = [] {
+            std::array<float, 16> w;
+            for (auto k = 0u; k < 16u; ++k) { w[k] = bc7_weights[k] / 64.f; }
+            return w;
+        }();
+
+        float e[2][4];
+        fit_line(b, 4u, e[0], e[1]);
+
+        float best{FLT_MAX};
+        uint32_t best_q[2][4]{}, best_p[2]{};
+        uint8_t best_indices[16]{}, indices[16];
+        for (auto i = 0u; i < 3u; ++i) {
+            for (auto p = 0u; p < 4u; ++p) {
+                // 7 bits per channel and a p-bit shared by the 4 channels of the endpoint, tried
+                // both ways for both endpoints.
+                const uint32_t pbits[2]{p & 1u, p >> 1u};
+                uint32_t q[2][4], endpoints[2][4];
+                for (auto n = 0u; n < 2u; ++n) {
+                    for (auto c = 0u; c < 4u; ++c) {
+                        q[n][c] = (uint32_t)std::clamp(
+                            std::lround((e[n][c] - (float)pbits[n]) / 2.f), 0l, 127l);
+                        endpoints[n][c] = q[n][c] << 1u | pbits[n];
+                    }
+                }
+                float palette[16][4];
+                bc7_palette(endpoints, palette);
+                const auto error = nearest(b, palette, 16u, indices);
+                if (error < best) {
+                    best = error;
+                    memcpy(best_q, q, sizeof(q));
+                    memcpy(best_p, pbits, sizeof(pbits));
+                    memcpy(best_indices, indices, 16u);
+                }
+            }
+            if (best == 0.f || refine(b, best_indices, weights.data(), 4u, e[0], e[1]) == false) {
+                break;
+            }
+        }
+
+        // The first index has an implied top bit of 0, swapping the endpoints makes it so.
+        if (best_indices[0] & 8u) {
+            std::swap(best_q[0], best_q[1]);
+            std::swap(best_p[0], best_p[1]);
+            for (auto &index : best_indices) { index = 15u - index; }
+        }
+
+        memset(out, 0, 16u);
+        BitWriter w{out};
+        w.put(1u << 6u, 7u);
+        for (auto c = 0u; c < 4u; ++c) {
+            w.put(best_q[0][c], 7u);
+            w.put(best_q[1][c], 7u);
+        }
+        w.put(best_p[0], 1u);
+        w.put(best_p[1], 1u);
+        w.put(best_indices[0], 3u);
+        for (auto t = 1u; t < 16u; ++t) { w.put(best_indices[t], 4u); }
+        return best;
+    }
+
+    static void decode_bc7(const uint8_t *in, uint8_t *rgba) {
+        BitReader r{in};
+        // Only mode 6 is decoded, anything else comes out magenta.
+        if (r.get(7u) != 1u << 6u) {
+            for (auto t = 0u; t < 16u; ++t) {
+                const uint8_t magenta[4]{255u, 0u, 255u, 255u};
+                memcpy(&rgba[t * 4u], magenta, 4u);
+            }
+            return;
+        }
+
+        uint32_t endpoints[2][4];
+        for (auto c = 0u; c < 4u; ++c) {
+            endpoints[0][c] = r.get(7u) << 1u;
+            endpoints[1][c] = r.get(7u) << 1u;
+        }
+        for (auto n = 0u; n < 2u; ++n) {
+            const auto p = r.get(1u);
+            for (auto c = 0u; c < 4u; ++c) { endpoints[n][c] |= p; }
+        }
+        float palette[16][4];
+        bc7_palette(endpoints, palette);
+        for (auto t = 0u; t < 16u; ++t) {
+            const auto &p = palette[r.get(t == 0u ? 3u : 4u)];
+            for (auto c = 0u; c < 4u; ++c) { rgba[t * 4u + c] = (uint8_t)p[c]; }
+        }
+    }
+
+    // --------------------------------------------------------------------------------------------
+
+    uint32_t gl_format(BlockFormat format) {
+        switch (format) {
+        case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+        case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+        case BlockFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        }
+        return 0u;
+    }
+
+    uint32_t gl_block_size(uint32_t gl_format) {
+        switch (gl_format) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RED_RGTC1: return 8u;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RG_RGTC2:
+        case GL_COMPRESSED_RGBA_BPTC_UNORM: return 16u;
+        default: return 0u;
+        }
+    }
+
+    BlockFormat format_for(TextureType type) {
+        switch (type) {
+        case TextureType::Normal: return BlockFormat::BC5;
+        case TextureType::Metallic:
+        case TextureType::Roughness: return BlockFormat::BC4;
+        case TextureType::Emissive: return BlockFormat::BC1;
+        default: return BlockFormat::BC7;
+        }
+    }
+
+    uint32_t encode_block(BlockFormat format, const uint8_t *rgba, uint8_t *out) {
+        float error{0.f};
+        switch (format) {
+        case BlockFormat::BC1: error = encode_bc1_color(to_soa(rgba, 3u), out); break;
+        case BlockFormat::BC3: {
+            const auto b = to_soa(rgba, 4u);
+            error        = encode_bc4_channel(b, 3u, out);
+            auto color   = b;
+            std::fill_n(color.c[3], 16u, 0.f);
+            error += encode_bc1_color(color, out + 8u);
+        } break;
+        case BlockFormat::BC4: error = encode_bc4_channel(to_soa(rgba, 1u), 0u, out); break;
+        case BlockFormat::BC5: {
+            const auto b = to_soa(rgba, 2u);
+            error        = encode_bc4_channel(b, 0u, out) + encode_bc4_channel(b, 1u, out + 8u);
+        } break;
+        case BlockFormat::BC7: error = encode_bc7_mode6(to_soa(rgba, 4u), out); break;
+        }
+        return (uint32_t)error;
+    }
+
+    void decode_block(BlockFormat format, const uint8_t *block, uint8_t *rgba) {
+        if (format == BlockFormat::BC4 || format == BlockFormat::BC5) {
+            for (auto t = 0u; t < 16u; ++t) {
+                const uint8_t black[4]{0u, 0u, 0u, 255u};
+                memcpy(&rgba[t * 4u], black, 4u);
+            }
+        }
+        switch (format) {
+        case BlockFormat::BC1: decode_bc1_color(block, rgba, false); break;
+        case BlockFormat::BC3:
+            decode_bc1_color(block + 8u, rgba, true);
+            decode_bc4_channel(block, rgba, 3u);
+            break;
+        case BlockFormat::BC4: decode_bc4_channel(block, rgba, 0u); break;
+        case BlockFormat::BC5:
+            decode_bc4_channel(block, rgba, 0u);
+            decode_bc4_channel(block + 8u, rgba, 1u);
+            break;
+        case BlockFormat::BC7: decode_bc7(block, rgba); break;
+        }
+    }
+
+    std::vector<uint8_t> encode(BlockFormat format,
+                                const uint8_t *rgba,
+                                uint32_t width,
+                                uint32_t height,
+                                ThreadPool *pool) {
+        const auto blocks_x = (width + 3u) / 4u, blocks_y = (height + 3u) / 4u;
+        const auto size     = block_size(format);
+        std::vector<uint8_t> out(level_size(format, width, height));
+
+        const auto encode_row = [&](uint32_t y) {
+            uint8_t texels[64];
+            for (auto x = 0u; x < blocks_x; ++x) {
+                for (auto t = 0u; t < 16u; ++t) {
+                    const auto tx = std::min(x * 4u + t % 4u, width - 1u);
+                    const auto ty = std::min(y * 4u + t / 4u, height - 1u);
+                    memcpy(&texels[t * 4u], &rgba[((size_t)ty * width + tx) * 4u], 4u);
+                }
+                encode_block(format, texels, &out[((size_t)y * blocks_x + x) * size]);
+            }
+        };
+        if (pool != nullptr) {
+            pool->parallel_for(blocks_y, encode_row);
+        } else {
+            for (auto y = 0u; y < blocks_y; ++y) { encode_row(y); }
+        }
+        return out;
+    }
+
+    std::vector<uint8_t> decode(BlockFormat format,
+                                const uint8_t *blocks,
+                                uint32_t width,
+                                uint32_t height) {
+        const auto blocks_x = (width + 3u) / 4u, blocks_y = (height + 3u) / 4u;
+        std::vector<uint8_t> rgba((size_t)width * height * 4u);
+        uint8_t texels[64];
+        for (auto y = 0u; y < blocks_y; ++y) {
+            for (auto x = 0u; x < blocks_x; ++x) {
+                const auto block = &blocks[((size_t)y * blocks_x + x) * block_size(format)];
+                decode_block(format, block, texels);
+                for (auto t = 0u; t < 16u; ++t) {
+                    const auto tx = x * 4u + t % 4u, ty = y * 4u + t / 4u;
+                    if (tx >= width || ty >= height) { continue; }
+                    memcpy(&rgba[((size_t)ty * width + tx) * 4u], &texels[t * 4u], 4u);
+                }
+            }
+        }
+        return rgba;
+    }
+} // namespace eng::block_compression
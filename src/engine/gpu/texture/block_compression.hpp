@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include <engine/gpu/texture/texture.hpp>
+
+namespace eng {
+    class ThreadPool;
+
+    // CPU encoder for the BCn formats every GL 4.2+ desktop driver samples natively. Runs offline
+    // in texture_baker, the engine itself only uploads what it wrote. Blocks are 4x4 texels, every
+    // encode/decode function takes and returns them as 64 bytes of row major RGBA8.
+    namespace block_compression {
+        enum class BlockFormat : uint32_t {
+            BC1, // RGB 5:6:5 endpoints, 2 bit indices, 4 bpp
+            BC3, // BC1 color and a BC4 alpha block, 8 bpp
+            BC4, // one 8 bit channel, 3 bit indices, 4 bpp
+            BC5, // two BC4 blocks for R and G, 8 bpp
+            BC7, // only mode 6: RGBA 7.7.7.7 + p-bit endpoints, 4 bit indices, 8 bpp
+        };
+
+        // Bytes taken by a 4x4 block.
+        constexpr uint32_t block_size(BlockFormat format) {
+            return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8u : 16u;
+        }
+        // Channels the format stores, from red on.
+        constexpr uint32_t channel_count(BlockFormat format) {
+            constexpr uint32_t channels[]{3u, 4u, 1u, 2u, 4u};
+            return channels[(uint32_t)format];
+        }
+        // Bytes taken by a w x h level, partial blocks at the edges included.
+        constexpr size_t level_size(BlockFormat format, uint32_t width, uint32_t height) {
+            return (size_t)((width + 3u) / 4u) * ((height + 3u) / 4u) * block_size(format);
+        }
+
+        // GL internal format to allocate storage with.
+        uint32_t gl_format(BlockFormat format);
+        // block_size() of a GL compressed internal format, 0 if it is not one of BlockFormat's.
+        uint32_t gl_block_size(uint32_t gl_format);
+        // Diffuse: BC7, normal: BC5 (z is rebuilt in the shader), metallic and roughness: BC4,
+        // emissive: BC1.
+        BlockFormat format_for(TextureType type);
+
+        // Returns the squared error of the block over the channels the format stores.
+        uint32_t encode_block(BlockFormat format, const uint8_t *rgba, uint8_t *out);
+        // Channels the format does not store come out as 0, alpha as 255.
+        void decode_block(BlockFormat format, const uint8_t *block, uint8_t *rgba);
+
+        // Index of the closest of count RGBA palette entries for every texel of a block, returns
+        // the summed squared distance. encode_block() searches with the SSE2 path on x86 and the
+        // scalar one elsewhere, both pick the same indices. Without SSE2, nearest_sse() is the
+        // scalar path.
+        float nearest_scalar(const uint8_t *rgba,
+                             const float (*palette)[4],
+                             uint32_t count,
+                             uint8_t *indices);
+        float nearest_sse(const uint8_t *rgba,
+                          const float (*palette)[4],
+                          uint32_t count,
+                          uint8_t *indices);
+
+        // Encodes an RGBA8 image of any size, edge blocks repeat the last row and column. Rows of
+        // blocks are spread over pool when one is given.
+        std::vector<uint8_t> encode(BlockFormat format,
+                                    const uint8_t *rgba,
+                                    uint32_t width,
+                                    uint32_t height,
+                                    ThreadPool *pool = nullptr);
+        // Inverse of encode(), returns width * height RGBA8 texels.
+        std::vector<uint8_t> decode(BlockFormat format,
+                                    const uint8_t *blocks,
+                                    uint32_t width,
+                                    uint32_t height);
+    } // namespace block_compression
+} // namespace eng
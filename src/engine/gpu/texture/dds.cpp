@@ -0,0 +1,155 @@
+#include "dds.hpp"
+
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+
+namespace eng::dds {
+    using block_compression::BlockFormat;
+    using block_compression::level_size;
+
+    static constexpr uint32_t four_cc(char a, char b, char c, char d) {
+        return (uint32_t)a | (uint32_t)b << 8u | (uint32_t)c << 16u | (uint32_t)d << 24u;
+    }
+
+    static constexpr uint32_t MAGIC{four_cc('D', 'D', 'S', ' ')};
+
+    struct PixelFormat {
+        uint32_t size{sizeof(PixelFormat)};
+        uint32_t flags{0x4u}; // DDPF_FOURCC
+        uint32_t four_cc{0u};
+        uint32_t rgb_bit_count{0u};
+        uint32_t masks[4]{};
+    };
+
+    struct Header {
+        uint32_t size{sizeof(Header)};
+        // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT |
+        // DDSD_LINEARSIZE
+        uint32_t flags{0x1u | 0x2u | 0x4u | 0x1000u | 0x20000u | 0x80000u};
+        uint32_t height{0u}, width{0u};
+        uint32_t linear_size{0u};
+        uint32_t depth{0u};
+        uint32_t mip_count{0u};
+        uint32_t _reserved[11]{};
+        PixelFormat pixel_format;
+        // DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+        uint32_t caps{0x1000u | 0x8u | 0x400000u};
+        uint32_t caps2{0u}, caps3{0u}, caps4{0u};
+        uint32_t _reserved2{0u};
+    };
+    static_assert(sizeof(Header) == 124u);
+
+    struct HeaderDX10 {
+        uint32_t dxgi_format{0u};
+        uint32_t dimension{3u}; // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+        uint32_t misc_flag{0u};
+        uint32_t array_size{1u};
+        uint32_t misc_flags2{0u};
+    };
+
+    // DXGI_FORMAT_*_UNORM.
+    static uint32_t dxgi_format(BlockFormat format) {
+        switch (format) {
+        case BlockFormat::BC1: return 71u;
+        case BlockFormat::BC3: return 77u;
+        case BlockFormat::BC4: return 80u;
+        case BlockFormat::BC5: return 83u;
+        case BlockFormat::BC7: return 98u;
+        }
+        return 0u;
+    }
+
+    // The _SRGB variants are the UNORM values + 1, there is no BC4 and BC5 sRGB.
+    static bool from_dxgi(uint32_t dxgi, BlockFormat &format) {
+        switch (dxgi) {
+        case 71u:
+        case 72u: format = BlockFormat::BC1; return true;
+        case 77u:
+        case 78u: format = BlockFormat::BC3; return true;
+        case 80u: format = BlockFormat::BC4; return true;
+        case 83u: format = BlockFormat::BC5; return true;
+        case 98u:
+        case 99u: format = BlockFormat::BC7; return true;
+        default: return false;
+        }
+    }
+
+    static bool from_four_cc(uint32_t code, BlockFormat &format) {
+        if (code == four_cc('D', 'X', 'T', '1')) {
+            format = BlockFormat::BC1;
+        } else if (code == four_cc('D', 'X', 'T', '5')) {
+            format = BlockFormat::BC3;
+        } else if (code == four_cc('A', 'T', 'I', '1') || code == four_cc('B', 'C', '4', 'U')) {
+            format = BlockFormat::BC4;
+        } else if (code == four_cc('A', 'T', 'I', '2') || code == four_cc('B', 'C', '5', 'U')) {
+            format = BlockFormat::BC5;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool write(const std::filesystem::path &path, const Image &image) {
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        if (out.is_open() == false) {
+            fprintf(stderr, "Could not write %s\n", path.string().c_str());
+            return false;
+        }
+
+        Header h;
+        h.width                = image.width;
+        h.height               = image.height;
+        h.mip_count            = image.mip_count();
+        h.linear_size          = (uint32_t)level_size(image.format, image.width, image.height);
+        h.pixel_format.four_cc = four_cc('D', 'X', '1', '0');
+        const HeaderDX10 dx10{.dxgi_format = dxgi_format(image.format)};
+
+        out.write(reinterpret_cast<const char *>(&MAGIC), sizeof(MAGIC));
+        out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+        out.write(reinterpret_cast<const char *>(&dx10), sizeof(dx10));
+        out.write(reinterpret_cast<const char *>(image.data.data()),
+                  (std::streamsize)image.data.size());
+        return out.good();
+    }
+
+    bool read(const std::filesystem::path &path, Image &image) {
+        std::ifstream file{path, std::ios::binary};
+        if (file.is_open() == false) { return false; }
+
+        uint32_t magic{0u};
+        Header h;
+        file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+        file.read(reinterpret_cast<char *>(&h), sizeof(h));
+        if (file.good() == false || magic != MAGIC || h.size != sizeof(Header)) { return false; }
+
+        bool known{false};
+        if (h.pixel_format.four_cc == four_cc('D', 'X', '1', '0')) {
+            HeaderDX10 dx10;
+            file.read(reinterpret_cast<char *>(&dx10), sizeof(dx10));
+            known = file.good() && dx10.dimension == 3u && dx10.array_size == 1u
+                    && from_dxgi(dx10.dxgi_format, image.format);
+        } else {
+            known = from_four_cc(h.pixel_format.four_cc, image.format);
+        }
+        if (known == false || h.width == 0u || h.height == 0u) {
+            fprintf(stderr, "Unsupported DDS file: %s\n", path.string().c_str());
+            return false;
+        }
+
+        image.width  = h.width;
+        image.height = h.height;
+        image.mip_offsets.clear();
+        const auto mips = std::max(h.mip_count, 1u);
+        size_t size{0u};
+        for (auto i = 0u; i < mips; ++i) {
+            image.mip_offsets.push_back(size);
+            size += level_size(
+                image.format, std::max(h.width >> i, 1u), std::max(h.height >> i, 1u));
+        }
+
+        image.data.resize(size);
+        file.read(reinterpret_cast<char *>(image.data.data()), (std::streamsize)size);
+        return (size_t)file.gcount() == size;
+    }
+} // namespace eng::dds
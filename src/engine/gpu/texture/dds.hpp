@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <filesystem>
+
+#include <engine/gpu/texture/block_compression.hpp>
+
+namespace eng {
+    // DirectDraw Surface files holding one 2D block compressed texture and its mip chain, the
+    // container texture_baker writes. Written with the DX10 header extension, which is the only
+    // way to tell BC7 apart; read with or without it.
+    namespace dds {
+        struct Image {
+            block_compression::BlockFormat format{block_compression::BlockFormat::BC7};
+            uint32_t width{0u}, height{0u};
+            // Byte offset of every mip level into data, largest first.
+            std::vector<size_t> mip_offsets;
+            std::vector<uint8_t> data;
+
+            uint32_t mip_count() const { return (uint32_t)mip_offsets.size(); }
+        };
+
+        bool write(const std::filesystem::path &path, const Image &image);
+        // False if the file is missing, is not a DDS file or holds something else than a 2D
+        // texture in one of BlockFormat's formats.
+        bool read(const std::filesystem::path &path, Image &image);
+    } // namespace dds
+} // namespace eng
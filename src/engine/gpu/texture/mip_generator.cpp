@@ -0,0 +1,245 @@
+#include "mip_generator.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <array>
+#include <functional>
+
+#include <engine/types/thread_pool.hpp>
+
+// SSE is part of every x86-64 CPU, no runtime check needed.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ENG_MIP_X86
+#include <xmmintrin.h>
+#endif
+
+namespace eng::mip_generator {
+    static constexpr float PI{3.14159265f};
+
+    static float sinc(float x) {
+        if (std::abs(x) < 1e-6f) { return 1.f; }
+        x *= PI;
+        return std::sin(x) / x;
+    }
+
+    // Zeroth order modified Bessel function of the first kind, power series.
+    static float bessel_i0(float x) {
+        float sum{1.f}, term{1.f};
+        for (auto k = 1u; k < 20u; ++k) {
+            const auto t = x / (2.f * (float)k);
+            term *= t * t;
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Filter shapes in units of destination texels, and how far from 0 they are not 0.
+    static float radius(Filter filter) { return filter == Filter::Box ? .5f : 3.f; }
+
+    static float evaluate(Filter filter, float x) {
+        static constexpr float KAISER_ALPHA{4.f};
+        static const float kaiser_norm{1.f / bessel_i0(KAISER_ALPHA)};
+
+        switch (filter) {
+        case Filter::Box: return x >= -.5f && x < .5f ? 1.f : 0.f;
+        case Filter::Kaiser: {
+            const auto t = x / radius(filter);
+            if (t * t >= 1.f) { return 0.f; }
+            return sinc(x) * bessel_i0(KAISER_ALPHA * std::sqrt(1.f - t * t)) * kaiser_norm;
+        }
+        case Filter::Lanczos: return std::abs(x) < 3.f ? sinc(x) * sinc(x / 3.f) : 0.f;
+        }
+        return 0.f;
+    }
+
+    // Source texels and weights of every destination texel along one axis. Every destination
+    // texel gets the same number of taps, indices are clamped to the edge.
+    struct Axis {
+        uint32_t taps{0u};
+        std::vector<uint32_t> indices;
+        std::vector<float> weights;
+    };
+
+    static Axis make_axis(uint32_t src, uint32_t dst, Filter filter) {
+        const auto scale   = (float)src / (float)dst;
+        const auto support = radius(filter) * scale;
+
+        Axis axis;
+        axis.taps = (uint32_t)std::ceil(2.f * support) + 1u;
+        axis.indices.resize((size_t)dst * axis.taps);
+        axis.weights.resize((size_t)dst * axis.taps);
+        for (auto i = 0u; i < dst; ++i) {
+            const auto center = ((float)i + .5f) * scale;
+            const auto first  = (int32_t)std::floor(center - support);
+            float sum{0.f};
+            for (auto t = 0u; t < axis.taps; ++t) {
+                const auto j = first + (int32_t)t;
+                const auto w = evaluate(filter, ((float)j + .5f - center) / scale);
+                axis.indices[i * axis.taps + t] = (uint32_t)std::clamp(j, 0, (int32_t)src - 1);
+                axis.weights[i * axis.taps + t] = w;
+                sum += w;
+            }
+            for (auto t = 0u; t < axis.taps; ++t) { axis.weights[i * axis.taps + t] /= sum; }
+        }
+        return axis;
+    }
+
+    // Filters one row of RGBA texels along x, into dst_w texels.
+    static void filter_row(const float *src_row, float *dst_row, const Axis &a, uint32_t dst_w) {
+        for (auto x = 0u; x < dst_w; ++x) {
+            const auto indices = &a.indices[x * a.taps];
+            const auto weights = &a.weights[x * a.taps];
+#ifdef ENG_MIP_X86
+            __m128 acc = _mm_setzero_ps();
+            for (auto t = 0u; t < a.taps; ++t) {
+                const auto texel = _mm_loadu_ps(&src_row[indices[t] * 4u]);
+                acc              = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[t]), texel));
+            }
+            _mm_storeu_ps(&dst_row[x * 4u], acc);
+#else
+            float acc[4]{};
+            for (auto t = 0u; t < a.taps; ++t) {
+                for (auto c = 0u; c < 4u; ++c) {
+                    acc[c] += weights[t] * src_row[indices[t] * 4u + c];
+                }
+            }
+            std::copy_n(acc, 4u, &dst_row[x * 4u]);
+#endif
+        }
+    }
+
+    // Row y of the result along y: a weighted sum of a.taps whole rows of src, w texels wide.
+    static void filter_column(
+        const float *src, float *dst_row, const Axis &a, uint32_t w, uint32_t y) {
+        const auto floats = (size_t)w * 4u;
+        std::fill_n(dst_row, floats, 0.f);
+        for (auto t = 0u; t < a.taps; ++t) {
+            const auto weight  = a.weights[y * a.taps + t];
+            const auto src_row = &src[a.indices[y * a.taps + t] * floats];
+            if (weight == 0.f) { continue; }
+
+            size_t i{0u};
+#ifdef ENG_MIP_X86
+            const auto w4 = _mm_set1_ps(weight);
+            for (; i + 4u <= floats; i += 4u) {
+                const auto sum = _mm_add_ps(_mm_loadu_ps(&dst_row[i]),
+                                            _mm_mul_ps(w4, _mm_loadu_ps(&src_row[i])));
+                _mm_storeu_ps(&dst_row[i], sum);
+            }
+#endif
+            for (; i < floats; ++i) { dst_row[i] += weight * src_row[i]; }
+        }
+    }
+
+    static float srgb_to_linear(float c) {
+        return c <= .04045f ? c / 12.92f : std::pow((c + .055f) / 1.055f, 2.4f);
+    }
+
+    static float linear_to_srgb(float c) {
+        return c <= .0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - .055f;
+    }
+
+    static std::vector<float> to_float(const uint8_t *rgba, size_t texels, const Settings &s) {
+        static const auto srgb_table = [] {
+            std::array<float, 256> table;
+            for (auto i = 0u; i < 256u; ++i) { table[i] = srgb_to_linear((float)i / 255.f); }
+            return table;
+        }();
+
+        std::vector<float> out(texels * 4u);
+        for (size_t i = 0u; i < texels * 4u; i += 4u) {
+            for (auto c = 0u; c < 3u; ++c) {
+                const auto v = rgba[i + c];
+                if (s.normal_map) {
+                    out[i + c] = (float)v / 127.5f - 1.f;
+                } else {
+                    out[i + c] = s.srgb ? srgb_table[v] : (float)v / 255.f;
+                }
+            }
+            out[i + 3u] = (float)rgba[i + 3u] / 255.f;
+        }
+        return out;
+    }
+
+    // Filtering shortens normals, and each level is filtered from the one above.
+    static void renormalize(std::vector<float> &level) {
+        for (size_t i = 0u; i < level.size(); i += 4u) {
+            auto n         = &level[i];
+            const auto len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (len > 1e-6f) {
+                n[0] /= len;
+                n[1] /= len;
+                n[2] /= len;
+            } else {
+                n[0] = 0.f;
+                n[1] = 0.f;
+                n[2] = 1.f;
+            }
+        }
+    }
+
+    static std::vector<uint8_t> to_8bit(const std::vector<float> &level, const Settings &s) {
+        // Linear to sRGB in 1/16384 steps, fine enough that the darkest, steepest part of the
+        // curve is off by at most a fifth of an 8 bit step.
+        static constexpr uint32_t STEPS{16384u};
+        static const auto srgb_table = [] {
+            std::vector<uint8_t> table(STEPS + 1u);
+            for (auto i = 0u; i <= STEPS; ++i) {
+                table[i] = (uint8_t)std::lround(linear_to_srgb((float)i / STEPS) * 255.f);
+            }
+            return table;
+        }();
+
+        std::vector<uint8_t> out(level.size());
+        for (size_t i = 0u; i < level.size(); ++i) {
+            const auto v = level[i];
+            if (i % 4u == 3u || (s.normal_map == false && s.srgb == false)) {
+                out[i] = (uint8_t)std::lround(std::clamp(v, 0.f, 1.f) * 255.f);
+            } else if (s.normal_map) {
+                out[i] = (uint8_t)std::lround(std::clamp(v * .5f + .5f, 0.f, 1.f) * 255.f);
+            } else {
+                out[i] = srgb_table[std::lround(std::clamp(v, 0.f, 1.f) * STEPS)];
+            }
+        }
+        return out;
+    }
+
+    std::vector<std::vector<uint8_t>> generate(const uint8_t *rgba,
+                                               uint32_t width,
+                                               uint32_t height,
+                                               const Settings &settings,
+                                               ThreadPool *pool) {
+        const auto run = [pool](uint32_t count, const std::function<void(uint32_t)> &fn) {
+            if (pool != nullptr) {
+                pool->parallel_for(count, fn);
+            } else {
+                for (auto i = 0u; i < count; ++i) { fn(i); }
+            }
+        };
+
+        std::vector<std::vector<uint8_t>> levels;
+        auto level = to_float(rgba, (size_t)width * height, settings);
+        auto w     = width, h = height;
+        while (w > 1u || h > 1u) {
+            const auto dst_w = std::max(w >> 1u, 1u), dst_h = std::max(h >> 1u, 1u);
+            const auto ax    = make_axis(w, dst_w, settings.filter);
+            const auto ay    = make_axis(h, dst_h, settings.filter);
+
+            // Separable: along x into w/2 x h, then along y into w/2 x h/2.
+            std::vector<float> rows((size_t)dst_w * h * 4u), next((size_t)dst_w * dst_h * 4u);
+            run(h, [&](uint32_t y) {
+                filter_row(&level[(size_t)y * w * 4u], &rows[(size_t)y * dst_w * 4u], ax, dst_w);
+            });
+            run(dst_h, [&](uint32_t y) {
+                filter_column(rows.data(), &next[(size_t)y * dst_w * 4u], ay, dst_w, y);
+            });
+
+            if (settings.normal_map) { renormalize(next); }
+            levels.push_back(to_8bit(next, settings));
+            level = std::move(next);
+            w     = dst_w;
+            h     = dst_h;
+        }
+        return levels;
+    }
+} // namespace eng::mip_generator
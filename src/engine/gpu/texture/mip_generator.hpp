@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace eng {
+    class ThreadPool;
+
+    // Mip chains built on the CPU at bake time, so loading a baked texture is only an upload.
+    // Every level is filtered from the float copy of the one above it, never from 8 bit data.
+    namespace mip_generator {
+        enum class Filter : uint32_t {
+            Box,     // 2x2 average, what glGenerateTextureMipmap does on most drivers
+            Kaiser,  // windowed sinc, alpha 4, radius 3, sharp with little ringing
+            Lanczos, // Lanczos 3, a bit sharper and more ringing than Kaiser
+        };
+
+        struct Settings {
+            Filter filter{Filter::Kaiser};
+            // RGB holds sRGB encoded values, filtered after conversion to linear. Alpha is always
+            // linear.
+            bool srgb{false};
+            // RGB holds a tangent space normal, every level is renormalized.
+            bool normal_map{false};
+        };
+
+        // Levels 1 and on of an RGBA8 image, down to 1x1, each half the size of the one above
+        // rounded down. Rows of every pass are spread over pool when one is given.
+        std::vector<std::vector<uint8_t>> generate(const uint8_t *rgba,
+                                                   uint32_t width,
+                                                   uint32_t height,
+                                                   const Settings &settings,
+                                                   ThreadPool *pool = nullptr);
+    } // namespace mip_generator
+} // namespace eng
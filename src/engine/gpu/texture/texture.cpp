@@ -1,11 +1,16 @@
 #include "texture.hpp"
 
 #include <cassert>
+#include <algorithm>
+#include <filesystem>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <glad/glad.h>
 
+#include <engine/gpu/texture/block_compression.hpp>
+#include <engine/gpu/texture/dds.hpp>
+
 namespace eng {
     Texture::Texture(const TextureSettings &settings,
                      const TextureImageDataDescriptor &data_descs,
@@ -14,10 +19,22 @@ namespace eng {
         _load(data_descs, also_store_data_on_cpu);
     }
 
+    Texture::Texture(const TextureSettings &settings, TextureImageData image) {
+        _settings   = settings;
+        _image_data = std::move(image);
+        _load(TextureImageDataDescriptor{_image_data.path}, false);
+    }
+
+    Texture::Texture(const TextureSettings &settings, Texture *placeholder) {
+        _settings    = settings;
+        _placeholder = placeholder;
+    }
+
     Texture::Texture(Texture &&other) noexcept {
         id               = other.id;
         _settings        = other._settings;
         _image_data      = other._image_data;
+        _placeholder     = other._placeholder;
         _is_bound        = other._is_bound;
         _is_resident     = other._is_resident;
         _bound_unit      = other._bound_unit;
@@ -46,15 +63,23 @@ namespace eng {
     }
 
     void Texture::make_resident() {
-        if (bindless_handle() == 0ull) { _bindless_handle = glGetTextureHandleARB(handle()); }
-
+        if (_is_resident) { return; }
         _is_resident = true;
-        glMakeTextureHandleResidentARB(bindless_handle());
+        // Stays resident for as long as anything streams in, TextureLoader makes the real
+        // handle resident once the texture is ready.
+        if (is_ready() == false) {
+            if (_placeholder->is_resident() == false) { _placeholder->make_resident(); }
+            return;
+        }
+
+        if (_bindless_handle == 0ull) { _bindless_handle = glGetTextureHandleARB(_handle); }
+        glMakeTextureHandleResidentARB(_bindless_handle);
     }
 
     void Texture::make_non_resident() {
+        if (_is_resident == false) { return; }
         _is_resident = false;
-        glMakeTextureHandleNonResidentARB(bindless_handle());
+        if (is_ready()) { glMakeTextureHandleNonResidentARB(_bindless_handle); }
     }
 
     void Texture::_load(const TextureImageDataDescriptor &data_desc, bool also_store_data_on_cpu) {
@@ -64,11 +89,27 @@ namespace eng {
         case GL_TEXTURE_2D: {
             const auto &desc = data_desc;
             auto &img_data   = _image_data;
-            img_data.path    = desc.path;
+
+            // Baked files bring their mip chain and may be block compressed, they go up as they
+            // are and nothing is generated.
+            if (img_data.data == nullptr
+                && std::filesystem::path{desc.path}.extension() == ".dds") {
+                img_data = decode(desc.path);
+            }
+            if (img_data.mip_offsets.empty() == false) {
+                _upload_mip_chain();
+                if (also_store_data_on_cpu == false) { img_data.data.reset(); }
+                break;
+            }
+
+            img_data.path      = desc.path;
+            const auto decoded = img_data.data != nullptr;
 
             // clang-format off
             auto pixels = (uint8_t*)0;
-            if(img_data.path.empty()==false) {
+            if(decoded) {
+                pixels = img_data.data.get();
+            } else if(img_data.path.empty()==false) {
 			    pixels = _load_image(desc.path, (int *)&img_data.sizex, (int *)&img_data.sizey, (int *)&img_data.channels, 0);
             }else {
 				img_data.channels =3;
@@ -79,7 +120,9 @@ namespace eng {
             glTextureSubImage2D(_handle, 0, desc.xoffset,desc.yoffset, img_data.sizex, img_data.sizey, img_data.channels == 3 ? GL_RGB : GL_RGBA, GL_UNSIGNED_BYTE, pixels);
             // clang-format on
 
-            if (also_store_data_on_cpu) {
+            if (decoded) {
+                if (also_store_data_on_cpu == false) { img_data.data.reset(); }
+            } else if (also_store_data_on_cpu) {
                 img_data.data = std::shared_ptr<uint8_t>(pixels, stbi_image_free);
             } else if (pixels != nullptr) {
                 stbi_image_free(pixels);
@@ -93,8 +136,112 @@ namespace eng {
         glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTextureParameteri(_handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTextureParameteri(_handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glGenerateTextureMipmap(_handle);
+        if (_image_data.mip_offsets.empty()) { glGenerateTextureMipmap(_handle); }
+    }
+
+    void Texture::_upload_mip_chain() {
+        static constexpr uint32_t formats[]{GL_RED, GL_RG, GL_RGB, GL_RGBA};
+        const auto &img = _image_data;
+        if (img.compressed_format != 0u) { _settings.format = img.compressed_format; }
+        _settings.mip_count = (uint32_t)img.mip_offsets.size();
+
+        glTextureStorage2D(_handle, _settings.mip_count, _settings.format, img.sizex, img.sizey);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (auto level = 0u; level < _settings.mip_count; ++level) {
+            const auto w      = std::max(img.sizex >> level, 1u);
+            const auto h      = std::max(img.sizey >> level, 1u);
+            const auto pixels = img.data.get() + img.mip_offsets[level];
+            if (img.compressed_format != 0u) {
+                const auto size = (size_t)((w + 3u) / 4u) * ((h + 3u) / 4u)
+                                  * block_compression::gl_block_size(img.compressed_format);
+                glCompressedTextureSubImage2D(_handle,
+                                              (int)level,
+                                              0,
+                                              0,
+                                              (int)w,
+                                              (int)h,
+                                              img.compressed_format,
+                                              (int)size,
+                                              pixels);
+            } else {
+                glTextureSubImage2D(_handle,
+                                    (int)level,
+                                    0,
+                                    0,
+                                    (int)w,
+                                    (int)h,
+                                    formats[img.channels - 1u],
+                                    GL_UNSIGNED_BYTE,
+                                    pixels);
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     }
+    size_t Texture::byte_size() const {
+        size_t size{0u};
+        auto x = _image_data.sizex, y = _image_data.sizey;
+        if (const auto block = block_compression::gl_block_size(_settings.format); block != 0u) {
+            for (auto i = 0u; i < _settings.mip_count; ++i) {
+                size += (size_t)((x + 3u) / 4u) * ((y + 3u) / 4u) * block;
+                x = std::max(x >> 1, 1u);
+                y = std::max(y >> 1, 1u);
+            }
+            return size;
+        }
+
+        size_t texel_size;
+        switch (_settings.format) {
+        case GL_R8: texel_size = 1u; break;
+        case GL_RG8: texel_size = 2u; break;
+        case GL_RGB16F:
+        case GL_RGBA16F: texel_size = 8u; break;
+        case GL_RGB32F:
+        case GL_RGBA32F: texel_size = 16u; break;
+        default: texel_size = 4u; break;
+        }
+
+        for (auto i = 0u; i < _settings.mip_count; ++i) {
+            size += (size_t)x * y * texel_size;
+            x = std::max(x >> 1, 1u);
+            y = std::max(y >> 1, 1u);
+        }
+        return size;
+    }
+
+    TextureImageData Texture::decode(const std::string &path) {
+        TextureImageData img;
+        img.path = path;
+
+        if (std::filesystem::path{path}.extension() == ".dds") {
+            auto image = std::make_shared<dds::Image>();
+            if (dds::read(path, *image) == false) {
+                fprintf(stderr, "Image not found at path: %s\n", path.c_str());
+                return img;
+            }
+            img.sizex             = image->width;
+            img.sizey             = image->height;
+            img.channels          = block_compression::channel_count(image->format);
+            img.compressed_format = block_compression::gl_format(image->format);
+            img.mip_offsets       = image->mip_offsets;
+            // Shares ownership of the file's contents instead of copying them.
+            img.data = std::shared_ptr<uint8_t>(image, image->data.data());
+            return img;
+        }
+
+        int x, y, channels;
+        auto pixels = stbi_load(path.c_str(), &x, &y, &channels, 0);
+        if (pixels == nullptr) {
+            fprintf(stderr, "Image not found at path: %s\n", path.c_str());
+            return img;
+        }
+
+        img.sizex    = (uint32_t)x;
+        img.sizey    = (uint32_t)y;
+        img.channels = (uint32_t)channels;
+        img.data     = std::shared_ptr<uint8_t>(pixels, stbi_image_free);
+        return img;
+    }
+
     uint8_t *Texture::_load_image(
         std::string_view path, int *sizex, int *sizey, int *channels, int req_channels) {
         auto pixels = stbi_load(path.data(), sizex, sizey, channels, req_channels);
@@ -25,6 +25,8 @@ namespace eng {
         uint32_t wrap_s{0}, wrap_t{0}, wrap_r{0};
         uint32_t filter_min{0}, filter_mag{0};
         uint32_t mip_count{1};
+
+        bool operator==(const TextureSettings &) const = default;
     };
 
     struct TextureImageDataDescriptor {
@@ -41,14 +43,26 @@ namespace eng {
         std::string path;
         uint32_t sizex{0}, sizey{0}, channels{0};
         std::shared_ptr<uint8_t> data;
+        // GL internal format of block compressed data, 0 if data holds channels bytes per texel.
+        uint32_t compressed_format{0};
+        // Byte offset of every mip level into data, for images that come with their mip chain.
+        // Empty if data is level 0 only and the rest is generated after upload.
+        std::vector<size_t> mip_offsets;
     };
 
+    class TextureLoader;
+
     class Texture : public IdResource<Texture> {
       public:
         explicit Texture() = default;
         explicit Texture(const TextureSettings &settings,
                          const TextureImageDataDescriptor &data_descs,
                          bool also_store_data_on_cpu = false);
+        // Creates texture from an image decode() already loaded.
+        explicit Texture(const TextureSettings &settings, TextureImageData image);
+        // Creates texture without storage that stands in for placeholder until TextureLoader
+        // streams its image in: handles, binding and residency all go to the placeholder.
+        explicit Texture(const TextureSettings &settings, Texture *placeholder);
         Texture(Texture &&) noexcept;
         ~Texture() override;
 
@@ -59,22 +73,39 @@ namespace eng {
 
         bool is_bound() const { return _is_bound; }
         bool is_resident() const { return _is_resident; }
+        // False while a placeholder is used instead.
+        bool is_ready() const { return _placeholder == nullptr; }
 
-        uint32_t handle() const { return _handle; }
-        uint64_t bindless_handle() const { return _bindless_handle; }
+        uint32_t handle() const { return is_ready() ? _handle : _placeholder->handle(); }
+        uint64_t bindless_handle() const {
+            return is_ready() ? _bindless_handle : _placeholder->bindless_handle();
+        }
         uint32_t bound_unit() const { return _bound_unit; }
+        // GL internal format, the one of the streamed in image once the texture is ready.
+        uint32_t format() const { return _settings.format; }
 
         std::pair<uint32_t, uint32_t> get_size() const {
             return {_image_data.sizex, _image_data.sizey};
         }
+        // Estimate of the video memory taken by all mip levels.
+        size_t byte_size() const;
+
+        // Loads and decodes an image file without touching GL, safe to call from any thread.
+        // Returned data is empty if the file could not be loaded.
+        static TextureImageData decode(const std::string &path);
 
       private:
         void _load(const TextureImageDataDescriptor &data_desc, bool also_store_data_on_cpu);
+        // Allocates and fills every level of _image_data's mip chain.
+        void _upload_mip_chain();
         uint8_t *_load_image(
             std::string_view path, int *sizex, int *sizey, int *channels, int req_channels = 0);
 
+        friend class TextureLoader;
+
         TextureSettings _settings;
         TextureImageData _image_data;
+        Texture *_placeholder{nullptr};
 
         bool _is_bound{false}, _is_resident{false};
         uint32_t _bound_unit{0};
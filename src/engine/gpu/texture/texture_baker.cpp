@@ -0,0 +1,53 @@
+#include "texture_baker.hpp"
+
+#include <algorithm>
+
+namespace eng::texture_baker {
+    std::filesystem::path baked_path(const std::filesystem::path &source, TextureType type) {
+        static constexpr const char *extensions[]{
+            ".diffuse.dds", ".normal.dds", ".metallic.dds", ".roughness.dds", ".emissive.dds"};
+        return std::filesystem::path{source}.replace_extension(extensions[(uint32_t)type]);
+    }
+
+    Settings settings_for(TextureType type) {
+        const mip_generator::Settings mips{
+            .filter     = mip_generator::Filter::Kaiser,
+            .srgb       = type == TextureType::Diffuse || type == TextureType::Emissive,
+            .normal_map = type == TextureType::Normal};
+        // Same channels the renderer samples metallic and roughness from in source images.
+        return Settings{.format         = block_compression::format_for(type),
+                        .source_channel = type == TextureType::Roughness ? 1u : 0u,
+                        .mips           = mips};
+    }
+
+    dds::Image bake(const uint8_t *rgba,
+                    uint32_t width,
+                    uint32_t height,
+                    const Settings &settings,
+                    ThreadPool *pool) {
+        dds::Image image{.format      = settings.format,
+                         .width       = width,
+                         .height      = height,
+                         .mip_offsets = {},
+                         .data        = {}};
+
+        std::vector<uint8_t> level{rgba, rgba + (size_t)width * height * 4u};
+        if (settings.format == block_compression::BlockFormat::BC4 && settings.source_channel) {
+            for (size_t i = 0u; i < level.size(); i += 4u) {
+                level[i] = level[i + settings.source_channel];
+            }
+        }
+
+        const auto append = [&](const std::vector<uint8_t> &texels, uint32_t w, uint32_t h) {
+            auto blocks = block_compression::encode(settings.format, texels.data(), w, h, pool);
+            image.mip_offsets.push_back(image.data.size());
+            image.data.insert(image.data.end(), blocks.begin(), blocks.end());
+        };
+        append(level, width, height);
+        const auto mips = mip_generator::generate(level.data(), width, height, settings.mips, pool);
+        for (auto i = 0u; i < mips.size(); ++i) {
+            append(mips[i], std::max(width >> (i + 1u), 1u), std::max(height >> (i + 1u), 1u));
+        }
+        return image;
+    }
+} // namespace eng::texture_baker
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <filesystem>
+
+#include <engine/gpu/texture/block_compression.hpp>
+#include <engine/gpu/texture/dds.hpp>
+#include <engine/gpu/texture/mip_generator.hpp>
+
+namespace eng {
+    class ThreadPool;
+
+    // Offline half of the compressed texture pipeline: source image in, DDS with a block
+    // compressed mip chain out. The texture_baker tool runs it, the importer picks up what it
+    // wrote through baked_path().
+    namespace texture_baker {
+        struct Settings {
+            block_compression::BlockFormat format{block_compression::BlockFormat::BC7};
+            // Channel moved into red before encoding BC4, the one the shaders sample.
+            uint32_t source_channel{0u};
+            mip_generator::Settings mips;
+        };
+
+        // What the engine expects in a material slot: format from block_compression::format_for,
+        // color is sRGB encoded, normals are renormalized, roughness comes from green.
+        Settings settings_for(TextureType type);
+
+        // Where the baked version of source for a type of slot goes and is looked for: next to
+        // it, as <stem>.<type>.dds. Slots sharing one image, like metallic and roughness packed
+        // into one, each get a file of their own.
+        std::filesystem::path baked_path(const std::filesystem::path &source, TextureType type);
+
+        // Encodes rgba and its mip chain down to 1x1, generated with settings.mips.
+        dds::Image bake(const uint8_t *rgba,
+                        uint32_t width,
+                        uint32_t height,
+                        const Settings &settings,
+                        ThreadPool *pool = nullptr);
+    } // namespace texture_baker
+} // namespace eng
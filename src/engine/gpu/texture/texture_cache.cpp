@@ -0,0 +1,73 @@
+#include "texture_cache.hpp"
+
+#include <functional>
+
+#include <engine/engine.hpp>
+#include <engine/gpu/texture/texture_loader.hpp>
+
+namespace eng {
+    size_t TextureCache::KeyHash::operator()(const Key &k) const {
+        const auto &s = k.settings;
+        auto h        = std::hash<std::string>{}(k.path);
+        for (const auto v : {s.type,
+                             s.format,
+                             s.wrap_s,
+                             s.wrap_t,
+                             s.wrap_r,
+                             s.filter_min,
+                             s.filter_mag,
+                             s.mip_count}) {
+            h = (h ^ v) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    // Absolute and without . and .. where the file exists, lexically cleaned up otherwise.
+    static std::string normalize(const std::filesystem::path &path) {
+        std::error_code ec;
+        auto normal = std::filesystem::weakly_canonical(path, ec);
+        if (ec) { normal = path.lexically_normal(); }
+        return normal.generic_string();
+    }
+
+    Texture *TextureCache::acquire(const std::filesystem::path &path,
+                                   const TextureSettings &settings,
+                                   TextureType type) {
+        Key key{normalize(path), settings};
+        auto [it, inserted] = _entries.try_emplace(key);
+        auto &e             = it->second;
+        e.references++;
+
+        if (inserted == false) {
+            e.hits++;
+            _hits++;
+            return e.texture;
+        }
+
+        _misses++;
+        e.texture = _loader.load(key.path, settings, type);
+        _keys.emplace(e.texture->id, std::move(key));
+        return e.texture;
+    }
+
+    void TextureCache::release(Texture *texture) {
+        const auto key = _keys.find(texture->id);
+        if (key == _keys.end()) { return; }
+
+        const auto it = _entries.find(key->second);
+        if (--it->second.references > 0u) { return; }
+
+        _released_bytes_saved += (size_t)it->second.hits * texture->byte_size();
+        Engine::instance().get_gpu_res_mgr()->destroy_resource(texture->res_handle());
+        _entries.erase(it);
+        _keys.erase(key);
+    }
+
+    TextureCache::Stats TextureCache::stats() const {
+        Stats s{.hits = _hits, .misses = _misses, .bytes_saved = _released_bytes_saved};
+        for (const auto &[_, e] : _entries) {
+            if (e.texture->is_ready()) { s.bytes_saved += (size_t)e.hits * e.texture->byte_size(); }
+        }
+        return s;
+    }
+} // namespace eng
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <filesystem>
+#include <unordered_map>
+
+#include <engine/gpu/texture/texture.hpp>
+
+namespace eng {
+    class TextureLoader;
+
+    // Shares textures between everything that asks for the same file with the same settings.
+    // Paths are normalized first, so "a/../b.png" and "b.png" are one entry. Every acquire takes
+    // a reference, the texture is destroyed when the last one is released.
+    class TextureCache {
+      public:
+        struct Stats {
+            uint32_t hits{0u}, misses{0u};
+            // Video memory the hits did not allocate again. Only counts textures that finished
+            // streaming in, their size is not known before.
+            size_t bytes_saved{0u};
+
+            float hit_ratio() const {
+                return hits + misses > 0u ? (float)hits / (float)(hits + misses) : 0.f;
+            }
+        };
+
+        explicit TextureCache(TextureLoader &loader) : _loader{loader} {}
+
+        // type picks the placeholder shown while a new texture streams in.
+        Texture *acquire(const std::filesystem::path &path,
+                         const TextureSettings &settings,
+                         TextureType type);
+        // Textures the cache did not hand out are ignored.
+        void release(Texture *texture);
+
+        Stats stats() const;
+        size_t size() const { return _entries.size(); }
+
+      private:
+        struct Key {
+            std::string path;
+            TextureSettings settings;
+
+            bool operator==(const Key &) const = default;
+        };
+        struct KeyHash {
+            size_t operator()(const Key &k) const;
+        };
+        struct Entry {
+            Texture *texture{nullptr};
+            uint32_t references{0u}, hits{0u};
+        };
+
+        TextureLoader &_loader;
+        std::unordered_map<Key, Entry, KeyHash> _entries;
+        // Texture id -> its key, for release.
+        std::unordered_map<uint32_t, Key> _keys;
+        uint32_t _hits{0u}, _misses{0u};
+        // Of entries that were released already.
+        size_t _released_bytes_saved{0u};
+    };
+} // namespace eng
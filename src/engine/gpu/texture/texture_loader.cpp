@@ -0,0 +1,193 @@
+#include "texture_loader.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+
+#include <glad/glad.h>
+
+#include <engine/engine.hpp>
+#include <engine/gpu/texture/block_compression.hpp>
+
+namespace eng {
+    TextureLoader::TextureLoader(ThreadPool &pool, size_t upload_budget)
+        : upload_budget{upload_budget}, _pool{pool}, _staging{upload_budget} {
+        // Neutral values of every TextureType: mid grey albedo, flat normal, dielectric, fully
+        // rough, not emissive.
+        static constexpr uint8_t colors[5][4]{
+            {128u, 128u, 128u, 255u},
+            {128u, 128u, 255u, 255u},
+            {0u, 0u, 0u, 255u},
+            {255u, 255u, 255u, 255u},
+            {0u, 0u, 0u, 255u},
+        };
+
+        auto gpu = Engine::instance().get_gpu_res_mgr();
+        for (auto i = 0u; i < _placeholders.size(); ++i) {
+            TextureImageData image;
+            image.sizex    = 1u;
+            image.sizey    = 1u;
+            image.channels = 4u;
+            image.data     = std::shared_ptr<uint8_t>(new uint8_t[4u],
+                                                      std::default_delete<uint8_t[]>());
+            memcpy(image.data.get(), colors[i], 4u);
+            _placeholders[i] = gpu->create_resource(
+                Texture{TextureSettings{GL_RGBA8, GL_REPEAT, GL_LINEAR, 1}, std::move(image)});
+        }
+    }
+
+    TextureLoader::~TextureLoader() {
+        for (auto &d : _decodes) { d.wait(); }
+    }
+
+    Texture *TextureLoader::load(const std::string &path,
+                                 const TextureSettings &settings,
+                                 TextureType type) {
+        auto gpu     = Engine::instance().get_gpu_res_mgr();
+        auto texture = gpu->create_resource(Texture{settings, placeholder(type)});
+        _pending++;
+
+        const Handle<Texture> handle{texture->res_handle()};
+        _decodes.push_back(_pool.submit([this, handle, path] {
+            auto image = Texture::decode(path);
+            std::scoped_lock lock{_decoded_mutex};
+            _decoded.push_back(Upload{.texture = handle, .image = std::move(image)});
+        }));
+        return texture;
+    }
+
+    uint32_t TextureLoader::update() {
+        while (_decodes.empty() == false
+               && _decodes.front().wait_for(std::chrono::seconds{0})
+                      == std::future_status::ready) {
+            _decodes.pop_front();
+        }
+        {
+            std::scoped_lock lock{_decoded_mutex};
+            for (auto &d : _decoded) { _uploads.push_back(std::move(d)); }
+            _decoded.clear();
+        }
+        if (_uploads.empty()) { return 0u; }
+
+        auto gpu = Engine::instance().get_gpu_res_mgr();
+        uint32_t completed{0u};
+
+        _staging.begin_frame();
+        _staging.bind(GL_PIXEL_UNPACK_BUFFER);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        auto budget = std::min(upload_budget, _staging.capacity());
+        while (_uploads.empty() == false) {
+            auto &u      = _uploads.front();
+            auto texture = gpu->try_get_resource(u.texture);
+
+            // Released by its last user while loading (the cache destroys it then), or the file
+            // could not be decoded and the placeholder stays for good.
+            if (texture == nullptr || u.image.data == nullptr) {
+                _uploads.pop_front();
+                _pending--;
+                continue;
+            }
+
+            if (_upload_rows(*texture, u, budget) == false) { break; }
+            _finish(*texture, u.image.mip_offsets.empty());
+            _uploads.pop_front();
+            _pending--;
+            completed++;
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        _staging.end_frame();
+        return completed;
+    }
+
+    bool TextureLoader::_upload_rows(Texture &texture, Upload &u, size_t &budget) {
+        const auto &image     = u.image;
+        const auto compressed = image.compressed_format != 0u;
+        const auto levels     = image.mip_offsets.empty() ? 1u : (uint32_t)image.mip_offsets.size();
+        if (texture._handle == 0u) {
+            texture._image_data.path     = image.path;
+            texture._image_data.sizex    = image.sizex;
+            texture._image_data.sizey    = image.sizey;
+            texture._image_data.channels = image.channels;
+
+            // Images that bring their own mip chain decide the format and level count, block
+            // compressed ones always do.
+            auto &s = texture._settings;
+            if (compressed) { s.format = image.compressed_format; }
+            if (image.mip_offsets.empty() == false) { s.mip_count = levels; }
+            glCreateTextures(GL_TEXTURE_2D, 1, &texture._handle);
+            glTextureStorage2D(texture._handle, s.mip_count, s.format, image.sizex, image.sizey);
+            glTextureParameteri(texture._handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(texture._handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(texture._handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTextureParameteri(texture._handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+
+        static constexpr uint32_t formats[]{GL_RED, GL_RG, GL_RGB, GL_RGBA};
+        // Block compressed levels go up a row of 4x4 blocks at a time.
+        const auto row_height = compressed ? 4u : 1u;
+        for (; u.level < levels; ++u.level, u.next_row = 0u) {
+            const auto width     = std::max(image.sizex >> u.level, 1u);
+            const auto height    = std::max(image.sizey >> u.level, 1u);
+            const auto row_count = (height + row_height - 1u) / row_height;
+            const auto row_size
+                = compressed ? (size_t)((width + 3u) / 4u)
+                                   * block_compression::gl_block_size(image.compressed_format)
+                             : (size_t)width * image.channels;
+            const auto level_data
+                = image.data.get() + (image.mip_offsets.empty() ? 0u : image.mip_offsets[u.level]);
+
+            while (u.next_row < row_count) {
+                const auto room = std::min(budget, _staging.capacity() - _staging.size());
+                const auto rows
+                    = (uint32_t)std::min<size_t>(room / row_size, row_count - u.next_row);
+                if (rows == 0u) { return false; }
+
+                const auto bytes  = rows * row_size;
+                const auto offset = _staging.region_offset() + _staging.size();
+                const auto y      = u.next_row * row_height;
+                const auto h      = std::min(rows * row_height, height - y);
+                memcpy(_staging.allocate(bytes), level_data + u.next_row * row_size, bytes);
+                if (compressed) {
+                    glCompressedTextureSubImage2D(texture._handle,
+                                                  (int)u.level,
+                                                  0,
+                                                  (int)y,
+                                                  (int)width,
+                                                  (int)h,
+                                                  image.compressed_format,
+                                                  (int)bytes,
+                                                  (void *)offset);
+                } else {
+                    glTextureSubImage2D(texture._handle,
+                                        (int)u.level,
+                                        0,
+                                        (int)y,
+                                        (int)width,
+                                        (int)h,
+                                        formats[image.channels - 1u],
+                                        GL_UNSIGNED_BYTE,
+                                        (void *)offset);
+                }
+
+                u.next_row += rows;
+                budget -= bytes;
+                _uploaded_bytes += bytes;
+            }
+        }
+        return true;
+    }
+
+    void TextureLoader::_finish(Texture &texture, bool generate_mips) {
+        if (generate_mips) { glGenerateTextureMipmap(texture._handle); }
+        texture._placeholder = nullptr;
+        // Was made resident while it still stood in for the placeholder, only the placeholder's
+        // handle is so far.
+        if (texture._is_resident) {
+            texture._is_resident = false;
+            texture.make_resident();
+        }
+    }
+} // namespace eng
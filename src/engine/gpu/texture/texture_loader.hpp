@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <deque>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <mutex>
+#include <future>
+
+#include <engine/gpu/texture/texture.hpp>
+#include <engine/gpu/buffers/buffer.hpp>
+#include <engine/types/thread_pool.hpp>
+#include <engine/types/idresource.hpp>
+
+namespace eng {
+    // Streams textures in without stalling the frame. Images are decoded on the thread pool,
+    // copied into a persistently mapped pixel unpack ring buffer and uploaded a few rows at a
+    // time, at most upload_budget bytes per frame. Until a texture is complete, it samples a
+    // 1x1 placeholder of its type. Baked .dds files skip decoding and go up block compressed,
+    // with the mip chain they were baked with.
+    class TextureLoader {
+      public:
+        explicit TextureLoader(ThreadPool &pool, size_t upload_budget = 8u << 20);
+        TextureLoader(const TextureLoader &) = delete;
+        TextureLoader &operator=(const TextureLoader &) = delete;
+        // Waits for decodes still running on the pool.
+        ~TextureLoader();
+
+        // Returns right away, with a texture that is not ready yet. Images that fail to decode
+        // keep the placeholder.
+        Texture *load(const std::string &path, const TextureSettings &settings, TextureType type);
+
+        // Call once a frame on the GL thread. Uploads what was decoded since, within the budget,
+        // and returns how many textures became ready.
+        uint32_t update();
+
+        // 1x1 texture with the neutral value of type.
+        Texture *placeholder(TextureType type) const { return _placeholders[(uint32_t)type]; }
+        bool is_placeholder(const Texture *texture) const {
+            return std::find(_placeholders.begin(), _placeholders.end(), texture)
+                   != _placeholders.end();
+        }
+        // Textures still decoding or uploading.
+        uint32_t pending() const { return _pending; }
+        size_t uploaded_bytes() const { return _uploaded_bytes; }
+
+        size_t upload_budget;
+
+      private:
+        struct Upload {
+            Handle<Texture> texture;
+            TextureImageData image;
+            // Next mip level and row to upload, rows of blocks for block compressed images.
+            uint32_t level{0u}, next_row{0u};
+        };
+
+        // Uploads as many rows of u as fit in budget, level by level if the image comes with its
+        // mip chain. True once the texture is complete.
+        bool _upload_rows(Texture &texture, Upload &u, size_t &budget);
+        // Generates the mip chain unless it was uploaded.
+        void _finish(Texture &texture, bool generate_mips);
+
+        ThreadPool &_pool;
+        GLRingBuffer _staging;
+        std::array<Texture *, 5> _placeholders{};
+
+        std::mutex _decoded_mutex;
+        std::vector<Upload> _decoded;
+        std::deque<std::future<void>> _decodes;
+        std::deque<Upload> _uploads;
+        uint32_t _pending{0u};
+        size_t _uploaded_bytes{0u};
+    };
+} // namespace eng
@@ -0,0 +1,154 @@
+#include "texture_residency.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include <engine/engine.hpp>
+#include <engine/gpu/texture/texture_loader.hpp>
+
+namespace eng {
+    void TextureResidency::set_materials(
+        const std::unordered_map<uint32_t, MaterialTextures> &materials) {
+        // References are added before any are dropped, so a texture that only moved to another
+        // material stays resident.
+        for (const auto &[id, textures] : materials) {
+            if (_materials.contains(id)) { continue; }
+            std::array<uint32_t, 5> ids;
+            for (auto i = 0u; i < textures.size(); ++i) {
+                _add_reference(textures[i]);
+                ids[i] = textures[i]->id;
+            }
+            _materials.emplace(id, ids);
+        }
+
+        for (auto it = _materials.begin(); it != _materials.end();) {
+            if (materials.contains(it->first)) {
+                ++it;
+                continue;
+            }
+            for (const auto texture : it->second) { _drop_reference(texture); }
+            it = _materials.erase(it);
+        }
+    }
+
+    void TextureResidency::touch(uint32_t material) {
+        const auto m = _materials.find(material);
+        if (m == _materials.end()) { return; }
+
+        auto gpu = Engine::instance().get_gpu_res_mgr();
+        for (const auto id : m->second) {
+            const auto e = _textures.find(id);
+            if (e == _textures.end()) { continue; }
+            e->second.last_used = _frame;
+            if (auto texture = gpu->try_get_resource(e->second.texture);
+                texture != nullptr && texture->is_resident() == false) {
+                _make_resident(texture);
+                _changed = true;
+            }
+        }
+    }
+
+    bool TextureResidency::update() {
+        auto gpu = Engine::instance().get_gpu_res_mgr();
+
+        // Textures still streaming in take no memory of their own yet.
+        size_t bytes{0u};
+        _candidates.clear();
+        for (auto it = _textures.begin(); it != _textures.end();) {
+            const auto texture = gpu->try_get_resource(it->second.texture);
+            if (texture == nullptr) {
+                it = _textures.erase(it);
+                continue;
+            }
+            const auto &e = it->second;
+            if (texture->is_resident() && texture->is_ready()) {
+                bytes += texture->byte_size();
+                if (e.pinned == false && e.last_used + idle_frames < _frame) {
+                    _candidates.push_back(it->first);
+                }
+            }
+            ++it;
+        }
+
+        if (bytes > budget) {
+            std::sort(_candidates.begin(), _candidates.end(), [this](uint32_t a, uint32_t b) {
+                return _textures.at(a).last_used < _textures.at(b).last_used;
+            });
+            for (const auto id : _candidates) {
+                if (bytes <= budget) { break; }
+                const auto texture = gpu->get_resource(_textures.at(id).texture);
+                bytes -= texture->byte_size();
+                _make_non_resident(texture);
+                _stats.evictions++;
+                _changed = true;
+            }
+        }
+
+        _stats.resident_bytes = bytes;
+        _frame++;
+        return std::exchange(_changed, false);
+    }
+
+    uint64_t TextureResidency::bindless_handle(uint32_t material, TextureType type) {
+        auto gpu     = Engine::instance().get_gpu_res_mgr();
+        const auto e = _textures.find(_materials.at(material)[(uint32_t)type]);
+        if (e != _textures.end()) {
+            const auto texture = gpu->try_get_resource(e->second.texture);
+            if (texture != nullptr && texture->is_resident()) { return texture->bindless_handle(); }
+        }
+
+        const auto placeholder = Engine::instance().get_texture_loader()->placeholder(type);
+        if (placeholder->is_resident() == false) { _make_resident(placeholder); }
+        return placeholder->bindless_handle();
+    }
+
+    TextureResidency::Stats TextureResidency::stats() const {
+        auto s     = _stats;
+        s.textures = (uint32_t)_textures.size();
+        s.evicted  = 0u;
+        auto gpu   = Engine::instance().get_gpu_res_mgr();
+        for (const auto &[_, e] : _textures) {
+            const auto texture = gpu->try_get_resource(e.texture);
+            if (texture != nullptr && texture->is_resident() == false) { s.evicted++; }
+        }
+        return s;
+    }
+
+    void TextureResidency::_add_reference(Texture *texture) {
+        auto [it, inserted] = _textures.try_emplace(texture->id);
+        auto &e             = it->second;
+        if (inserted) {
+            e.texture   = texture->res_handle();
+            e.last_used = _frame;
+            e.pinned    = Engine::instance().get_texture_loader()->is_placeholder(texture);
+        }
+        e.references++;
+
+        if (texture->is_resident()) {
+            _stats.skipped_calls++;
+        } else {
+            _make_resident(texture);
+        }
+    }
+
+    void TextureResidency::_drop_reference(uint32_t texture) {
+        const auto it = _textures.find(texture);
+        if (it == _textures.end() || --it->second.references > 0u) { return; }
+
+        const auto t = Engine::instance().get_gpu_res_mgr()->try_get_resource(it->second.texture);
+        if (t != nullptr && it->second.pinned == false && t->is_resident()) {
+            _make_non_resident(t);
+        }
+        _textures.erase(it);
+    }
+
+    void TextureResidency::_make_resident(Texture *texture) {
+        texture->make_resident();
+        _stats.make_resident_calls++;
+    }
+
+    void TextureResidency::_make_non_resident(Texture *texture) {
+        texture->make_non_resident();
+        _stats.make_non_resident_calls++;
+    }
+} // namespace eng
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+#include <unordered_map>
+
+#include <engine/gpu/texture/texture.hpp>
+#include <engine/types/idresource.hpp>
+
+namespace eng {
+    // Decides which bindless handles are resident. Textures are reference counted per material:
+    // the first material in use that refers to one makes it resident, the last one to go makes
+    // it non-resident. Past budget bytes of resident textures, the ones drawn least recently are
+    // evicted until the rest fits, and made resident again once something visible samples them.
+    // Instance data has to take handles from bindless_handle(), evicted textures read as their
+    // placeholder there.
+    class TextureResidency {
+      public:
+        // Textures of a material, indexed by TextureType.
+        using MaterialTextures = std::array<Texture *, 5>;
+
+        struct Stats {
+            uint32_t textures{0u}, evicted{0u};
+            size_t resident_bytes{0u};
+            // Residency changes sent to GL, and references taken on textures that were resident
+            // already, which used to make them resident again.
+            uint64_t make_resident_calls{0u}, make_non_resident_calls{0u}, skipped_calls{0u};
+            uint64_t evictions{0u};
+        };
+
+        explicit TextureResidency(size_t budget = 512u << 20) : budget{budget} {}
+
+        // Every material in use, by id. Only materials that were not in the previous set or are
+        // missing from it now add or drop references.
+        void set_materials(const std::unordered_map<uint32_t, MaterialTextures> &materials);
+        // Marks the textures of a material drawn this frame, evicted ones become resident again.
+        void touch(uint32_t material);
+        // Call once a frame, after touch() and before instance data is built. Evicts while over
+        // budget and returns true if handles in the instance data are stale since the last call.
+        bool update();
+
+        // What the shaders should sample for type of material.
+        uint64_t bindless_handle(uint32_t material, TextureType type);
+
+        Stats stats() const;
+
+        size_t budget;
+        // Frames a texture goes unseen before it can be evicted, so turning the camera back and
+        // forth does not make the same textures resident over and over.
+        uint32_t idle_frames{30u};
+
+      private:
+        struct Entry {
+            Handle<Texture> texture;
+            uint32_t references{0u};
+            uint64_t last_used{0u};
+            // Placeholders stand in for evicted textures and are never evicted themselves.
+            bool pinned{false};
+        };
+
+        void _add_reference(Texture *texture);
+        void _drop_reference(uint32_t texture);
+        void _make_resident(Texture *texture);
+        void _make_non_resident(Texture *texture);
+
+        // Texture id -> entry.
+        std::unordered_map<uint32_t, Entry> _textures;
+        // Material id -> ids of its textures.
+        std::unordered_map<uint32_t, std::array<uint32_t, 5>> _materials;
+        std::vector<uint32_t> _candidates;
+        uint64_t _frame{0u};
+        bool _changed{false};
+        Stats _stats;
+    };
+} // namespace eng
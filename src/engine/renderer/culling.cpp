@@ -0,0 +1,336 @@
+#include "culling.hpp"
+
+#include <cmath>
+#include <cassert>
+#include <bit>
+
+#include <engine/renderer/renderer.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ENG_CULLING_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ENG_TARGET_AVX
+#else
+#include <immintrin.h>
+#define ENG_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+namespace eng::culling {
+    Frustum Frustum::from_matrix(const glm::mat4 &pv) {
+        const auto row = [&pv](int i) {
+            return glm::vec4{pv[0][i], pv[1][i], pv[2][i], pv[3][i]};
+        };
+
+        Frustum f{{row(3) + row(0),
+                   row(3) - row(0),
+                   row(3) + row(1),
+                   row(3) - row(1),
+                   row(3) + row(2),
+                   row(3) - row(2)}};
+        for (auto &p : f.planes) { p /= glm::length(glm::vec3{p}); }
+        return f;
+    }
+
+    bool Frustum::intersects(glm::vec4 sphere) const {
+        for (const auto &p : planes) {
+            if (glm::dot(glm::vec3{p}, glm::vec3{sphere}) + p.w < -sphere.w) { return false; }
+        }
+        return true;
+    }
+
+    // Scalar loop over [first, size), SIMD paths finish their tails with it.
+    static uint32_t frustum_cull_scalar(const Frustum &f,
+                                        const SphereSoA &spheres,
+                                        uint32_t first,
+                                        uint32_t *out) {
+        uint32_t count{0u};
+        for (auto i = first; i < (uint32_t)spheres.size(); ++i) {
+            const glm::vec4 s{spheres.x[i], spheres.y[i], spheres.z[i], spheres.r[i]};
+            if (f.intersects(s)) { out[count++] = i; }
+        }
+        return count;
+    }
+
+    void HiZPyramid::build(std::span<const float> depth, uint32_t width, uint32_t height) {
+        assert(depth.size() == (size_t)width * height);
+
+        _width  = width;
+        _height = height;
+        _levels.clear();
+        _levels.emplace_back(depth.begin(), depth.end());
+
+        // Odd sized levels fold their last row/column into the last texel of the next level, so
+        // every source texel is covered by some texel above it.
+        while (width > 1u || height > 1u) {
+            const auto level = levels();
+            const auto dw    = this->width(level);
+            const auto dh    = this->height(level);
+            std::vector<float> dst(dw * dh);
+
+            for (auto y = 0u; y < dh; ++y) {
+                for (auto x = 0u; x < dw; ++x) {
+                    const auto ex = (width & 1u) && x == dw - 1u ? 2u : 1u;
+                    const auto ey = (height & 1u) && y == dh - 1u ? 2u : 1u;
+
+                    float d{0.f};
+                    for (auto sy = 0u; sy <= ey; ++sy) {
+                        for (auto sx = 0u; sx <= ex; ++sx) {
+                            d = std::max(d,
+                                         texel(level - 1u,
+                                               std::min(x * 2u + sx, width - 1u),
+                                               std::min(y * 2u + sy, height - 1u)));
+                        }
+                    }
+                    dst[y * dw + x] = d;
+                }
+            }
+
+            _levels.push_back(std::move(dst));
+            width  = dw;
+            height = dh;
+        }
+    }
+
+    bool HiZPyramid::occludes(const glm::mat4 &pv, glm::vec4 sphere) const {
+        if (_levels.empty()) { return false; }
+
+        glm::vec3 ndc_min{1e30f}, ndc_max{-1e30f};
+        for (auto i = 0u; i < 8u; ++i) {
+            const glm::vec3 corner{
+                (i & 1u) ? 1.f : -1.f, (i & 2u) ? 1.f : -1.f, (i & 4u) ? 1.f : -1.f};
+            const auto clip = pv * glm::vec4{glm::vec3{sphere} + corner * sphere.w, 1.f};
+            // Crosses the near plane - projected bounds are meaningless.
+            if (clip.w <= 0.f) { return false; }
+            const auto ndc = glm::vec3{clip} / clip.w;
+            ndc_min        = glm::min(ndc_min, ndc);
+            ndc_max        = glm::max(ndc_max, ndc);
+        }
+
+        const auto uv_min  = glm::clamp(glm::vec2{ndc_min} * .5f + .5f, 0.f, 1.f);
+        const auto uv_max  = glm::clamp(glm::vec2{ndc_max} * .5f + .5f, 0.f, 1.f);
+        const auto nearest = ndc_min.z * .5f + .5f;
+
+        // Pick the level where the rectangle spans at most 2x2 texels.
+        const auto extent = (uv_max - uv_min) * glm::vec2{(float)_width, (float)_height};
+        auto level        = (uint32_t)glm::clamp(
+            std::ceil(std::log2(std::max({extent.x, extent.y, 1.f}))), 0.f, (float)levels() - 1.f);
+
+        // Texel x of a level covers level 0 pixels [x << level, (x + 1) << level), the last one
+        // also whatever odd sizes left over, so the rectangle is mapped through pixel coords.
+        const auto px0 = std::min((uint32_t)(uv_min.x * _width), _width - 1u);
+        const auto px1 = std::min((uint32_t)(uv_max.x * _width), _width - 1u);
+        const auto py0 = std::min((uint32_t)(uv_min.y * _height), _height - 1u);
+        const auto py1 = std::min((uint32_t)(uv_max.y * _height), _height - 1u);
+
+        uint32_t x0, x1, y0, y1;
+        while (true) {
+            const auto lw = width(level), lh = height(level);
+            x0 = std::min(px0 >> level, lw - 1u);
+            x1 = std::min(px1 >> level, lw - 1u);
+            y0 = std::min(py0 >> level, lh - 1u);
+            y1 = std::min(py1 >> level, lh - 1u);
+            if ((x1 - x0 < 2u && y1 - y0 < 2u) || level + 1u == levels()) { break; }
+            ++level;
+        }
+
+        const auto farthest = std::max({texel(level, x0, y0),
+                                        texel(level, x1, y0),
+                                        texel(level, x0, y1),
+                                        texel(level, x1, y1)});
+        return nearest > farthest;
+    }
+
+    uint32_t frustum_cull_scalar(const Frustum &f, const SphereSoA &spheres, uint32_t *out) {
+        return frustum_cull_scalar(f, spheres, 0u, out);
+    }
+
+    uint32_t frustum_cull_sse(const Frustum &f, const SphereSoA &spheres, uint32_t *out) {
+#ifdef ENG_CULLING_X86
+        const auto n = (uint32_t)spheres.size();
+        uint32_t count{0u}, i{0u};
+
+        __m128 px[6], py[6], pz[6], pw[6];
+        for (auto k = 0u; k < 6u; ++k) {
+            px[k] = _mm_set1_ps(f.planes[k].x);
+            py[k] = _mm_set1_ps(f.planes[k].y);
+            pz[k] = _mm_set1_ps(f.planes[k].z);
+            pw[k] = _mm_set1_ps(f.planes[k].w);
+        }
+
+        for (; i + 4u <= n; i += 4u) {
+            const auto x   = _mm_loadu_ps(&spheres.x[i]);
+            const auto y   = _mm_loadu_ps(&spheres.y[i]);
+            const auto z   = _mm_loadu_ps(&spheres.z[i]);
+            const auto neg = _mm_xor_ps(_mm_loadu_ps(&spheres.r[i]), _mm_set1_ps(-0.f));
+
+            // Same operation order as Frustum::intersects, so results match bit for bit.
+            auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (auto k = 0u; k < 6u; ++k) {
+                auto d = _mm_add_ps(_mm_mul_ps(px[k], x), _mm_mul_ps(py[k], y));
+                d      = _mm_add_ps(_mm_add_ps(d, _mm_mul_ps(pz[k], z)), pw[k]);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(d, neg));
+            }
+
+            for (auto mask = (uint32_t)_mm_movemask_ps(inside); mask != 0u; mask &= mask - 1u) {
+                out[count++] = i + (uint32_t)std::countr_zero(mask);
+            }
+        }
+
+        return count + frustum_cull_scalar(f, spheres, i, out + count);
+#else
+        return frustum_cull_scalar(f, spheres, out);
+#endif
+    }
+
+#ifdef ENG_CULLING_X86
+    ENG_TARGET_AVX static uint32_t frustum_cull_avx_impl(const Frustum &f,
+                                                         const SphereSoA &spheres,
+                                                         uint32_t *out) {
+        const auto n = (uint32_t)spheres.size();
+        uint32_t count{0u}, i{0u};
+
+        __m256 px[6], py[6], pz[6], pw[6];
+        for (auto k = 0u; k < 6u; ++k) {
+            px[k] = _mm256_set1_ps(f.planes[k].x);
+            py[k] = _mm256_set1_ps(f.planes[k].y);
+            pz[k] = _mm256_set1_ps(f.planes[k].z);
+            pw[k] = _mm256_set1_ps(f.planes[k].w);
+        }
+
+        for (; i + 8u <= n; i += 8u) {
+            const auto x   = _mm256_loadu_ps(&spheres.x[i]);
+            const auto y   = _mm256_loadu_ps(&spheres.y[i]);
+            const auto z   = _mm256_loadu_ps(&spheres.z[i]);
+            const auto neg = _mm256_xor_ps(_mm256_loadu_ps(&spheres.r[i]), _mm256_set1_ps(-0.f));
+
+            auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (auto k = 0u; k < 6u; ++k) {
+                auto d = _mm256_add_ps(_mm256_mul_ps(px[k], x), _mm256_mul_ps(py[k], y));
+                d      = _mm256_add_ps(_mm256_add_ps(d, _mm256_mul_ps(pz[k], z)), pw[k]);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, neg, _CMP_GE_OQ));
+            }
+
+            for (auto mask = (uint32_t)_mm256_movemask_ps(inside); mask != 0u; mask &= mask - 1u) {
+                out[count++] = i + (uint32_t)std::countr_zero(mask);
+            }
+        }
+
+        return count + frustum_cull_scalar(f, spheres, i, out + count);
+    }
+
+    static bool cpu_has_avx() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+        return osxsave && avx && (_xgetbv(0) & 6u) == 6u;
+#else
+        return __builtin_cpu_supports("avx");
+#endif
+    }
+#endif
+
+    uint32_t frustum_cull_avx(const Frustum &f, const SphereSoA &spheres, uint32_t *out) {
+#ifdef ENG_CULLING_X86
+        return frustum_cull_avx_impl(f, spheres, out);
+#else
+        return frustum_cull_scalar(f, spheres, out);
+#endif
+    }
+
+    bool has_avx() {
+#ifdef ENG_CULLING_X86
+        static const bool has = cpu_has_avx();
+        return has;
+#else
+        return false;
+#endif
+    }
+
+    uint32_t frustum_cull(const Frustum &f, const SphereSoA &spheres, uint32_t *out) {
+#ifdef ENG_CULLING_X86
+        if (has_avx()) { return frustum_cull_avx_impl(f, spheres, out); }
+        return frustum_cull_sse(f, spheres, out);
+#else
+        return frustum_cull_scalar(f, spheres, out);
+#endif
+    }
+
+    glm::vec4 transform_sphere(const glm::mat4 &transform, glm::vec4 sphere) {
+        const auto scale = std::max({glm::dot(glm::vec3{transform[0]}, glm::vec3{transform[0]}),
+                                     glm::dot(glm::vec3{transform[1]}, glm::vec3{transform[1]}),
+                                     glm::dot(glm::vec3{transform[2]}, glm::vec3{transform[2]})});
+        return glm::vec4{glm::vec3{transform * glm::vec4{glm::vec3{sphere}, 1.f}},
+                         sphere.w * std::sqrt(scale)};
+    }
+
+    uint32_t select_lod(glm::vec4 sphere,
+                        float mesh_radius,
+                        glm::vec3 camera,
+                        glm::vec4 errors,
+                        float lod_factor) {
+        const auto scale    = mesh_radius > 0.f ? sphere.w / mesh_radius : 1.f;
+        const auto distance = std::max(glm::distance(camera, glm::vec3{sphere}) - sphere.w, 0.f);
+
+        uint32_t lod{0u};
+        for (auto k = 1u; k < MAX_LODS; ++k) {
+            if (errors[k] * scale * lod_factor <= distance) { lod = k; }
+        }
+        return lod;
+    }
+
+    void cull_instances(std::span<DrawElementsIndirectCommand> commands,
+                        std::span<const glm::mat4> transforms,
+                        std::span<const uint32_t> instance_batches,
+                        std::span<const glm::vec4> batch_bounds,
+                        std::span<const glm::vec4> batch_lod_errors,
+                        const glm::mat4 &pv,
+                        glm::vec3 camera,
+                        float lod_factor,
+                        const HiZPyramid *hiz,
+                        std::span<uint32_t> visible) {
+        const auto frustum = Frustum::from_matrix(pv);
+
+        for (auto i = 0u; i < transforms.size(); ++i) {
+            const auto batch  = instance_batches[i];
+            const auto sphere = transform_sphere(transforms[i], batch_bounds[batch]);
+
+            if (frustum.intersects(sphere) == false) { continue; }
+            if (hiz && hiz->occludes(pv, sphere)) { continue; }
+
+            const auto lod = select_lod(
+                sphere, batch_bounds[batch].w, camera, batch_lod_errors[batch], lod_factor);
+            auto &c = commands[batch * MAX_LODS + lod];
+            visible[c.base_instance + c.instance_count++] = i;
+        }
+    }
+
+    bool cone_culled(const Meshlet &meshlet, glm::vec3 camera) {
+        const auto to_center = glm::vec3{meshlet.sphere} - camera;
+        return glm::dot(to_center, glm::vec3{meshlet.cone})
+               >= meshlet.cone.w * glm::length(to_center) + meshlet.sphere.w;
+    }
+
+    uint32_t cull_meshlets(std::span<const Meshlet> meshlets,
+                           const glm::mat4 &transform,
+                           const Frustum *frustum,
+                           glm::vec3 camera,
+                           uint32_t *out) {
+        // Facing is kept by affine transforms, so the cone test runs in mesh space and does not
+        // need to transform the cone, which non-uniform scale would bend.
+        const auto local_camera = glm::vec3{glm::inverse(transform) * glm::vec4{camera, 1.f}};
+
+        uint32_t count{0u};
+        for (auto i = 0u; i < meshlets.size(); ++i) {
+            if (frustum && frustum->intersects(transform_sphere(transform, meshlets[i].sphere))
+                               == false) {
+                continue;
+            }
+            if (cone_culled(meshlets[i], local_camera)) { continue; }
+            out[count++] = i;
+        }
+        return count;
+    }
+} // namespace eng::culling
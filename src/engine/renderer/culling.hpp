@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <engine/renderer/mesh_lod.hpp>
+#include <engine/renderer/meshlet.hpp>
+
+namespace eng {
+    struct DrawElementsIndirectCommand;
+
+    // CPU version of cull.comp and hiz.comp. Same math on the same data layout, so it can be used
+    // to check what GPU culling should produce, without a GL context. Also SIMD frustum culling
+    // for when culling runs on the CPU.
+    namespace culling {
+        // Planes point inwards and are normalized: left, right, bottom, top, near, far.
+        struct Frustum {
+            static Frustum from_matrix(const glm::mat4 &pv);
+            bool intersects(glm::vec4 sphere) const;
+
+            std::array<glm::vec4, 6> planes;
+        };
+
+        // Max-reduced depth pyramid, level 0 is the depth buffer itself.
+        struct HiZPyramid {
+            void build(std::span<const float> depth, uint32_t width, uint32_t height);
+
+            uint32_t width(uint32_t level) const { return std::max(_width >> level, 1u); }
+            uint32_t height(uint32_t level) const { return std::max(_height >> level, 1u); }
+            uint32_t levels() const { return (uint32_t)_levels.size(); }
+            float texel(uint32_t level, uint32_t x, uint32_t y) const {
+                return _levels[level][y * width(level) + x];
+            }
+
+            // True if a world space sphere is behind what was already drawn to the depth buffer.
+            bool occludes(const glm::mat4 &pv, glm::vec4 sphere) const;
+
+          private:
+            uint32_t _width{0u}, _height{0u};
+            std::vector<std::vector<float>> _levels;
+        };
+
+        // World space bounding spheres, one contiguous array per component, so the SIMD paths
+        // load 4 or 8 spheres with a single instruction.
+        struct SphereSoA {
+            void resize(size_t n) {
+                x.resize(n);
+                y.resize(n);
+                z.resize(n);
+                r.resize(n);
+            }
+            void set(size_t i, glm::vec4 s) {
+                x[i] = s.x;
+                y[i] = s.y;
+                z[i] = s.z;
+                r[i] = s.w;
+            }
+            size_t size() const { return x.size(); }
+
+            std::vector<float> x, y, z, r;
+        };
+
+        // Write indices of spheres intersecting the frustum to out in increasing order and return
+        // how many there are. out needs room for spheres.size() indices. All paths give the same
+        // result as Frustum::intersects.
+        uint32_t frustum_cull_scalar(const Frustum &f, const SphereSoA &spheres, uint32_t *out);
+        uint32_t frustum_cull_sse(const Frustum &f, const SphereSoA &spheres, uint32_t *out);
+        // Only call with has_avx(), there is no check inside.
+        uint32_t frustum_cull_avx(const Frustum &f, const SphereSoA &spheres, uint32_t *out);
+        // Widest of the above that the CPU supports.
+        uint32_t frustum_cull(const Frustum &f, const SphereSoA &spheres, uint32_t *out);
+        // True if the CPU and OS support AVX.
+        bool has_avx();
+
+        // Moves the sphere (center xyz, radius w) into world space, scaling radius by the largest
+        // axis scale of the transform.
+        glm::vec4 transform_sphere(const glm::mat4 &transform, glm::vec4 sphere);
+
+        // Level of detail for a world space sphere whose mesh has bounds radius mesh_radius: the
+        // coarsest level whose error, scaled like the sphere and seen from its nearest point,
+        // is at most 1 / lod_factor. errors holds the mesh space error of every level, FLT_MAX
+        // for levels the mesh does not have.
+        uint32_t select_lod(glm::vec4 sphere,
+                            float mesh_radius,
+                            glm::vec3 camera,
+                            glm::vec4 errors,
+                            float lod_factor);
+
+        // Commands should come with instance_count zeroed, MAX_LODS of them per batch. For every
+        // instance that passes, picks its LOD, bumps instance_count of the batch's command for
+        // it and writes instance index to visible[base_instance + slot], like the compute shader
+        // does with atomicAdd. Visible instances keep their relative order, unlike on the GPU.
+        void cull_instances(std::span<DrawElementsIndirectCommand> commands,
+                            std::span<const glm::mat4> transforms,
+                            std::span<const uint32_t> instance_batches,
+                            std::span<const glm::vec4> batch_bounds,
+                            std::span<const glm::vec4> batch_lod_errors,
+                            const glm::mat4 &pv,
+                            glm::vec3 camera,
+                            float lod_factor,
+                            const HiZPyramid *hiz,
+                            std::span<uint32_t> visible);
+
+        // True if every triangle of the meshlet faces away from camera, both in mesh space.
+        bool cone_culled(const Meshlet &meshlet, glm::vec3 camera);
+
+        // cluster_cull.comp for one instance drawn at LOD 0: writes indices of meshlets that
+        // intersect the frustum (unless it is null) and are not facing away from the world space
+        // camera to out, in order, and returns how many there are. out needs room for
+        // meshlets.size() indices.
+        uint32_t cull_meshlets(std::span<const Meshlet> meshlets,
+                               const glm::mat4 &transform,
+                               const Frustum *frustum,
+                               glm::vec3 camera,
+                               uint32_t *out);
+    } // namespace culling
+} // namespace eng
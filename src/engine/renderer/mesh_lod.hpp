@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace eng {
+    // Draw commands per indirect batch, one for every LOD a mesh can have.
+    inline constexpr uint32_t MAX_LODS{4u};
+
+    // Range of a mesh's index data drawn for one level of detail. All levels index the same
+    // vertices, LOD 0 is the full mesh.
+    struct MeshLod {
+        uint32_t first_index{0u}, index_count{0u};
+        // How far, in mesh space, the level's surface may be from the full mesh.
+        float error{0.f};
+    };
+} // namespace eng
@@ -0,0 +1,168 @@
+#include "renderer.hpp"
+
+#include <numeric>
+#include <algorithm>
+
+#include <engine/engine.hpp>
+
+namespace eng {
+    void MeshPass::refresh() {
+        auto gpu = Engine::instance().get_gpu_res_mgr();
+
+        std::vector<FlatBatch> added;
+        std::vector<uint32_t> removed_batch_ids;
+        // Old dense index of a pass object -> its index after removals, UINT32_MAX if removed.
+        std::vector<uint32_t> remap;
+
+        if (to_remove.empty() == false) {
+            std::sort(to_remove.begin(), to_remove.end());
+            std::erase_if(unbatched, [this](auto h) {
+                return std::binary_search(to_remove.begin(), to_remove.end(), h);
+            });
+
+            std::vector<Handle<PassObject>> erased;
+            for (auto i = 0u; i < pass_objects.size(); ++i) {
+                const auto &po = pass_objects.get_dense(i);
+                if (std::binary_search(to_remove.begin(), to_remove.end(), po.render_object)
+                    == false) {
+                    continue;
+                }
+                removed_batch_ids.push_back(po.batch_id);
+                erased.push_back(pass_objects.handle_at(i));
+            }
+            to_remove.clear();
+
+            remap.resize(pass_objects.size());
+            std::iota(remap.begin(), remap.end(), 0u);
+            auto origin = remap;
+            for (const auto h : erased) {
+                const auto idx     = pass_objects.erase(h);
+                const auto moved   = (uint32_t)pass_objects.size();
+                remap[origin[idx]] = UINT32_MAX;
+                origin[idx]        = origin[moved];
+                if (idx != moved) { remap[origin[idx]] = idx; }
+            }
+        }
+
+        for (const auto h_ro : unbatched) {
+            auto &ro = *gpu->get_resource(h_ro);
+
+            PassObject po{
+                PassMaterial{
+                    .prog
+                    = gpu->get_resource(ro.material)->passes.at(RenderPass::Forward)->res_handle()},
+                ro.mesh,
+                h_ro,
+                get_batch_id(ro.mesh, ro.material)};
+
+            added.emplace_back(po.batch_id,
+                               pass_objects.dense_index(pass_objects.insert(std::move(po))));
+        }
+        unbatched.clear();
+
+        if (batching_mode == BatchingMode::Full || flat_batches.empty()) {
+            _rebuild_batches();
+        } else {
+            _merge_batches(std::move(added), std::move(removed_batch_ids), remap);
+        }
+
+        multi_batches.clear();
+        if (indirect_batches.empty() == false) {
+            multi_batches.push_back(
+                MultiBatch{.first = 0, .count = (uint32_t)indirect_batches.size()});
+        }
+    }
+
+    void MeshPass::_rebuild_batches() {
+        flat_batches.clear();
+        indirect_batches.clear();
+
+        for (auto i = 0u; i < pass_objects.size(); ++i) {
+            flat_batches.emplace_back(pass_objects.get_dense(i).batch_id, i);
+        }
+
+        std::sort(flat_batches.begin(), flat_batches.end(), [](auto &&a, auto &&b) {
+            return a.batch_id < b.batch_id;
+        });
+
+        for (auto i = 0u; i < flat_batches.size(); ++i) {
+            const auto &fb = flat_batches[i];
+            if (i > 0u && fb.batch_id == flat_batches[i - 1].batch_id) {
+                indirect_batches.back().count++;
+                continue;
+            }
+            const auto &po = get_pass_object(fb.object);
+            indirect_batches.push_back(IndirectBatch{.mesh     = po.mesh,
+                                                     .material = po.mat,
+                                                     .first    = i,
+                                                     .count    = 1,
+                                                     .batch_id = fb.batch_id});
+        }
+    }
+
+    void MeshPass::_merge_batches(std::vector<FlatBatch> &&added,
+                                  std::vector<uint32_t> &&removed_batch_ids,
+                                  const std::vector<uint32_t> &remap) {
+        const auto by_batch_id = [](auto &&a, auto &&b) { return a.batch_id < b.batch_id; };
+
+        std::sort(added.begin(), added.end(), by_batch_id);
+        std::sort(removed_batch_ids.begin(), removed_batch_ids.end());
+
+        if (remap.empty() == false) {
+            auto out = flat_batches.begin();
+            for (auto &fb : flat_batches) {
+                if (remap[fb.object] == UINT32_MAX) { continue; }
+                *out = FlatBatch{fb.batch_id, remap[fb.object]};
+                ++out;
+            }
+            flat_batches.erase(out, flat_batches.end());
+        }
+
+        const auto old_size = flat_batches.size();
+        flat_batches.insert(flat_batches.end(), added.begin(), added.end());
+        std::inplace_merge(flat_batches.begin(),
+                           flat_batches.begin() + old_size,
+                           flat_batches.end(),
+                           by_batch_id);
+
+        // Walk the old indirect batches alongside the sorted deltas: batches that did not change
+        // keep their mesh/material and only get their first index shifted.
+        std::vector<IndirectBatch> patched;
+        patched.reserve(indirect_batches.size() + added.size());
+
+        auto add_it = added.begin();
+        auto rem_it = removed_batch_ids.begin();
+        auto ib_it  = indirect_batches.begin();
+        uint32_t first{0u};
+        while (ib_it != indirect_batches.end() || add_it != added.end()) {
+            uint32_t bid = UINT32_MAX;
+            if (ib_it != indirect_batches.end()) { bid = ib_it->batch_id; }
+            if (add_it != added.end()) { bid = std::min(bid, add_it->batch_id); }
+
+            IndirectBatch ib;
+            if (ib_it != indirect_batches.end() && ib_it->batch_id == bid) {
+                ib = *ib_it++;
+            } else {
+                const auto &po = get_pass_object(add_it->object);
+                ib = IndirectBatch{
+                    .mesh = po.mesh, .material = po.mat, .first = 0, .count = 0, .batch_id = bid};
+            }
+
+            for (; add_it != added.end() && add_it->batch_id == bid; ++add_it) { ib.count++; }
+            for (; rem_it != removed_batch_ids.end() && *rem_it == bid; ++rem_it) { ib.count--; }
+
+            if (ib.count == 0u) { continue; }
+
+            ib.first = first;
+            first += ib.count;
+            patched.push_back(ib);
+        }
+
+        indirect_batches = std::move(patched);
+    }
+
+    uint32_t MeshPass::get_batch_id(Handle<Mesh> mesh, Handle<Material> mat) {
+        const auto key = ((uint64_t)mesh.id << 32) | (uint64_t)mat.id;
+        return _batch_ids.try_emplace(key, (uint32_t)_batch_ids.size()).first->second;
+    }
+} // namespace eng
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace eng {
+    inline constexpr uint32_t MESHLET_MAX_VERTICES{64u};
+    inline constexpr uint32_t MESHLET_MAX_TRIANGLES{124u};
+
+    // Cluster of up to 64 vertices and 124 triangles of a mesh's full detail level, culled on
+    // its own when an instance is close enough to draw LOD 0. std430 layout, cluster_cull.comp
+    // reads it as is.
+    struct Meshlet {
+        // Mesh space, center xyz and radius w.
+        glm::vec4 sphere{0.f};
+        // Average triangle normal xyz and w the sine of the angle between it and the normal
+        // farthest from it. Seen from any point p with
+        //   dot(center - p, axis) >= w * length(center - p) + radius
+        // all triangles face away. w of 1 never passes, for clusters that bend too much.
+        glm::vec4 cone{0.f, 0.f, 0.f, 1.f};
+        // Range of the mesh's indices, inside LOD 0.
+        uint32_t first_index{0u}, index_count{0u};
+        uint32_t _pad[2]{};
+    };
+    static_assert(sizeof(Meshlet) == 48u);
+} // namespace eng
@@ -3,6 +3,8 @@
 #include <engine/engine.hpp>
 
 namespace eng {
+    static const UniformHandle<float> U_PRIMARY{"primary"};
+
     PostprocessBloom::PostprocessBloom(uint32_t number_of_passes) : _pass_num{number_of_passes} {
         for (auto i = 0u; i < _pass_num; ++i) {
             _pass_textures.push_back(Engine::instance().get_gpu_res_mgr()->create_resource(
@@ -43,12 +45,12 @@ namespace eng {
                 auto txt = _pass_textures[i];
                 _pass_fbo.update_attachments(
                     {FramebufferAttachment{GL_COLOR_ATTACHMENT0, txt->res_handle()}});
-                up_sample->set("primary", 0.0f);
+                up_sample->set(U_PRIMARY, 0.0f);
                 glViewport(0, 0, txt->get_size().first, txt->get_size().second);
             } else {
                 _pass_fbo.update_attachments(
                     {FramebufferAttachment{GL_COLOR_ATTACHMENT0, hdr_color->res_handle()}});
-                up_sample->set("primary", 1.0f);
+                up_sample->set(U_PRIMARY, 1.0f);
                 glViewport(0, 0, 1920, 1080);
             }
 
@@ -1,4 +1,10 @@
 #include "renderer.hpp"
+
+#include <numeric>
+#include <cstddef>
+#include <limits>
+#include <cmath>
+
 #include <engine/engine.hpp>
 
 eng::Renderer::Renderer() {
@@ -10,20 +16,40 @@ eng::Renderer::Renderer() {
     depth_stencil_texture = g->create_resource(
         Texture{TextureSettings{GL_DEPTH24_STENCIL8, GL_CLAMP_TO_EDGE, GL_LINEAR, 1},
                 TextureImageDataDescriptor{"", 1920, 1080}});
+    hiz_levels  = (uint32_t)std::log2(std::max(1920, 1080)) + 1u;
+    hiz_texture = g->create_resource(
+        Texture{TextureSettings{GL_R32F, GL_CLAMP_TO_EDGE, GL_NEAREST, hiz_levels},
+                TextureImageDataDescriptor{"", 1920, 1080}});
     render_fbo = Framebuffer{
         {FramebufferAttachment{GL_COLOR_ATTACHMENT0, color_texture->res_handle()},
          FramebufferAttachment{GL_DEPTH_STENCIL_ATTACHMENT, depth_stencil_texture->res_handle()}}};
 
-    commands_buffer  = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
-    geometry_buffer  = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
-    index_buffer     = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
-    mesh_data_buffer = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
-    mesh_vao = g->create_resource(GLVao{{GLVaoBinding{0, geometry_buffer->res_handle(), 48, 0}},
-                                        {GLVaoAttribute{0, 0, 3, 0},
-                                         GLVaoAttribute{1, 0, 3, 0},
-                                         GLVaoAttribute{2, 0, 3, 0},
-                                         GLVaoAttribute{3, 0, 3, 0}},
-                                        index_buffer->res_handle()});
+    commands_buffer = g->create_resource(
+        GLRingBuffer{1024u * MAX_LODS * sizeof(DrawElementsIndirectCommand)});
+    geometry_buffer           = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    index_buffer              = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    mesh_data_buffer          = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    material_table_buffer     = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    visible_instances_buffer  = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    instance_batches_buffer   = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    batch_bounds_buffer       = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    batch_lods_buffer         = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    transform_updates_buffer  = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    batch_quantization_buffer = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    meshlets_buffer           = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    batch_clusters_buffer     = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    cluster_work_buffer       = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    cluster_commands_buffer   = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    cluster_counts_buffer     = g->create_resource(GLBuffer{GL_DYNAMIC_STORAGE_BIT});
+    mesh_vao                  = g->create_resource(GLVao{
+        {GLVaoBinding{0, geometry_buffer->res_handle(), VERTEX_STRIDE, 0}},
+        {GLVaoAttribute{0, 0, 3, offsetof(PackedVertex, position), ATTR_FORMAT::SHORT, true},
+         GLVaoAttribute{1, 0, 2, offsetof(PackedVertex, uv), ATTR_FORMAT::SHORT, true},
+         GLVaoAttribute{
+             2, 0, 4, offsetof(PackedVertex, tangent), ATTR_FORMAT::INT_2_10_10_10_REV, true},
+         GLVaoAttribute{
+             3, 0, 4, offsetof(PackedVertex, bitangent), ATTR_FORMAT::INT_2_10_10_10_REV, true}},
+        index_buffer->res_handle()});
     geometry_buffer->on_handle_change.connect([=](auto nh) { mesh_vao->update_binding(0, nh); });
     index_buffer->on_handle_change.connect([=](auto nh) { mesh_vao->update_ebo(nh); });
 
@@ -35,83 +61,35 @@ eng::Renderer::Renderer() {
     }
     quad_vao = g->create_resource(
         GLVao{{GLVaoBinding{0, quad_buffer->res_handle(), 8, 0}}, {GLVaoAttribute{0, 0, 2, 0}}});
-    quad_shader = ShaderProgram{"quad"};
+    quad_shader          = ShaderProgram{"quad"};
+    cull_program         = g->create_resource(ShaderProgram{"cull"});
+    cluster_cull_program = g->create_resource(ShaderProgram{"cluster_cull"});
+    hiz_program          = g->create_resource(ShaderProgram{"hiz"});
+    scatter_program      = g->create_resource(ShaderProgram{"scatter"});
 
     bloom = new PostprocessBloom{4};
 }
 
 namespace eng {
-    void MeshPass::refresh(Renderer *r) {
-        auto gpu = Engine::instance().get_gpu_res_mgr();
-
-        while (unbatched.empty() == false) {
-            auto h_ro = unbatched.front();
-            unbatched.erase(unbatched.begin());
-            auto &ro = *gpu->get_resource(h_ro);
-
-            PassObject po{
-                PassMaterial{
-                    .prog
-                    = gpu->get_resource(ro.material)->passes.at(RenderPass::Forward)->res_handle()},
-                ro.mesh,
-                h_ro};
-
-            pass_objects.push_back(po);
-        }
-
-        flat_batches.clear();
-        indirect_batches.clear();
-        multi_batches.clear();
-
-        for (const auto &po : pass_objects) {
-            auto &ro = *gpu->get_resource(po.render_object);
-            flat_batches.emplace_back(get_batch_id(po.mesh, ro.material),
-                                      Handle<PassObject>(po.id));
-        }
-
-        std::sort(flat_batches.begin(), flat_batches.end(), [](auto &&a, auto &&b) {
-            return a.batch_id < b.batch_id;
-        });
-
-        FlatBatch *prev_fb = &flat_batches[0];
-        {
-            IndirectBatch ib{.mesh     = get_pass_object(prev_fb->object).mesh,
-                             .material = get_pass_object(prev_fb->object).mat,
-                             .first    = 0,
-                             .count    = 1};
-            indirect_batches.push_back(ib);
-        }
-        IndirectBatch *curr_ib = &indirect_batches[0];
-        for (auto i = 1u; i < flat_batches.size(); ++i) {
-            auto &fb = flat_batches[i];
-            if (fb.batch_id != prev_fb->batch_id) {
-                IndirectBatch ib{.mesh     = get_pass_object(fb.object).mesh,
-                                 .material = get_pass_object(fb.object).mat,
-                                 .first    = i,
-                                 .count    = 1};
-                indirect_batches.push_back(ib);
-                curr_ib = &indirect_batches.back();
-                prev_fb = &fb;
-                continue;
-            }
-            prev_fb = &fb;
-            curr_ib->count++;
+    // Camera uniforms of the forward pass programs.
+    static const UniformHandle<glm::mat4> U_VIEW{"v"}, U_PROJECTION{"p"};
+    static const UniformHandle<glm::vec3> U_VIEW_VEC{"view_vec"}, U_VIEW_POS{"view_pos"};
+
+    // What shaders store of an affine transform: its first three rows, the last one is always
+    // 0 0 0 1.
+    static std::array<float, 12> affine_rows(const glm::mat4 &m) {
+        std::array<float, 12> rows;
+        for (auto r = 0u; r < 3u; ++r) {
+            for (auto c = 0u; c < 4u; ++c) { rows[r * 4u + c] = m[c][r]; }
         }
-
-        multi_batches.push_back(MultiBatch{.first = 0, .count = (uint32_t)indirect_batches.size()});
-
-        return;
+        return rows;
     }
 
-    uint32_t MeshPass::get_batch_id(Handle<Mesh> mesh, Handle<Material> mat) {
-        auto it = std::find(_batch_ids.begin(), _batch_ids.end(), std::make_pair(mesh, mat));
-
-        if (it == _batch_ids.end()) {
-            _batch_ids.push_back(std::make_pair(mesh, mat));
-            it = _batch_ids.end() - 1;
-        }
-
-        return std::distance(_batch_ids.begin(), it);
+    // Channel metallic or roughness is read from. Single channel textures, baked BC4 ones among
+    // them, only have red.
+    static uint32_t material_channel(const Texture *texture, uint32_t channel) {
+        const auto format = texture->format();
+        return format == GL_R8 || format == GL_COMPRESSED_RED_RGTC1 ? 0u : channel;
     }
 
     void Renderer::register_object(const Object *o) {
@@ -121,7 +99,7 @@ namespace eng {
                 RenderObject{o->id, m.res_handle(), m.material, m.transform});
 
             _dirty_objects.emplace_back(ro->res_handle());
-            _mesh_instance_count[m.id]++;
+            if (_mesh_instance_count[m.id]++ == 0u) { _allocate_geometry(m); }
 
             if (gpu->get_resource(m.material)->passes.contains(RenderPass::Forward)) {
                 _forward_pass.unbatched.push_back(Handle<RenderObject>{ro->res_handle()});
@@ -129,115 +107,260 @@ namespace eng {
         }
     }
 
-    void Renderer::render() {
+    void Renderer::unregister_object(const Object *o) {
         auto gpu = Engine::instance().get_gpu_res_mgr();
 
-        if (_dirty_objects.empty() == false) {
-            _dirty_objects.clear();
+        std::vector<Handle<RenderObject>> removed;
+        for (const auto ro : gpu->get_storage<RenderObject>()) {
+            if (ro->object_id == o->id) { removed.push_back(ro->res_handle()); }
+        }
 
-            std::unordered_map<uint32_t, uint32_t> offsets;
-
-            struct alignas(16) Payload {
-                uint64_t diffuse;
-                uint64_t normal;
-                uint64_t metallic;
-                uint64_t roughness;
-                uint64_t emissive;
-                uint64_t _1;
-                glm::vec4 texture_channels;
-                glm::mat4 transform;
-            };
+        for (const auto h : removed) {
+            auto &ro = *gpu->get_resource(h);
+            if (--_mesh_instance_count[ro.mesh.id] == 0u) { _free_geometry(ro.mesh); }
+            if (gpu->get_resource(ro.material)->passes.contains(RenderPass::Forward)) {
+                _forward_pass.remove(h);
+            }
+            _dirty_objects.push_back(h);
+            gpu->destroy_resource(h);
+        }
+    }
 
-            std::vector<Payload> mesh_data;
-            std::vector<uint64_t> mesh_bindless_handle;
+    void Renderer::_allocate_geometry(const Mesh &m) {
+        const auto indices = m.index_data();
+
+        VertexQuantization quantization;
+        std::vector<PackedVertex> packed;
+        std::span<const PackedVertex> vertices;
+        if (m.backing) {
+            quantization = m.mapped_quantization;
+            vertices     = m.mapped_vertices;
+        } else {
+            quantization = vertex_format::quantization(m.vertices);
+            packed.resize(m.vertices.size() / vertex_format::FLOATS_PER_VERTEX);
+            vertex_format::pack(m.vertices, quantization, packed.data());
+            vertices = packed;
+        }
 
-            auto &meshes      = gpu->get_storage<Mesh>();
-            auto &renderables = gpu->get_storage<RenderObject>();
+        MeshGeometry geom{.vertices     = _vertex_allocator.allocate((uint32_t)vertices.size()),
+                          .indices      = _index_allocator.allocate((uint32_t)indices.size()),
+                          .meshlets     = {},
+                          .bounds       = glm::vec4{0.f},
+                          .quantization = quantization,
+                          .lods         = {},
+                          .lod_count    = 1u,
+                          .meshlet_copy = {}};
+
+        const auto lods = m.lod_data();
+        if (lods.empty()) {
+            geom.lods[0] = MeshLod{
+                .first_index = 0u, .index_count = (uint32_t)indices.size(), .error = 0.f};
+        } else {
+            geom.lod_count = (uint32_t)std::min<size_t>(lods.size(), MAX_LODS);
+            std::copy_n(lods.begin(), geom.lod_count, geom.lods.begin());
+        }
 
-            mesh_data.resize(gpu->count<RenderObject>());
-            mesh_bindless_handle.resize(gpu->count<RenderObject>());
+        if (const auto meshlets = m.meshlet_data(); meshlets.size() > 1u) {
+            geom.meshlets     = _meshlet_allocator.allocate((uint32_t)meshlets.size());
+            geom.meshlet_copy = {meshlets.begin(), meshlets.end()};
+            meshlets_buffer->write_data(geom.meshlets.offset * sizeof(Meshlet),
+                                        meshlets.data(),
+                                        meshlets.size() * sizeof(Meshlet));
+        }
 
-            offsets[meshes[0]->id] = 0;
-            for (auto i = 1u, prev_offset = 0u; i < meshes.size(); ++i) {
-                const auto &m0    = *meshes[i - 1];
-                const auto &m1    = *meshes[i];
-                const auto offset = _mesh_instance_count.at(m0.id) + prev_offset;
-                offsets[m1.id]    = offset;
-                prev_offset       = offset;
+        geometry_buffer->write_data(geom.vertices.offset * VERTEX_STRIDE,
+                                    vertices.data(),
+                                    vertices.size() * sizeof(PackedVertex));
+        index_buffer->write_data(geom.indices.offset * sizeof(unsigned),
+                                 indices.data(),
+                                 indices.size() * sizeof(unsigned));
+
+        // Bounds of what the GPU will see, after quantization.
+        if (vertices.empty() == false) {
+            const auto center = glm::vec3{quantization.position_offset};
+            float radius{0.f};
+            for (const auto &v : vertices) {
+                const auto p = vertex_format::unpack_position(v, quantization);
+                radius       = std::max(radius, glm::distance(center, p));
             }
+            geom.bounds = glm::vec4{center, radius};
+        }
 
-            for (const auto r : gpu->get_storage<RenderObject>()) {
-                const auto offset = offsets.at(r->mesh.id)++;
-                const auto &mesh  = *gpu->get_resource(r->mesh);
-                auto material     = gpu->get_resource(mesh.material);
-                material->textures.at(TextureType::Diffuse)->make_resident();
-                material->textures.at(TextureType::Normal)->make_resident();
-                material->textures.at(TextureType::Metallic)->make_resident();
-                material->textures.at(TextureType::Roughness)->make_resident();
-                material->textures.at(TextureType::Emissive)->make_resident();
-
-                mesh_data[offset] = {
-                    material->textures.at(TextureType::Diffuse)->bindless_handle(),
-                    material->textures.at(TextureType::Normal)->bindless_handle(),
-                    material->textures.at(TextureType::Metallic)->bindless_handle(),
-                    material->textures.at(TextureType::Roughness)->bindless_handle(),
-                    material->textures.at(TextureType::Emissive)->bindless_handle(),
-                    0,
-                    glm::vec4{0.f, 0.f, 1.f, 0.f},
-                    r->transform,
-                };
-
-                ENG_DEBUG("Inserting %i at %i\n", mesh.id, offset);
-            }
+        _mesh_geometry[m.id] = geom;
+    }
 
-            mesh_data_buffer->clear_invalidate();
-            mesh_data_buffer->push_data(mesh_data.data(), mesh_data.size() * sizeof(Payload));
+    void Renderer::_free_geometry(Handle<Mesh> mesh) {
+        auto it = _mesh_geometry.find(mesh.id);
+        _vertex_allocator.free(it->second.vertices);
+        _index_allocator.free(it->second.indices);
+        _meshlet_allocator.free(it->second.meshlets);
+        _mesh_geometry.erase(it);
+    }
 
-            std::vector<float> mesh_vertices;
-            std::vector<unsigned> mesh_indices;
-            for (const auto m : meshes) {
-                mesh_vertices.insert(mesh_vertices.end(), m->vertices.begin(), m->vertices.end());
-                mesh_indices.insert(mesh_indices.end(), m->indices.begin(), m->indices.end());
-            }
+    void Renderer::render() {
+        auto gpu       = Engine::instance().get_gpu_res_mgr();
+        const auto &fp = _forward_pass;
 
-            geometry_buffer->clear_invalidate();
-            geometry_buffer->push_data(mesh_vertices.data(), mesh_vertices.size() * sizeof(float));
+        if (_forward_pass.needs_refresh()) { _forward_pass.refresh(); }
 
-            index_buffer->clear_invalidate();
-            index_buffer->push_data(mesh_indices.data(), mesh_indices.size() * sizeof(unsigned));
-        }
+        // Textures that finished streaming in have new bindless handles for the material table.
+        const auto textures_ready = Engine::instance().get_texture_loader()->update() > 0u;
 
-        if (_forward_pass.unbatched.empty() == false) { _forward_pass.refresh(this); }
+        // Usage comes from the instances as they were laid out last frame, before they may get
+        // rebuilt below, so textures that come back into view are resident by the time they are
+        // drawn.
+        const auto camera = Engine::instance().get_camera();
+        const auto pv     = camera->perspective_matrix() * camera->view_matrix();
+        _track_texture_usage(pv);
+        const auto residency_changed = texture_residency.update();
 
-        struct DrawElementsIndirectCommandExtended : public DrawElementsIndirectCommand {
-            DrawElementsIndirectCommandExtended() = default;
-            DrawElementsIndirectCommandExtended(const DrawElementsIndirectCommand *cmd,
-                                                uint32_t vertex_count) {
-                *static_cast<DrawElementsIndirectCommand *>(this) = *cmd;
-                this->vertex_count                                = vertex_count;
+        const auto rebuild = _dirty_objects.empty() == false;
+        if (rebuild) {
+            _dirty_objects.clear();
+            _dirty_instances.clear();
+            _instance_index.clear();
+            _visible_count = 0u;
+
+            std::vector<InstanceData> mesh_data(fp.flat_batches.size());
+            std::vector<glm::vec4> batch_bounds(fp.indirect_batches.size());
+            std::vector<VertexQuantization> batch_quantization(fp.indirect_batches.size());
+            _instance_batches.resize(fp.flat_batches.size());
+            _batch_lod_errors.resize(fp.indirect_batches.size());
+            _batch_clusters.resize(fp.indirect_batches.size());
+            _batch_materials.resize(fp.indirect_batches.size());
+            _instance_transforms.resize(fp.flat_batches.size());
+            _instance_bounds.resize(fp.flat_batches.size());
+
+            // Instances are laid out in flat batch order, so every indirect batch owns
+            // [first, first + count) of them.
+            for (auto i = 0u; i < fp.indirect_batches.size(); ++i) {
+                const auto &ib        = fp.indirect_batches[i];
+                const auto &geom      = _mesh_geometry.at(ib.mesh.id);
+                batch_bounds[i]       = geom.bounds;
+                batch_quantization[i] = geom.quantization;
+                _batch_materials[i]   = gpu->get_resource(ib.mesh)->material;
+                for (auto lod = 0u; lod < MAX_LODS; ++lod) {
+                    _batch_lod_errors[i][lod] = lod < geom.lod_count
+                                                    ? geom.lods[lod].error
+                                                    : std::numeric_limits<float>::max();
+                }
+                std::fill_n(_instance_batches.begin() + ib.first, ib.count, i);
+            }
+
+            // Any instance of a batch may end up drawing all of its meshlets, so every multi
+            // batch gets room for that many cluster commands.
+            _cluster_draw_ranges.resize(fp.multi_batches.size());
+            _cluster_draw_budget = 0u;
+            for (auto k = 0u; k < fp.multi_batches.size(); ++k) {
+                const auto &mb         = fp.multi_batches[k];
+                _cluster_draw_ranges[k] = RangeAllocator::Range{_cluster_draw_budget, 0u};
+                for (auto i = mb.first; i < mb.first + mb.count; ++i) {
+                    const auto &ib     = fp.indirect_batches[i];
+                    const auto &geom   = _mesh_geometry.at(ib.mesh.id);
+                    _batch_clusters[i] = BatchClusters{.first_meshlet = geom.meshlets.offset,
+                                                       .meshlet_count = geom.meshlets.size,
+                                                       .first_index   = geom.indices.offset,
+                                                       .base_vertex   = geom.vertices.offset,
+                                                       .draw_offset   = _cluster_draw_budget,
+                                                       .multi_batch   = k};
+                    _cluster_draw_ranges[k].size += ib.count * geom.meshlets.size;
+                }
+                _cluster_draw_budget += _cluster_draw_ranges[k].size;
+            }
+            _cluster_commands.resize(_cluster_draw_budget);
+            _cluster_draw_counts.resize(fp.multi_batches.size());
+
+            // Every material used gets one entry of the material table, instances only keep its
+            // index. Residency is counted per material as well.
+            std::unordered_map<uint32_t, TextureResidency::MaterialTextures> materials;
+            std::unordered_map<uint32_t, uint32_t> material_slots;
+            std::vector<uint32_t> batch_material_slots(fp.indirect_batches.size());
+            _material_ids.clear();
+            for (auto i = 0u; i < _batch_materials.size(); ++i) {
+                const auto id = _batch_materials[i];
+                const auto [slot, inserted]
+                    = material_slots.try_emplace(id, (uint32_t)_material_ids.size());
+                batch_material_slots[i] = slot->second;
+                if (inserted == false) { continue; }
+
+                _material_ids.push_back(id);
+                const auto &textures = gpu->get_resource(Handle<Material>{id})->textures;
+                auto &m              = materials[id];
+                for (auto t = 0u; t < m.size(); ++t) { m[t] = textures.at((TextureType)t); }
+            }
+            texture_residency.set_materials(materials);
+
+            for (auto i = 0u; i < fp.flat_batches.size(); ++i) {
+                const auto &po = fp.pass_objects.get_dense(fp.flat_batches[i].object);
+                const auto r   = gpu->get_resource(po.render_object);
+
+                mesh_data[i] = InstanceData{affine_rows(r->transform),
+                                            batch_material_slots[_instance_batches[i]]};
+                _instance_index[r->id]  = i;
+                _instance_transforms[i] = r->transform;
+                _instance_bounds.set(
+                    i,
+                    culling::transform_sphere(r->transform, _mesh_geometry.at(r->mesh.id).bounds));
             }
 
-            uint32_t vertex_count{0u};
-        } prev_cmd;
-
-        std::vector<DrawElementsIndirectCommand> draw_commands;
-
-        for (auto i = 0u; i < _forward_pass.indirect_batches.size(); ++i) {
-            const auto &ib = _forward_pass.indirect_batches[i];
-            const auto &m  = *gpu->get_resource(ib.mesh);
-            DrawElementsIndirectCommand cmd{
-                .count          = (uint32_t)m.indices.size(),
-                .instance_count = ib.count,
-                .first_index    = prev_cmd.first_index + prev_cmd.count,
-                .base_vertex    = prev_cmd.base_vertex + prev_cmd.vertex_count,
-                .base_instance  = prev_cmd.base_instance + prev_cmd.instance_count};
-            prev_cmd = DrawElementsIndirectCommandExtended{&cmd, (uint32_t)m.vertices.size() / 12u};
-            draw_commands.push_back(cmd);
+            mesh_data_buffer->clear_invalidate();
+            mesh_data_buffer->push_data(mesh_data.data(),
+                                        mesh_data.size() * sizeof(InstanceData));
+            instance_batches_buffer->clear_invalidate();
+            instance_batches_buffer->push_data(_instance_batches.data(),
+                                               _instance_batches.size() * sizeof(uint32_t));
+            batch_bounds_buffer->clear_invalidate();
+            batch_bounds_buffer->push_data(batch_bounds.data(),
+                                           batch_bounds.size() * sizeof(glm::vec4));
+            batch_lods_buffer->clear_invalidate();
+            batch_lods_buffer->push_data(_batch_lod_errors.data(),
+                                         _batch_lod_errors.size() * sizeof(glm::vec4));
+            batch_quantization_buffer->clear_invalidate();
+            batch_quantization_buffer->push_data(
+                batch_quantization.data(),
+                batch_quantization.size() * sizeof(VertexQuantization));
+            batch_clusters_buffer->clear_invalidate();
+            batch_clusters_buffer->push_data(_batch_clusters.data(),
+                                             _batch_clusters.size() * sizeof(BatchClusters));
+            visible_instances_buffer->reserve((mesh_data.size() * MAX_LODS + _cluster_draw_budget)
+                                              * sizeof(uint32_t));
+            cluster_work_buffer->reserve((4u + mesh_data.size()) * sizeof(uint32_t));
+            cluster_commands_buffer->reserve(_cluster_draw_budget
+                                             * sizeof(DrawElementsIndirectCommand));
+            cluster_counts_buffer->reserve(fp.multi_batches.size() * sizeof(uint32_t));
         }
 
-        commands_buffer->clear_invalidate();
-        commands_buffer->push_data(draw_commands.data(),
-                                   draw_commands.size() * sizeof(DrawElementsIndirectCommand));
+        // Streaming and residency only change handles, instances keep their material index.
+        if (rebuild || textures_ready || residency_changed) { _upload_materials(); }
+        if (_dirty_instances.empty() == false) { _upload_transforms(); }
+
+        // Commands start empty, culling fills in instance_count (and base_instance on CPU).
+        // Every indirect batch has one command per LOD, each with its own range of the visible
+        // list: LOD k of the batch starts at k * instance count + first.
+        commands_buffer->begin_frame();
+        auto draw_commands = static_cast<DrawElementsIndirectCommand *>(commands_buffer->allocate(
+            fp.indirect_batches.size() * MAX_LODS * sizeof(DrawElementsIndirectCommand)));
+
+        const auto instance_count = (uint32_t)fp.flat_batches.size();
+        for (auto i = 0u; i < fp.indirect_batches.size(); ++i) {
+            const auto &ib   = fp.indirect_batches[i];
+            const auto &geom = _mesh_geometry.at(ib.mesh.id);
+            for (auto lod = 0u; lod < MAX_LODS; ++lod) {
+                const auto &l = geom.lods[std::min(lod, geom.lod_count - 1u)];
+                draw_commands[i * MAX_LODS + lod] = DrawElementsIndirectCommand{
+                    .count          = l.index_count,
+                    .instance_count = 0u,
+                    .first_index    = geom.indices.offset + l.first_index,
+                    .base_vertex    = geom.vertices.offset,
+                    .base_instance  = lod * instance_count + ib.first};
+            }
+        }
+
+        if (culling_settings.mode == CullingMode::Gpu) {
+            _cull_gpu(pv);
+        } else {
+            _cull_cpu(pv, draw_commands);
+        }
 
         glEnable(GL_DEPTH_TEST);
         glEnable(GL_CULL_FACE);
@@ -247,20 +370,54 @@ namespace eng {
         render_fbo.bind();
         mesh_vao->bind();
         mesh_data_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 0);
-        commands_buffer->bind(GL_DRAW_INDIRECT_BUFFER);
+        visible_instances_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 1);
+        instance_batches_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 3);
+        batch_quantization_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 5);
+        material_table_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 11);
+        cluster_counts_buffer->bind(GL_PARAMETER_BUFFER);
         glViewport(0, 0, 1920, 1080);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-        for (const auto &mb : _forward_pass.multi_batches) {
+        // Uniforms stay with the GL program, multi-batches sharing one only bind it. Compared by
+        // GL name, use() may have swapped in a rebuilt program with none set.
+        const auto view = camera->view_matrix();
+        auto last_program{0u};
+        for (auto k = 0u; k < _forward_pass.multi_batches.size(); ++k) {
+            const auto &mb = _forward_pass.multi_batches[k];
             auto prog = gpu->get_resource(_forward_pass.indirect_batches[mb.first].material.prog);
             prog->use();
-            prog->set("v", Engine::instance().get_camera()->view_matrix());
-            prog->set("p", Engine::instance().get_camera()->perspective_matrix());
-            prog->set("view_vec", Engine::instance().get_camera()->forward_vec());
-            prog->set("view_pos", Engine::instance().get_camera()->position());
-            prog->use();
-            int draw_count = mb.first * sizeof(DrawElementsIndirectCommand);
+            if (prog->get_handle() != last_program) {
+                prog->set(U_VIEW, view);
+                prog->set(U_PROJECTION, camera->perspective_matrix());
+                prog->set(U_VIEW_VEC, camera->forward_vec());
+                prog->set(U_VIEW_POS, camera->position());
+                last_program = prog->get_handle();
+            }
+            const auto offset = commands_buffer->region_offset()
+                                + mb.first * MAX_LODS * sizeof(DrawElementsIndirectCommand);
+            commands_buffer->bind(GL_DRAW_INDIRECT_BUFFER);
             glMultiDrawElementsIndirect(
-                GL_TRIANGLES, GL_UNSIGNED_INT, (void *)draw_count, mb.count, 0);
+                GL_TRIANGLES, GL_UNSIGNED_INT, (void *)offset, mb.count * MAX_LODS, 0);
+
+            // Draw count comes from culling, so the CPU never reads back how many meshlets
+            // survived.
+            const auto &clusters = _cluster_draw_ranges[k];
+            if (culling_settings.clusters && clusters.size > 0u) {
+                cluster_commands_buffer->bind(GL_DRAW_INDIRECT_BUFFER);
+                glMultiDrawElementsIndirectCount(
+                    GL_TRIANGLES,
+                    GL_UNSIGNED_INT,
+                    (void *)(clusters.offset * sizeof(DrawElementsIndirectCommand)),
+                    (GLintptr)(k * sizeof(uint32_t)),
+                    (GLsizei)clusters.size,
+                    0);
+            }
+        }
+        commands_buffer->end_frame();
+
+        if (culling_settings.mode == CullingMode::Gpu && culling_settings.occlusion) {
+            _build_hiz();
+        } else {
+            _hiz_valid = false;
         }
 
         bloom->render(color_texture, quad_vao);
@@ -274,4 +431,310 @@ namespace eng {
         glDrawArrays(GL_TRIANGLES, 0, 6);
     }
 
+    void Renderer::set_transform(Handle<RenderObject> ro, const glm::mat4 &transform) {
+        Engine::instance().get_gpu_res_mgr()->get_resource(ro)->transform = transform;
+
+        // Full rebuild is pending and will pick up the new transform.
+        if (_dirty_objects.empty() == false) { return; }
+
+        if (auto it = _instance_index.find(ro.id); it != _instance_index.end()) {
+            _dirty_instances.push_back(it->second);
+        }
+    }
+
+    void Renderer::reload_shaders() {
+        auto gpu = Engine::instance().get_gpu_res_mgr();
+        for (auto p :
+             {&quad_shader, cull_program, cluster_cull_program, hiz_program, scatter_program}) {
+            p->recompile();
+        }
+
+        std::vector<uint32_t> forward;
+        for (const auto &ib : _forward_pass.indirect_batches) {
+            if (std::find(forward.begin(), forward.end(), ib.material.prog.id) != forward.end()) {
+                continue;
+            }
+            forward.push_back(ib.material.prog.id);
+            gpu->get_resource(ib.material.prog)->recompile();
+        }
+    }
+
+    void Renderer::_upload_materials() {
+        auto gpu = Engine::instance().get_gpu_res_mgr();
+
+        std::vector<MaterialData> table(_material_ids.size());
+        for (auto i = 0u; i < table.size(); ++i) {
+            const auto id        = _material_ids[i];
+            const auto &textures = gpu->get_resource(Handle<Material>{id})->textures;
+            const auto handle    = [&](TextureType t) {
+                return texture_residency.bindless_handle(id, t);
+            };
+            table[i] = MaterialData{
+                .diffuse           = handle(TextureType::Diffuse),
+                .normal            = handle(TextureType::Normal),
+                .metallic          = handle(TextureType::Metallic),
+                .roughness         = handle(TextureType::Roughness),
+                .emissive          = handle(TextureType::Emissive),
+                .metallic_channel  = material_channel(textures.at(TextureType::Metallic), 0u),
+                .roughness_channel = material_channel(textures.at(TextureType::Roughness), 1u)};
+        }
+
+        material_table_buffer->clear_invalidate();
+        material_table_buffer->push_data(table.data(), table.size() * sizeof(MaterialData));
+    }
+
+    void Renderer::_upload_transforms() {
+        auto gpu       = Engine::instance().get_gpu_res_mgr();
+        const auto &fp = _forward_pass;
+
+        std::sort(_dirty_instances.begin(), _dirty_instances.end());
+        _dirty_instances.erase(std::unique(_dirty_instances.begin(), _dirty_instances.end()),
+                               _dirty_instances.end());
+
+        std::vector<TransformUpdate> updates;
+        updates.reserve(_dirty_instances.size());
+        for (const auto i : _dirty_instances) {
+            const auto &po = fp.pass_objects.get_dense(fp.flat_batches[i].object);
+            const auto r   = gpu->get_resource(po.render_object);
+            updates.push_back(TransformUpdate{affine_rows(r->transform), i});
+            _instance_transforms[i] = r->transform;
+            _instance_bounds.set(
+                i, culling::transform_sphere(r->transform, _mesh_geometry.at(r->mesh.id).bounds));
+        }
+        _dirty_instances.clear();
+
+        // One small upload and a scatter on the GPU instead of a subdata call per instance -
+        // moving instances are rarely next to each other.
+        transform_updates_buffer->clear_invalidate();
+        transform_updates_buffer->push_data(updates.data(),
+                                            updates.size() * sizeof(TransformUpdate));
+
+        scatter_program->use();
+        scatter_program->set("update_count", (int)updates.size());
+        mesh_data_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 0);
+        transform_updates_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 1);
+        glDispatchCompute(((uint32_t)updates.size() + 63u) / 64u, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    void Renderer::_cull_gpu(const glm::mat4 &pv) {
+        const auto instance_count = (int)_forward_pass.flat_batches.size();
+        if (instance_count == 0) { return; }
+
+        const auto frustum = culling::Frustum::from_matrix(pv);
+
+        cull_program->use();
+        cull_program->set("pv", pv);
+        cull_program->set("planes", std::span<const glm::vec4>{frustum.planes});
+        cull_program->set("instance_count", instance_count);
+        cull_program->set("frustum_culling", (int)culling_settings.frustum);
+        cull_program->set("occlusion_culling", (int)(culling_settings.occlusion && _hiz_valid));
+        cull_program->set("camera_position", Engine::instance().get_camera()->position());
+        cull_program->set("lod_factor", _lod_factor());
+        cull_program->set("cluster_culling", (int)culling_settings.clusters);
+
+        // Dispatch of cluster_cull.comp starts at 0 workgroups of 1x1, cull.comp grows x.
+        const uint32_t work_header[4]{0u, 1u, 1u, 0u};
+        cluster_work_buffer->write_data(0u, work_header, sizeof(work_header));
+        _cluster_draw_counts.assign(_cluster_draw_counts.size(), 0u);
+        cluster_counts_buffer->write_data(
+            0u, _cluster_draw_counts.data(), _cluster_draw_counts.size() * sizeof(uint32_t));
+
+        mesh_data_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 0);
+        visible_instances_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 1);
+        commands_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 2);
+        instance_batches_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 3);
+        batch_bounds_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 4);
+        batch_lods_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 6);
+        batch_clusters_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 7);
+        cluster_work_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 8);
+        hiz_texture->bind(0);
+
+        glDispatchCompute((instance_count + 63) / 64, 1, 1);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+        if (culling_settings.clusters == false || _cluster_draw_budget == 0u) { return; }
+
+        cluster_cull_program->use();
+        cluster_cull_program->set("planes", std::span<const glm::vec4>{frustum.planes});
+        cluster_cull_program->set("frustum_culling", (int)culling_settings.frustum);
+        cluster_cull_program->set("camera_position", Engine::instance().get_camera()->position());
+        cluster_cull_program->set("visible_offset", instance_count * (int)MAX_LODS);
+
+        cluster_commands_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 2);
+        meshlets_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 9);
+        cluster_counts_buffer->bind_base(GL_SHADER_STORAGE_BUFFER, 10);
+        cluster_work_buffer->bind(GL_DISPATCH_INDIRECT_BUFFER);
+
+        glDispatchComputeIndirect(0);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    void Renderer::_track_texture_usage(const glm::mat4 &pv) {
+        // Culling on the CPU left the visible instances of last frame behind. On the GPU there
+        // is nothing to read back, so usage comes from a frustum test of its own, every few
+        // frames only. Occluded instances pass it and keep their textures resident.
+        const uint32_t *used{_visible_instances.data()};
+        uint32_t used_count{_visible_count};
+        if (culling_settings.mode == CullingMode::Gpu) {
+            if (++_usage_age < TEXTURE_USAGE_INTERVAL) { return; }
+            _usage_age = 0u;
+
+            const auto instance_count = (uint32_t)_instance_bounds.size();
+            _used_instances.resize(instance_count);
+            used       = _used_instances.data();
+            used_count = instance_count;
+            if (culling_settings.frustum) {
+                used_count = culling::frustum_cull(
+                    culling::Frustum::from_matrix(pv), _instance_bounds, _used_instances.data());
+            } else {
+                std::iota(_used_instances.begin(), _used_instances.end(), 0u);
+            }
+        }
+
+        // Visible instances come out sorted and batches own contiguous ranges of them, so every
+        // batch is touched once.
+        uint32_t last_batch{UINT32_MAX};
+        for (auto i = 0u; i < used_count; ++i) {
+            const auto batch = _instance_batches[used[i]];
+            if (batch == last_batch) { continue; }
+            texture_residency.touch(_batch_materials[batch]);
+            last_batch = batch;
+        }
+    }
+
+    void Renderer::_cull_cpu(const glm::mat4 &pv, DrawElementsIndirectCommand *commands) {
+        const auto &batches = _forward_pass.indirect_batches;
+        _visible_instances.resize(_instance_bounds.size());
+
+        const auto frustum     = culling::Frustum::from_matrix(pv);
+        uint32_t visible_count = (uint32_t)_visible_instances.size();
+        if (culling_settings.frustum) {
+            visible_count
+                = culling::frustum_cull(frustum, _instance_bounds, _visible_instances.data());
+        } else {
+            std::iota(_visible_instances.begin(), _visible_instances.end(), 0u);
+        }
+        _visible_count = visible_count;
+
+        // Visible indices come out sorted and every batch owns a contiguous range of instances,
+        // so one walk splits the list between batches. Inside a batch, instances are grouped by
+        // LOD into consecutive ranges of _culled_instances, one per LOD command. Instances that
+        // get drawn per meshlet are set aside and take no slot there.
+        const auto camera     = Engine::instance().get_camera()->position();
+        const auto lod_factor = _lod_factor();
+        _culled_instances.resize(visible_count);
+        _instance_lods.resize(_instance_bounds.size());
+        _clustered_instances.clear();
+        uint32_t out{0u};
+        for (auto i = 0u, v = 0u; i < batches.size(); ++i) {
+            const auto end = batches[i].first + batches[i].count;
+            const auto first_visible = v;
+            std::array<uint32_t, MAX_LODS> lod_counts{};
+            for (; v < visible_count && _visible_instances[v] < end; ++v) {
+                const auto inst = _visible_instances[v];
+                const glm::vec4 sphere{_instance_bounds.x[inst],
+                                       _instance_bounds.y[inst],
+                                       _instance_bounds.z[inst],
+                                       _instance_bounds.r[inst]};
+                const auto lod = culling::select_lod(sphere,
+                                                     _mesh_geometry.at(batches[i].mesh.id).bounds.w,
+                                                     camera,
+                                                     _batch_lod_errors[i],
+                                                     lod_factor);
+                if (lod == 0u && culling_settings.clusters
+                    && _batch_clusters[i].meshlet_count > 0u) {
+                    _clustered_instances.push_back(inst);
+                    _instance_lods[inst] = MAX_LODS;
+                    continue;
+                }
+                _instance_lods[inst] = lod;
+                lod_counts[lod]++;
+            }
+
+            std::array<uint32_t, MAX_LODS> lod_slot{};
+            for (auto lod = 0u; lod < MAX_LODS; ++lod) {
+                auto &c          = commands[i * MAX_LODS + lod];
+                c.base_instance  = out;
+                c.instance_count = lod_counts[lod];
+                lod_slot[lod]    = out;
+                out += lod_counts[lod];
+            }
+            for (auto k = first_visible; k < v; ++k) {
+                const auto inst = _visible_instances[k];
+                if (_instance_lods[inst] == MAX_LODS) { continue; }
+                _culled_instances[lod_slot[_instance_lods[inst]]++] = inst;
+            }
+        }
+
+        // Cluster commands follow the LOD ranges in the visible list, one entry each.
+        _culled_instances.resize(out);
+        std::fill(_cluster_draw_counts.begin(), _cluster_draw_counts.end(), 0u);
+        for (const auto inst : _clustered_instances) {
+            const auto &bc   = _batch_clusters[_instance_batches[inst]];
+            const auto &geom = _mesh_geometry.at(batches[_instance_batches[inst]].mesh.id);
+            _visible_meshlets.resize(geom.meshlet_copy.size());
+            const auto count = culling::cull_meshlets(geom.meshlet_copy,
+                                                      _instance_transforms[inst],
+                                                      culling_settings.frustum ? &frustum : nullptr,
+                                                      camera,
+                                                      _visible_meshlets.data());
+            for (auto k = 0u; k < count; ++k) {
+                const auto &m = geom.meshlet_copy[_visible_meshlets[k]];
+                _cluster_commands[bc.draw_offset + _cluster_draw_counts[bc.multi_batch]++]
+                    = DrawElementsIndirectCommand{.count          = m.index_count,
+                                                  .instance_count = 1u,
+                                                  .first_index    = bc.first_index + m.first_index,
+                                                  .base_vertex    = bc.base_vertex,
+                                                  .base_instance
+                                                  = (uint32_t)_culled_instances.size()};
+                _culled_instances.push_back(inst);
+            }
+        }
+
+        visible_instances_buffer->write_data(
+            0, _culled_instances.data(), _culled_instances.size() * sizeof(uint32_t));
+        for (auto k = 0u; k < _cluster_draw_ranges.size(); ++k) {
+            if (_cluster_draw_counts[k] == 0u) { continue; }
+            cluster_commands_buffer->write_data(
+                _cluster_draw_ranges[k].offset * sizeof(DrawElementsIndirectCommand),
+                &_cluster_commands[_cluster_draw_ranges[k].offset],
+                _cluster_draw_counts[k] * sizeof(DrawElementsIndirectCommand));
+        }
+        cluster_counts_buffer->write_data(
+            0u, _cluster_draw_counts.data(), _cluster_draw_counts.size() * sizeof(uint32_t));
+    }
+
+    float Renderer::_lod_factor() const {
+        // Error of 1 at distance 1 covers this many pixels, divided by the allowed error so a
+        // level fits when error * factor <= distance.
+        if (lod_settings.enabled == false) { return std::numeric_limits<float>::max(); }
+        const auto camera = Engine::instance().get_camera();
+        const auto height = (float)Engine::instance().get_window()->height();
+        const auto pixels = height / (2.f * std::tan(glm::radians(camera->lens.fovydeg) * .5f));
+        return pixels / std::max(lod_settings.max_error_pixels, 1e-3f);
+    }
+
+    void Renderer::_build_hiz() {
+        hiz_program->use();
+        depth_stencil_texture->bind(0);
+
+        const auto [width, height] = hiz_texture->get_size();
+        for (auto level = 0u; level < hiz_levels; ++level) {
+            if (level > 0u) {
+                glBindImageTexture(
+                    0, hiz_texture->handle(), level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+            }
+            glBindImageTexture(
+                1, hiz_texture->handle(), level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+            hiz_program->set("level", (int)level);
+
+            const auto w = std::max(width >> level, 1u), h = std::max(height >> level, 1u);
+            glDispatchCompute((w + 7u) / 8u, (h + 7u) / 8u, 1);
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+        }
+
+        _hiz_valid = true;
+    }
+
 } // namespace eng
@@ -7,15 +7,25 @@
 #include <algorithm>
 #include <compare>
 #include <utility>
+#include <span>
+#include <memory>
+#include <array>
 
 #include <engine/gpu/shaderprogram/shader.hpp>
 #include <engine/gpu/resource_manager/gpu_res_mgr.hpp>
 #include <engine/gpu/buffers/buffer.hpp>
 #include <engine/gpu/texture/texture.hpp>
+#include <engine/gpu/texture/texture_residency.hpp>
 #include <engine/types/idallocator.hpp>
 #include <engine/types/idresource.hpp>
+#include <engine/types/slot_map.hpp>
+#include <engine/types/range_allocator.hpp>
 #include <engine/gpu/framebuffer/framebuffer.hpp>
 #include <engine/renderer/postprocess.hpp>
+#include <engine/renderer/culling.hpp>
+#include <engine/renderer/vertex_format.hpp>
+#include <engine/renderer/mesh_lod.hpp>
+#include <engine/renderer/meshlet.hpp>
 #include <glm/glm.hpp>
 
 namespace eng {
@@ -54,8 +64,33 @@ namespace eng {
                       glm::mat4 transform)
             : vertices{vertices}, indices{indices}, material{material}, transform{transform} {}
 
+        std::span<const unsigned> index_data() const {
+            return backing ? mapped_indices : std::span<const unsigned>{indices};
+        }
+        std::span<const MeshLod> lod_data() const {
+            return backing ? mapped_lods : std::span<const MeshLod>{lods};
+        }
+        std::span<const Meshlet> meshlet_data() const {
+            return backing ? mapped_meshlets : std::span<const Meshlet>{meshlets};
+        }
+
+        // 12 floats per vertex: position, uv3, tangent, bitangent. Packed on upload.
         std::vector<float> vertices;
         std::vector<unsigned> indices;
+        // Ranges of indices drawn per level of detail, at most MAX_LODS. Empty draws all of
+        // indices at every distance.
+        std::vector<MeshLod> lods;
+        // Clusters of LOD 0, see meshlet_builder. Empty draws LOD 0 whole.
+        std::vector<Meshlet> meshlets;
+        // Geometry in memory the mesh does not own (a mapped mesh cache blob, for example), used
+        // instead of vertices and indices while backing keeps that memory alive. Its vertices
+        // are packed already, with mapped_quantization.
+        std::span<const PackedVertex> mapped_vertices;
+        VertexQuantization mapped_quantization;
+        std::span<const unsigned> mapped_indices;
+        std::span<const MeshLod> mapped_lods;
+        std::span<const Meshlet> mapped_meshlets;
+        std::shared_ptr<const void> backing;
         Handle<Material> material;
         glm::mat4 transform{1.f};
     };
@@ -86,56 +121,74 @@ namespace eng {
         Handle<ShaderProgram> prog;
     };
 
-    struct PassObject : IdResource<PassObject> {
-        PassObject(PassMaterial mat, Handle<Mesh> mesh, Handle<RenderObject> ro) {
+    struct PassObject {
+        PassObject(PassMaterial mat,
+                   Handle<Mesh> mesh,
+                   Handle<RenderObject> ro,
+                   uint32_t batch_id) {
             this->mat           = mat;
             this->mesh          = mesh;
             this->render_object = ro;
+            this->batch_id      = batch_id;
         }
         PassMaterial mat;
         Handle<Mesh> mesh;
         Handle<RenderObject> render_object;
+        uint32_t batch_id;
     };
 
     struct FlatBatch {
-        FlatBatch(uint32_t bid, Handle<PassObject> h) : batch_id{bid}, object{h} {}
+        FlatBatch(uint32_t bid, uint32_t object) : batch_id{bid}, object{object} {}
         uint32_t batch_id;
-        Handle<PassObject> object;
+        uint32_t object; // dense index into MeshPass::pass_objects
     };
 
     struct IndirectBatch {
         Handle<Mesh> mesh;
         PassMaterial material;
         uint32_t first, count;
+        uint32_t batch_id;
     };
 
     struct MultiBatch {
         uint32_t first, count;
     };
 
-    class Renderer;
+    // Full rebuilds and re-sorts every pass object on refresh, Incremental merges only the
+    // added/removed ones into already sorted flat batches and patches indirect batches' ranges.
+    enum class BatchingMode { Full, Incremental };
+
     class MeshPass {
       public:
-        void refresh(Renderer *r);
+        void refresh();
+        void remove(Handle<RenderObject> ro) { to_remove.push_back(ro); }
+        bool needs_refresh() const { return !unbatched.empty() || !to_remove.empty(); }
 
       private:
+        void _rebuild_batches();
+        void _merge_batches(std::vector<FlatBatch> &&added,
+                            std::vector<uint32_t> &&removed_batch_ids,
+                            const std::vector<uint32_t> &remap);
         uint32_t get_batch_id(Handle<Mesh>, Handle<Material>);
-        PassObject &get_pass_object(Handle<PassObject> p) {
-            return *std::find_if(pass_objects.begin(), pass_objects.end(), [id = p.id](auto &&e) {
-                return e.id == id;
-            });
+        PassObject &get_pass_object(uint32_t dense_idx) {
+            return pass_objects.get_dense(dense_idx);
         }
 
       public:
+        BatchingMode batching_mode{BatchingMode::Incremental};
+
         std::vector<Handle<RenderObject>> unbatched;
-        std::vector<PassObject> pass_objects;
+        std::vector<Handle<RenderObject>> to_remove;
+        SlotMap<PassObject> pass_objects;
 
         std::vector<MultiBatch> multi_batches;
         std::vector<IndirectBatch> indirect_batches;
         std::vector<FlatBatch> flat_batches;
 
       private:
-        std::vector<std::pair<Handle<Mesh>, Handle<Material>>> _batch_ids;
+        // Keyed by mesh id in the upper and material id in the lower 32 bits. Ids are handed out
+        // once per pair and never reused, so batches keep their order when others get removed.
+        std::unordered_map<uint64_t, uint32_t> _batch_ids;
     };
 
     struct DrawElementsIndirectCommand {
@@ -150,27 +203,173 @@ namespace eng {
       public:
         Renderer();
 
+        // Uploads geometry of meshes that are not on the GPU yet.
         void register_object(const Object *o);
+        // Removes all render objects created for o and schedules them for destruction.
+        void unregister_object(const Object *o);
         void render();
+        // Moves a render object. Unless instance data gets rebuilt anyway, only the changed
+        // instances are sent to the GPU on next render().
+        void set_transform(Handle<RenderObject> ro, const glm::mat4 &transform);
+        // Recompiles the renderer's own programs and the forward pass's from disk, without
+        // stalling: frames keep drawing with the old ones until the new ones are linked.
+        void reload_shaders();
+
+        // Gpu culls in cull.comp against the frustum and the Hi-Z pyramid. Cpu only culls against
+        // the frustum, with SIMD, and builds draw commands out of the visible instances. With
+        // clusters, instances drawn at LOD 0 of a mesh with meshlets are culled once more per
+        // meshlet, against the frustum and the meshlet's normal cone, and draw only what is left.
+        enum class CullingMode { Gpu, Cpu };
+        struct CullingSettings {
+            CullingMode mode{CullingMode::Gpu};
+            bool frustum{true}, occlusion{true}, clusters{true};
+        } culling_settings;
+
+        // Every instance draws the coarsest LOD of its mesh whose error, projected with the
+        // camera lens at the instance's distance, covers at most max_error_pixels.
+        struct LodSettings {
+            bool enabled{true};
+            float max_error_pixels{1.f};
+        } lod_settings;
+
+        // Material textures are made resident through it, its budget caps how much of them
+        // stays resident.
+        TextureResidency texture_residency;
 
       private:
+        // Vertex and index ranges a mesh got in geometry_buffer and index_buffer, in elements,
+        // and bounding sphere of its vertices (xyz center, w radius).
+        struct MeshGeometry {
+            RangeAllocator::Range vertices, indices, meshlets;
+            glm::vec4 bounds{0.f};
+            VertexQuantization quantization;
+            std::array<MeshLod, MAX_LODS> lods;
+            uint32_t lod_count{1u};
+            // What meshlets holds in meshlets_buffer, for culling on the CPU. Empty for meshes
+            // of a single meshlet, those always draw LOD 0 whole.
+            std::vector<Meshlet> meshlet_copy;
+        };
+
+        // Layout of BatchClusters in cull.comp and cluster_cull.comp. Cluster commands of a
+        // batch go to cluster_commands_buffer, from draw_offset on, shared with the other
+        // batches of its multi batch.
+        struct BatchClusters {
+            uint32_t first_meshlet{0u}, meshlet_count{0u};
+            uint32_t first_index{0u}, base_vertex{0u};
+            uint32_t draw_offset{0u}, multi_batch{0u};
+            uint32_t _pad[2]{};
+        };
+
+        void _allocate_geometry(const Mesh &m);
+        void _free_geometry(Handle<Mesh> mesh);
+        // Material table out of _material_ids, with the handles texture_residency hands out now.
+        void _upload_materials();
+        void _upload_transforms();
+        void _cull_gpu(const glm::mat4 &pv);
+        void _cull_cpu(const glm::mat4 &pv, DrawElementsIndirectCommand *commands);
+        // Touches the materials of instances in the frustum.
+        void _track_texture_usage(const glm::mat4 &pv);
+        void _build_hiz();
+        float _lod_factor() const;
+
         MeshPass _forward_pass;
         PostprocessBloom* bloom{nullptr};
 
         std::vector<Handle<RenderObject>> _dirty_objects;
         std::unordered_map<uint32_t, uint32_t> _mesh_instance_count;
+        std::unordered_map<uint32_t, MeshGeometry> _mesh_geometry;
+        // Render object id -> index of its instance in mesh_data_buffer.
+        std::unordered_map<uint32_t, uint32_t> _instance_index;
+        std::vector<uint32_t> _dirty_instances;
+        // World space bounds of forward pass instances, in instance order.
+        culling::SphereSoA _instance_bounds;
+        std::vector<uint32_t> _visible_instances;
+        // CPU culling: how many of _visible_instances the last cull left, 0 once instances are
+        // laid out again.
+        uint32_t _visible_count{0u};
+        // CPU culling: visible instances grouped per LOD command, and the LOD each one got.
+        std::vector<uint32_t> _culled_instances, _instance_lods;
+        // Indirect batch of every instance, and per batch the error of each LOD of its mesh.
+        std::vector<uint32_t> _instance_batches;
+        std::vector<glm::vec4> _batch_lod_errors;
+        // Material id of every indirect batch, and instances in view for texture residency.
+        std::vector<uint32_t> _batch_materials, _used_instances;
+        // Frames since texture usage was last taken from a frustum test of its own.
+        uint32_t _usage_age{0u};
+        // Material id of every entry of material_table_buffer.
+        std::vector<uint32_t> _material_ids;
+        std::vector<glm::mat4> _instance_transforms;
+        std::vector<BatchClusters> _batch_clusters;
+        // Per multi batch range of cluster_commands_buffer, room for every meshlet of every
+        // instance that can be clustered.
+        std::vector<RangeAllocator::Range> _cluster_draw_ranges;
+        uint32_t _cluster_draw_budget{0u};
+        // CPU culling: instances drawn per meshlet, visible meshlets of one of them, cluster
+        // commands and how many of them every multi batch got.
+        std::vector<uint32_t> _clustered_instances, _visible_meshlets;
+        std::vector<DrawElementsIndirectCommand> _cluster_commands;
+        std::vector<uint32_t> _cluster_draw_counts;
+        RangeAllocator _vertex_allocator, _index_allocator, _meshlet_allocator;
 
         ShaderProgram quad_shader;
         Framebuffer render_fbo;
         Texture *color_texture{nullptr};
         Texture *depth_stencil_texture{nullptr};
+        // Farthest depth of the previous frame, occlusion culling tests against it.
+        Texture *hiz_texture{nullptr};
+        uint32_t hiz_levels{1u};
+        bool _hiz_valid{false};
+        ShaderProgram *cull_program{nullptr}, *hiz_program{nullptr}, *scatter_program{nullptr};
+        ShaderProgram *cluster_cull_program{nullptr};
 
         GLVao *mesh_vao{nullptr}, *quad_vao{nullptr};
         GLBuffer *quad_buffer{nullptr};
-        GLBuffer *commands_buffer{nullptr};
+        GLRingBuffer *commands_buffer{nullptr};
         GLBuffer *geometry_buffer{nullptr};
         GLBuffer *index_buffer{nullptr};
         GLBuffer *mesh_data_buffer{nullptr};
+        GLBuffer *material_table_buffer{nullptr};
+        GLBuffer *visible_instances_buffer{nullptr};
+        GLBuffer *instance_batches_buffer{nullptr};
+        GLBuffer *batch_bounds_buffer{nullptr};
+        GLBuffer *batch_lods_buffer{nullptr};
+        GLBuffer *batch_quantization_buffer{nullptr};
+        GLBuffer *transform_updates_buffer{nullptr};
+        GLBuffer *meshlets_buffer{nullptr};
+        GLBuffer *batch_clusters_buffer{nullptr};
+        // cluster_cull.comp dispatch arguments and the instances it works on.
+        GLBuffer *cluster_work_buffer{nullptr};
+        GLBuffer *cluster_commands_buffer{nullptr};
+        GLBuffer *cluster_counts_buffer{nullptr};
+
+        // Layout of Instance in a.vert and the culling shaders, in mesh_data_buffer: the first
+        // three rows of the instance's transform and the index of its material's entry in
+        // material_table_buffer.
+        struct InstanceData {
+            std::array<float, 12> transform;
+            uint32_t material;
+        };
+        static_assert(sizeof(InstanceData) == 52u);
+
+        // Layout of Material in a.frag, shared by all instances of the material.
+        struct MaterialData {
+            uint64_t diffuse, normal, metallic, roughness, emissive;
+            // Channel of the metallic and roughness textures the shader reads.
+            uint32_t metallic_channel, roughness_channel;
+        };
+        static_assert(sizeof(MaterialData) == 48u);
+
+        // Layout of TransformUpdate in scatter.comp.
+        struct TransformUpdate {
+            std::array<float, 12> transform;
+            uint32_t instance;
+        };
+
+        // See PackedVertex.
+        static constexpr uint32_t VERTEX_STRIDE{sizeof(PackedVertex)};
+        // Frames between frustum tests for texture usage when culling on the GPU. Well below
+        // TextureResidency::idle_frames, so nothing in view gets evicted in between.
+        static constexpr uint32_t TEXTURE_USAGE_INTERVAL{8u};
     };
 
 } // namespace eng
@@ -0,0 +1,87 @@
+#include "vertex_format.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace eng::vertex_format {
+    // Same conversions GL does for normalized signed attributes: c / max, clamped to -1.
+    static int16_t snorm16(float x) {
+        return (int16_t)std::lround(std::clamp(x, -1.f, 1.f) * 32767.f);
+    }
+
+    static float unsnorm16(int16_t c) { return std::max((float)c / 32767.f, -1.f); }
+
+    static uint32_t snorm10(float x) {
+        return (uint32_t)std::lround(std::clamp(x, -1.f, 1.f) * 511.f) & 0x3FFu;
+    }
+
+    static float unsnorm10(uint32_t c) {
+        const auto s = (int32_t)(c << 22) >> 22; // Sign extend 10 bits.
+        return std::max((float)s / 511.f, -1.f);
+    }
+
+    static uint32_t pack_2_10_10_10(glm::vec3 v) {
+        return snorm10(v.x) | snorm10(v.y) << 10 | snorm10(v.z) << 20;
+    }
+
+    // Zero ranges (flat or missing attributes) keep scale 0, everything packs to 0.
+    static float inverse(float scale) { return scale > 0.f ? 1.f / scale : 0.f; }
+
+    VertexQuantization quantization(std::span<const float> vertices) {
+        VertexQuantization q;
+        if (vertices.empty()) { return q; }
+
+        glm::vec3 pmin{vertices[0], vertices[1], vertices[2]}, pmax{pmin};
+        glm::vec2 uvmin{vertices[3], vertices[4]}, uvmax{uvmin};
+        for (auto i = 0u; i < vertices.size(); i += FLOATS_PER_VERTEX) {
+            const glm::vec3 p{vertices[i], vertices[i + 1], vertices[i + 2]};
+            const glm::vec2 uv{vertices[i + 3], vertices[i + 4]};
+            pmin  = glm::min(pmin, p);
+            pmax  = glm::max(pmax, p);
+            uvmin = glm::min(uvmin, uv);
+            uvmax = glm::max(uvmax, uv);
+        }
+
+        q.position_offset = glm::vec4{(pmin + pmax) * .5f, 0.f};
+        q.position_scale  = glm::vec4{(pmax - pmin) * .5f, 0.f};
+        q.uv = glm::vec4{(uvmin + uvmax) * .5f, (uvmax - uvmin) * .5f};
+        return q;
+    }
+
+    void pack(std::span<const float> vertices, const VertexQuantization &q, PackedVertex *out) {
+        const glm::vec3 pos_offset{q.position_offset};
+        const glm::vec3 pos_inv{inverse(q.position_scale.x),
+                                inverse(q.position_scale.y),
+                                inverse(q.position_scale.z)};
+        const glm::vec2 uv_offset{q.uv.x, q.uv.y};
+        const glm::vec2 uv_inv{inverse(q.uv.z), inverse(q.uv.w)};
+
+        for (auto i = 0u; i < vertices.size(); i += FLOATS_PER_VERTEX, ++out) {
+            const auto v  = &vertices[i];
+            const auto p  = (glm::vec3{v[0], v[1], v[2]} - pos_offset) * pos_inv;
+            const auto uv = (glm::vec2{v[3], v[4]} - uv_offset) * uv_inv;
+
+            *out = PackedVertex{
+                .position  = {snorm16(p.x), snorm16(p.y), snorm16(p.z), 0},
+                .uv        = {snorm16(uv.x), snorm16(uv.y)},
+                .tangent   = pack_2_10_10_10(glm::vec3{v[6], v[7], v[8]}),
+                .bitangent = pack_2_10_10_10(glm::vec3{v[9], v[10], v[11]}),
+            };
+        }
+    }
+
+    glm::vec3 unpack_position(const PackedVertex &v, const VertexQuantization &q) {
+        const glm::vec3 p{
+            unsnorm16(v.position[0]), unsnorm16(v.position[1]), unsnorm16(v.position[2])};
+        return glm::vec3{q.position_offset} + p * glm::vec3{q.position_scale};
+    }
+
+    glm::vec2 unpack_uv(const PackedVertex &v, const VertexQuantization &q) {
+        const glm::vec2 uv{unsnorm16(v.uv[0]), unsnorm16(v.uv[1])};
+        return glm::vec2{q.uv.x, q.uv.y} + uv * glm::vec2{q.uv.z, q.uv.w};
+    }
+
+    glm::vec3 unpack_tangent(uint32_t packed) {
+        return glm::vec3{unsnorm10(packed), unsnorm10(packed >> 10), unsnorm10(packed >> 20)};
+    }
+} // namespace eng::vertex_format
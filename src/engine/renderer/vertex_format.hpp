@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include <glm/glm.hpp>
+
+namespace eng {
+    // Vertex as it lies in the renderer's geometry buffer, 20 bytes instead of the 48 of the
+    // float layout (12 floats: position, uv3, tangent, bitangent). Positions and uvs are snorm16
+    // relative to the mesh's own ranges, see VertexQuantization. Tangent frames are unit vectors,
+    // so 10 bit snorm (GL_INT_2_10_10_10_REV) is enough for them.
+    struct PackedVertex {
+        int16_t position[4]; // w is padding
+        int16_t uv[2];
+        uint32_t tangent;
+        uint32_t bitangent;
+    };
+    static_assert(sizeof(PackedVertex) == 20u);
+
+    // Maps snorm attributes in [-1, 1] back to mesh space: value = offset + packed * scale.
+    // std430 layout, a.vert reads it per draw command.
+    struct VertexQuantization {
+        glm::vec4 position_offset{0.f};
+        glm::vec4 position_scale{1.f};
+        glm::vec4 uv{0.f, 0.f, 1.f, 1.f}; // xy offset, zw scale
+    };
+
+    namespace vertex_format {
+        inline constexpr uint32_t FLOATS_PER_VERTEX{12u};
+
+        // Picks the ranges for a mesh in the float layout, so its snorm values span [-1, 1].
+        VertexQuantization quantization(std::span<const float> vertices);
+        // Converts vertices in the float layout, out must hold vertices.size() / 12 elements.
+        void pack(std::span<const float> vertices, const VertexQuantization &q, PackedVertex *out);
+
+        glm::vec3 unpack_position(const PackedVertex &v, const VertexQuantization &q);
+        glm::vec2 unpack_uv(const PackedVertex &v, const VertexQuantization &q);
+        glm::vec3 unpack_tangent(uint32_t packed);
+    } // namespace vertex_format
+} // namespace eng
@@ -0,0 +1,299 @@
+#include "mesh_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace eng {
+    MappedFile::MappedFile(const std::filesystem::path &path) {
+#if defined(_WIN32)
+        auto file = CreateFileW(path.c_str(),
+                                GENERIC_READ,
+                                FILE_SHARE_READ,
+                                nullptr,
+                                OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL,
+                                nullptr);
+        if (file == INVALID_HANDLE_VALUE) { return; }
+        _file = file;
+
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) == FALSE || size.QuadPart == 0) { return; }
+
+        _mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping == nullptr) { return; }
+
+        _data = static_cast<const std::byte *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (_data != nullptr) { _size = (size_t)size.QuadPart; }
+#else
+        const auto fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1) { return; }
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            auto ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr != MAP_FAILED) {
+                _data = static_cast<const std::byte *>(ptr);
+                _size = (size_t)st.st_size;
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    MappedFile::~MappedFile() {
+#if defined(_WIN32)
+        if (_data != nullptr) { UnmapViewOfFile(_data); }
+        if (_mapping != nullptr) { CloseHandle(_mapping); }
+        if (_file != nullptr) { CloseHandle(_file); }
+#else
+        if (_data != nullptr) { munmap((void *)_data, _size); }
+#endif
+    }
+
+    bool CachedScene::is_valid(uint64_t source_hash, uint32_t import_flags) const {
+        const auto file_size = _file->size();
+        const auto fits      = [file_size](uint64_t offset, uint64_t size) {
+            return offset <= file_size && size <= file_size - offset;
+        };
+
+        if (fits(0u, sizeof(Header)) == false) { return false; }
+        const auto &h = header();
+        if (memcmp(h.magic, "HPMC", 4) != 0 || h.version != VERSION
+            || h.source_hash != source_hash || h.import_flags != import_flags) {
+            return false;
+        }
+
+        const bool tables_fit
+            = fits(h.meshes_offset, (uint64_t)h.mesh_count * sizeof(MeshRecord))
+              && fits(h.materials_offset, (uint64_t)h.material_count * sizeof(MaterialRecord))
+              && fits(h.dependencies_offset,
+                      (uint64_t)h.dependency_count * sizeof(DependencyRecord))
+              && fits(h.vertices_offset, h.vertices_size)
+              && fits(h.indices_offset, h.indices_size)
+              && fits(h.meshlets_offset, h.meshlets_size);
+        if (tables_fit == false) { return false; }
+
+        const auto vertex_total  = h.vertices_size / sizeof(PackedVertex);
+        const auto index_total   = h.indices_size / sizeof(uint32_t);
+        const auto meshlet_total = h.meshlets_size / sizeof(Meshlet);
+        for (const auto &m : meshes()) {
+            if ((uint64_t)m.first_vertex + m.vertex_count > vertex_total
+                || (uint64_t)m.first_index + m.index_count > index_total
+                || m.material >= h.material_count || m.lod_count == 0u || m.lod_count > MAX_LODS
+                || (uint64_t)m.first_meshlet + m.meshlet_count > meshlet_total) {
+                return false;
+            }
+            for (auto i = 0u; i < m.lod_count; ++i) {
+                if ((uint64_t)m.lods[i].first_index + m.lods[i].index_count > m.index_count) {
+                    return false;
+                }
+            }
+            for (const auto &c : meshlets(m)) {
+                if ((uint64_t)c.first_index + c.index_count > m.lods[0].index_count) {
+                    return false;
+                }
+            }
+        }
+        for (const auto &m : materials()) {
+            for (const auto &t : m.textures) {
+                if (fits(t.offset, t.size) == false) { return false; }
+            }
+        }
+        for (const auto &d : dependencies()) {
+            if (fits(d.path.offset, d.path.size) == false) { return false; }
+        }
+
+        return true;
+    }
+
+    // FNV-1a over file contents, 0 if the file can not be read.
+    static uint64_t hash_file(const std::filesystem::path &path) {
+        std::ifstream file{path, std::ios::binary};
+        if (file.is_open() == false) { return 0u; }
+
+        uint64_t hash{14695981039346656037ull};
+        std::vector<char> chunk(1u << 16);
+        while (file) {
+            file.read(chunk.data(), (std::streamsize)chunk.size());
+            const auto read = (size_t)file.gcount();
+            for (size_t i = 0u; i < read; ++i) {
+                hash = (hash ^ (uint8_t)chunk[i]) * 1099511628211ull;
+            }
+        }
+        return hash;
+    }
+
+    static int64_t write_time(const std::filesystem::path &path) {
+        std::error_code ec;
+        return (int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    }
+
+    static std::shared_ptr<const CachedScene> open_blob(const std::filesystem::path &blob_path,
+                                                        uint64_t source_hash,
+                                                        uint32_t import_flags) {
+        auto file = std::make_unique<MappedFile>(blob_path);
+        if (file->is_open() == false) { return nullptr; }
+
+        auto scene = std::make_shared<const CachedScene>(std::move(file));
+        if (scene->is_valid(source_hash, import_flags) == false) { return nullptr; }
+
+        for (const auto &d : scene->dependencies()) {
+            const std::filesystem::path path{scene->string(d.path)};
+            std::error_code ec;
+            const auto size = std::filesystem::file_size(path, ec);
+            if (ec || size != d.size || write_time(path) != d.write_time) { return nullptr; }
+        }
+
+        return scene;
+    }
+
+    MeshCache::Key MeshCache::key(const std::filesystem::path &source,
+                                  uint32_t import_flags) const {
+        Key k{.source_hash = hash_file(source), .import_flags = import_flags, .blob_path = {}};
+
+        char name[64];
+        snprintf(name,
+                 sizeof(name),
+                 "%016llx_%08x.meshcache",
+                 (unsigned long long)k.source_hash,
+                 import_flags);
+        k.blob_path = _cache_dir / name;
+        return k;
+    }
+
+    std::shared_ptr<const CachedScene> MeshCache::find(const Key &key) {
+        auto scene = key.source_hash != 0u
+                         ? open_blob(key.blob_path, key.source_hash, key.import_flags)
+                         : nullptr;
+        if (scene) {
+            _hits++;
+        } else {
+            _misses++;
+        }
+        return scene;
+    }
+
+    std::shared_ptr<const CachedScene> MeshCache::store(const Key &key, const SceneData &data) {
+        using Header = CachedScene::Header;
+        Header h{.magic               = {'H', 'P', 'M', 'C'},
+                 .version             = CachedScene::VERSION,
+                 .source_hash         = key.source_hash,
+                 .import_flags        = key.import_flags,
+                 .mesh_count          = (uint32_t)data.meshes.size(),
+                 .material_count      = (uint32_t)data.materials.size(),
+                 .dependency_count    = (uint32_t)data.dependencies.size(),
+                 .meshes_offset       = 0u,
+                 .materials_offset    = 0u,
+                 .dependencies_offset = 0u,
+                 .vertices_offset     = 0u,
+                 .vertices_size       = 0u,
+                 .indices_offset      = 0u,
+                 .indices_size        = 0u,
+                 .meshlets_offset     = 0u,
+                 .meshlets_size       = 0u};
+
+        // Tables start 8 byte aligned, so records can be read in place.
+        const auto align8  = [](uint64_t x) { return (x + 7u) & ~7ull; };
+        h.meshes_offset    = align8(sizeof(Header));
+        h.materials_offset = align8(h.meshes_offset
+                                    + data.meshes.size() * sizeof(CachedScene::MeshRecord));
+        h.dependencies_offset = align8(
+            h.materials_offset + (uint64_t)h.material_count * sizeof(CachedScene::MaterialRecord));
+        const auto strings_offset
+            = h.dependencies_offset
+              + (uint64_t)h.dependency_count * sizeof(CachedScene::DependencyRecord);
+
+        std::string strings;
+        const auto add_string = [&](std::string_view s) {
+            CachedScene::StringRef ref{(uint32_t)(strings_offset + strings.size()),
+                                       (uint32_t)s.size()};
+            strings.append(s);
+            return ref;
+        };
+
+        std::vector<CachedScene::MaterialRecord> materials(h.material_count);
+        for (auto i = 0u; i < h.material_count; ++i) {
+            for (auto slot = 0u; slot < CachedScene::TEXTURE_SLOTS; ++slot) {
+                if (data.materials[i][slot].empty()) { continue; }
+                materials[i].textures[slot] = add_string(data.materials[i][slot]);
+            }
+        }
+
+        std::vector<CachedScene::DependencyRecord> dependencies;
+        for (const auto &path : data.dependencies) {
+            std::error_code ec;
+            dependencies.push_back(
+                CachedScene::DependencyRecord{.path       = add_string(path),
+                                              .size       = std::filesystem::file_size(path, ec),
+                                              .write_time = write_time(path)});
+        }
+
+        const auto page_align = [](uint64_t x) {
+            return (x + CachedScene::PAGE_SIZE - 1u) / CachedScene::PAGE_SIZE
+                   * CachedScene::PAGE_SIZE;
+        };
+        h.vertices_offset = page_align(strings_offset + strings.size());
+        h.vertices_size   = data.vertices.size() * sizeof(PackedVertex);
+        h.indices_offset  = page_align(h.vertices_offset + h.vertices_size);
+        h.indices_size    = data.indices.size() * sizeof(uint32_t);
+        h.meshlets_offset = align8(h.indices_offset + h.indices_size);
+        h.meshlets_size   = data.meshlets.size() * sizeof(Meshlet);
+
+        std::error_code ec;
+        std::filesystem::create_directories(_cache_dir, ec);
+
+        // Written next to the final blob and renamed over it, so a crash never leaves a
+        // half-written blob that looks valid.
+        auto tmp_path = key.blob_path;
+        tmp_path += ".tmp";
+        {
+            std::ofstream out{tmp_path, std::ios::binary | std::ios::trunc};
+            if (out.is_open() == false) { return nullptr; }
+
+            const auto pad_to = [&out](uint64_t offset) {
+                static constexpr char zeros[CachedScene::PAGE_SIZE]{};
+                out.write(zeros, (std::streamsize)(offset - (uint64_t)out.tellp()));
+            };
+
+            out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+            pad_to(h.meshes_offset);
+            out.write(reinterpret_cast<const char *>(data.meshes.data()),
+                      (std::streamsize)(data.meshes.size() * sizeof(CachedScene::MeshRecord)));
+            pad_to(h.materials_offset);
+            out.write(reinterpret_cast<const char *>(materials.data()),
+                      (std::streamsize)(materials.size() * sizeof(CachedScene::MaterialRecord)));
+            pad_to(h.dependencies_offset);
+            out.write(reinterpret_cast<const char *>(dependencies.data()),
+                      (std::streamsize)(dependencies.size()
+                                        * sizeof(CachedScene::DependencyRecord)));
+            out.write(strings.data(), (std::streamsize)strings.size());
+            pad_to(h.vertices_offset);
+            out.write(reinterpret_cast<const char *>(data.vertices.data()),
+                      (std::streamsize)h.vertices_size);
+            pad_to(h.indices_offset);
+            out.write(reinterpret_cast<const char *>(data.indices.data()),
+                      (std::streamsize)h.indices_size);
+            pad_to(h.meshlets_offset);
+            out.write(reinterpret_cast<const char *>(data.meshlets.data()),
+                      (std::streamsize)h.meshlets_size);
+            if (out.good() == false) { return nullptr; }
+        }
+
+        std::filesystem::rename(tmp_path, key.blob_path, ec);
+        if (ec) { return nullptr; }
+        return open_blob(key.blob_path, key.source_hash, key.import_flags);
+    }
+} // namespace eng
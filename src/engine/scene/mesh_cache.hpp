@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <filesystem>
+
+#include <engine/renderer/vertex_format.hpp>
+#include <engine/renderer/mesh_lod.hpp>
+#include <engine/renderer/meshlet.hpp>
+
+namespace eng {
+    // Read-only view of a whole file mapped into memory.
+    class MappedFile {
+      public:
+        explicit MappedFile() = default;
+        explicit MappedFile(const std::filesystem::path &path);
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        ~MappedFile();
+
+        bool is_open() const { return _data != nullptr; }
+        const std::byte *data() const { return _data; }
+        size_t size() const { return _size; }
+
+      private:
+        const std::byte *_data{nullptr};
+        size_t _size{0u};
+        void *_file{nullptr}, *_mapping{nullptr};
+    };
+
+    // Scene as it lies in a mesh cache blob. Layout, every offset from the start of the file:
+    //   Header
+    //   MeshRecord[mesh_count], MaterialRecord[material_count], DependencyRecord[dep_count]
+    //   strings referenced by StringRef
+    //   vertices, page aligned: PackedVertex, quantized with their MeshRecord's ranges
+    //   indices, page aligned: uint32, relative to the mesh's first vertex
+    //   meshlets, 8 byte aligned: Meshlet, index ranges relative to the mesh's first index
+    // Spans returned point straight into the mapped file.
+    class CachedScene {
+      public:
+        static constexpr uint32_t VERSION{5u};
+        static constexpr uint32_t TEXTURE_SLOTS{5u}; // One per TextureType.
+        static constexpr size_t PAGE_SIZE{4096u};
+
+        struct StringRef {
+            uint32_t offset{0u}, size{0u};
+        };
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint64_t source_hash;
+            uint32_t import_flags;
+            uint32_t mesh_count, material_count, dependency_count;
+            uint64_t meshes_offset, materials_offset, dependencies_offset;
+            uint64_t vertices_offset, vertices_size, indices_offset, indices_size;
+            uint64_t meshlets_offset, meshlets_size;
+        };
+        struct MeshRecord {
+            VertexQuantization quantization;
+            uint32_t first_vertex, vertex_count;
+            // Indices of all LODs, lods[] ranges are relative to first_index.
+            uint32_t first_index, index_count;
+            uint32_t material;
+            uint32_t lod_count;
+            MeshLod lods[MAX_LODS];
+            // Clusters of LOD 0.
+            uint32_t first_meshlet, meshlet_count;
+        };
+        struct MaterialRecord {
+            // Texture paths as written in the source file, empty if the slot is not used.
+            StringRef textures[TEXTURE_SLOTS];
+        };
+        // Files the importer read, the blob is stale once any of them changes.
+        struct DependencyRecord {
+            StringRef path;
+            uint64_t size;
+            int64_t write_time;
+        };
+
+        explicit CachedScene(std::unique_ptr<MappedFile> file) : _file{std::move(file)} {}
+
+        const Header &header() const { return *_at<Header>(0u); }
+        std::span<const MeshRecord> meshes() const {
+            return {_at<MeshRecord>(header().meshes_offset), header().mesh_count};
+        }
+        std::span<const MaterialRecord> materials() const {
+            return {_at<MaterialRecord>(header().materials_offset), header().material_count};
+        }
+        std::span<const DependencyRecord> dependencies() const {
+            return {_at<DependencyRecord>(header().dependencies_offset), header().dependency_count};
+        }
+        std::string_view string(StringRef s) const {
+            return {reinterpret_cast<const char *>(_file->data()) + s.offset, s.size};
+        }
+
+        std::span<const PackedVertex> vertices(const MeshRecord &m) const {
+            return {_at<PackedVertex>(header().vertices_offset) + m.first_vertex, m.vertex_count};
+        }
+        std::span<const uint32_t> indices(const MeshRecord &m) const {
+            return {_at<uint32_t>(header().indices_offset) + m.first_index, m.index_count};
+        }
+        std::span<const Meshlet> meshlets(const MeshRecord &m) const {
+            return {_at<Meshlet>(header().meshlets_offset) + m.first_meshlet, m.meshlet_count};
+        }
+
+        // Checks header and that the blob's sections fit in the file.
+        bool is_valid(uint64_t source_hash, uint32_t import_flags) const;
+
+      private:
+        template <typename T> const T *_at(uint64_t offset) const {
+            return reinterpret_cast<const T *>(_file->data() + offset);
+        }
+
+        std::unique_ptr<MappedFile> _file;
+    };
+
+    // Imported scene before it is written to a blob.
+    struct SceneData {
+        std::vector<CachedScene::MeshRecord> meshes;
+        // Texture path per slot, empty if unused.
+        std::vector<std::array<std::string, CachedScene::TEXTURE_SLOTS>> materials;
+        std::vector<std::string> dependencies;
+        std::vector<PackedVertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<Meshlet> meshlets;
+    };
+
+    // Caches what the importer produces for a model file as blobs in a directory, named after
+    // the source file hash and import flags. See SceneImporter for the importing part.
+    class MeshCache {
+      public:
+        struct Key {
+            uint64_t source_hash{0u};
+            uint32_t import_flags{0u};
+            std::filesystem::path blob_path;
+        };
+
+        explicit MeshCache(std::filesystem::path cache_dir) : _cache_dir{std::move(cache_dir)} {}
+
+        // Hashes the source file, key has zero source_hash if the file can not be read.
+        Key key(const std::filesystem::path &source, uint32_t import_flags) const;
+        // Maps the blob for the key, nullptr if there is none or it is stale.
+        std::shared_ptr<const CachedScene> find(const Key &key);
+        // Writes the blob for the key and maps it, nullptr if writing failed.
+        std::shared_ptr<const CachedScene> store(const Key &key, const SceneData &data);
+
+        uint32_t hits() const { return _hits; }
+        uint32_t misses() const { return _misses; }
+
+      private:
+        std::filesystem::path _cache_dir;
+        uint32_t _hits{0u}, _misses{0u};
+    };
+} // namespace eng
@@ -0,0 +1,214 @@
+#include "mesh_optimizer.hpp"
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+namespace eng::mesh_optimizer {
+    VertexCacheStats analyze_vertex_cache(std::span<const uint32_t> indices,
+                                          uint32_t vertex_count,
+                                          uint32_t cache_size) {
+        VertexCacheStats stats{.triangles = (uint32_t)(indices.size() / 3u)};
+
+        // FIFO: a vertex is cached while fewer than cache_size others were inserted after it.
+        static constexpr auto never = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> inserted_at(vertex_count, never);
+        for (const auto v : indices) {
+            if (inserted_at[v] == never) { stats.vertices++; }
+            if (inserted_at[v] == never || stats.misses - inserted_at[v] > cache_size) {
+                inserted_at[v] = stats.misses++;
+            }
+        }
+        return stats;
+    }
+
+    std::vector<uint32_t> optimize_vertex_cache(std::span<uint32_t> indices,
+                                                uint32_t vertex_count,
+                                                uint32_t cache_size) {
+        const auto triangle_count = (uint32_t)(indices.size() / 3u);
+        std::vector<uint32_t> clusters;
+        if (triangle_count == 0u) { return clusters; }
+
+        // Triangles around every vertex, as offsets into one array.
+        std::vector<uint32_t> live(vertex_count, 0u);
+        for (const auto v : indices) { live[v]++; }
+        std::vector<uint32_t> first(vertex_count + 1u, 0u);
+        std::partial_sum(live.begin(), live.end(), first.begin() + 1);
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            auto fill = first;
+            for (auto t = 0u; t < triangle_count; ++t) {
+                for (auto c = 0u; c < 3u; ++c) { adjacency[fill[indices[t * 3u + c]]++] = t; }
+            }
+        }
+
+        std::vector<uint32_t> out;
+        out.reserve(indices.size());
+        std::vector<uint32_t> cache_time(vertex_count, 0u);
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<uint32_t> dead_end, candidates;
+        uint32_t time{cache_size + 1u}, cursor{0u};
+
+        // Most recently used vertex that still has triangles left, then any such vertex.
+        const auto skip_dead_end = [&]() -> int64_t {
+            while (dead_end.empty() == false) {
+                const auto v = dead_end.back();
+                dead_end.pop_back();
+                if (live[v] > 0u) { return v; }
+            }
+            for (; cursor < vertex_count; ++cursor) {
+                if (live[cursor] > 0u) { return cursor; }
+            }
+            return -1;
+        };
+
+        int64_t fan = indices[0];
+        clusters.push_back(0u);
+        while (fan >= 0) {
+            candidates.clear();
+            for (auto i = first[fan]; i < first[fan + 1]; ++i) {
+                const auto t = adjacency[i];
+                if (emitted[t]) { continue; }
+                emitted[t] = true;
+
+                for (auto c = 0u; c < 3u; ++c) {
+                    const auto v = indices[t * 3u + c];
+                    out.push_back(v);
+                    dead_end.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+                    if (time - cache_time[v] > cache_size) { cache_time[v] = time++; }
+                }
+            }
+
+            // Next fan: the candidate that stays in the cache while its remaining triangles are
+            // emitted and that entered it the earliest. None of them - a dead end.
+            int64_t next{-1};
+            uint32_t best{0u};
+            for (const auto v : candidates) {
+                if (live[v] == 0u) { continue; }
+                uint32_t priority{0u};
+                if (time - cache_time[v] + 2u * live[v] <= cache_size) {
+                    priority = time - cache_time[v];
+                }
+                if (priority > best) {
+                    best = priority;
+                    next = v;
+                }
+            }
+
+            if (next == -1) {
+                next = skip_dead_end();
+                if (next >= 0 && out.size() < indices.size()) {
+                    clusters.push_back((uint32_t)(out.size() / 3u));
+                }
+            }
+            fan = next;
+        }
+
+        std::copy(out.begin(), out.end(), indices.begin());
+        return clusters;
+    }
+
+    void optimize_overdraw(std::span<uint32_t> indices,
+                           std::span<const float> vertices,
+                           uint32_t floats_per_vertex,
+                           std::span<const uint32_t> clusters) {
+        const auto triangle_count = (uint32_t)(indices.size() / 3u);
+        if (clusters.size() < 2u) { return; }
+
+        const auto position = [&](uint32_t v) {
+            const auto p = &vertices[(size_t)v * floats_per_vertex];
+            return glm::vec3{p[0], p[1], p[2]};
+        };
+
+        struct Cluster {
+            uint32_t first, last;
+            glm::vec3 centroid{0.f}, normal{0.f};
+            float area{0.f}, sort_key{0.f};
+        };
+
+        std::vector<Cluster> sorted(clusters.size());
+        glm::vec3 mesh_centroid{0.f};
+        float mesh_area{0.f};
+        for (auto c = 0u; c < clusters.size(); ++c) {
+            auto &cluster = sorted[c];
+            cluster.first = clusters[c];
+            cluster.last  = c + 1u < clusters.size() ? clusters[c + 1u] : triangle_count;
+
+            for (auto t = cluster.first; t < cluster.last; ++t) {
+                const auto a = position(indices[t * 3u]);
+                const auto b = position(indices[t * 3u + 1u]);
+                const auto d = position(indices[t * 3u + 2u]);
+                const auto n = glm::cross(b - a, d - a);
+                const auto w = glm::length(n) * .5f;
+                cluster.normal += n;
+                cluster.centroid += (a + b + d) * (w / 3.f);
+                cluster.area += w;
+            }
+            mesh_centroid += cluster.centroid;
+            mesh_area += cluster.area;
+            if (cluster.area > 0.f) { cluster.centroid /= cluster.area; }
+        }
+        if (mesh_area > 0.f) { mesh_centroid /= mesh_area; }
+
+        for (auto &cluster : sorted) {
+            const auto len = glm::length(cluster.normal);
+            if (len > 0.f) {
+                cluster.sort_key = glm::dot(cluster.centroid - mesh_centroid, cluster.normal / len);
+            }
+        }
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster &a, const Cluster &b) {
+            return a.sort_key > b.sort_key;
+        });
+
+        std::vector<uint32_t> out;
+        out.reserve(indices.size());
+        for (const auto &cluster : sorted) {
+            out.insert(out.end(),
+                       indices.begin() + cluster.first * 3u,
+                       indices.begin() + cluster.last * 3u);
+        }
+        std::copy(out.begin(), out.end(), indices.begin());
+    }
+
+    void optimize_vertex_fetch(std::span<uint32_t> indices,
+                               std::span<float> vertices,
+                               uint32_t floats_per_vertex) {
+        static constexpr auto unused = std::numeric_limits<uint32_t>::max();
+        const auto vertex_count      = (uint32_t)(vertices.size() / floats_per_vertex);
+
+        std::vector<uint32_t> remap(vertex_count, unused);
+        uint32_t next{0u};
+        for (auto &v : indices) {
+            if (remap[v] == unused) { remap[v] = next++; }
+            v = remap[v];
+        }
+        for (auto &r : remap) {
+            if (r == unused) { r = next++; }
+        }
+
+        const std::vector<float> old(vertices.begin(), vertices.end());
+        for (auto v = 0u; v < vertex_count; ++v) {
+            std::copy_n(old.begin() + (size_t)v * floats_per_vertex,
+                        floats_per_vertex,
+                        vertices.begin() + (size_t)remap[v] * floats_per_vertex);
+        }
+    }
+
+    Report optimize(std::span<uint32_t> indices,
+                    std::span<float> vertices,
+                    uint32_t floats_per_vertex) {
+        const auto vertex_count = (uint32_t)(vertices.size() / floats_per_vertex);
+
+        Report report{.before = analyze_vertex_cache(indices, vertex_count), .after = {}};
+        const auto clusters = optimize_vertex_cache(indices, vertex_count);
+        optimize_overdraw(indices, vertices, floats_per_vertex, clusters);
+        optimize_vertex_fetch(indices, vertices, floats_per_vertex);
+        report.after = analyze_vertex_cache(indices, vertex_count);
+        return report;
+    }
+} // namespace eng::mesh_optimizer
@@ -0,0 +1,222 @@
+#include "mesh_simplifier.hpp"
+
+#include <cmath>
+#include <array>
+#include <queue>
+#include <algorithm>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include <engine/scene/mesh_optimizer.hpp>
+
+namespace eng::mesh_simplifier {
+    // Sum of squared distances to a set of planes, as the upper triangle of a symmetric 4x4.
+    struct Quadric {
+        std::array<double, 10> q{};
+
+        void add_plane(glm::dvec4 p) {
+            q[0] += p.x * p.x, q[1] += p.x * p.y, q[2] += p.x * p.z, q[3] += p.x * p.w;
+            q[4] += p.y * p.y, q[5] += p.y * p.z, q[6] += p.y * p.w;
+            q[7] += p.z * p.z, q[8] += p.z * p.w;
+            q[9] += p.w * p.w;
+        }
+
+        Quadric &operator+=(const Quadric &o) {
+            for (auto i = 0u; i < q.size(); ++i) { q[i] += o.q[i]; }
+            return *this;
+        }
+
+        double evaluate(glm::dvec3 v) const {
+            const auto r = q[0] * v.x * v.x + 2. * q[1] * v.x * v.y + 2. * q[2] * v.x * v.z
+                           + 2. * q[3] * v.x + q[4] * v.y * v.y + 2. * q[5] * v.y * v.z
+                           + 2. * q[6] * v.y + q[7] * v.z * v.z + 2. * q[8] * v.z + q[9];
+            return std::max(r, 0.);
+        }
+    };
+
+    struct Collapse {
+        double cost;
+        uint32_t from, to;
+        uint32_t from_version, to_version;
+
+        bool operator>(const Collapse &o) const { return cost > o.cost; }
+    };
+
+    float simplify(std::span<const uint32_t> indices,
+                   std::span<const float> vertices,
+                   uint32_t floats_per_vertex,
+                   uint32_t target_index_count,
+                   std::vector<uint32_t> &out) {
+        const auto vertex_count = (uint32_t)(vertices.size() / floats_per_vertex);
+        std::vector<uint32_t> triangles(indices.begin(), indices.end());
+        auto triangle_count = (uint32_t)(triangles.size() / 3u);
+
+        const auto position = [&](uint32_t v) {
+            const auto p = &vertices[(size_t)v * floats_per_vertex];
+            return glm::dvec3{p[0], p[1], p[2]};
+        };
+
+        std::vector<std::vector<uint32_t>> vertex_triangles(vertex_count);
+        std::vector<Quadric> quadrics(vertex_count);
+        std::vector<bool> removed(triangle_count, false);
+        for (auto t = 0u; t < triangle_count; ++t) {
+            const auto a = position(triangles[t * 3u]), b = position(triangles[t * 3u + 1u]),
+                       c = position(triangles[t * 3u + 2u]);
+            const auto n   = glm::cross(b - a, c - a);
+            const auto len = glm::length(n);
+            for (auto i = 0u; i < 3u; ++i) { vertex_triangles[triangles[t * 3u + i]].push_back(t); }
+            if (len <= 0.) { continue; }
+
+            const auto unit = n / len;
+            const glm::dvec4 plane{unit, -glm::dot(unit, a)};
+            for (auto i = 0u; i < 3u; ++i) { quadrics[triangles[t * 3u + i]].add_plane(plane); }
+        }
+
+        // Locked: border vertices (an edge used by one triangle) and seam vertices (their
+        // position is shared with another vertex).
+        std::vector<bool> locked(vertex_count, false);
+        {
+            std::unordered_map<uint64_t, uint32_t> edge_use;
+            for (auto t = 0u; t < triangle_count; ++t) {
+                for (auto i = 0u; i < 3u; ++i) {
+                    auto a = triangles[t * 3u + i], b = triangles[t * 3u + (i + 1u) % 3u];
+                    if (a > b) { std::swap(a, b); }
+                    edge_use[(uint64_t)a << 32 | b]++;
+                }
+            }
+            for (const auto &[edge, uses] : edge_use) {
+                if (uses != 1u) { continue; }
+                locked[edge >> 32]          = true;
+                locked[edge & 0xFFFFFFFFu] = true;
+            }
+
+            struct PositionHash {
+                size_t operator()(const glm::vec3 &p) const {
+                    const auto h = std::hash<float>{};
+                    return h(p.x) ^ (h(p.y) * 31u) ^ (h(p.z) * 131u);
+                }
+            };
+            std::unordered_map<glm::vec3, uint32_t, PositionHash> first_at;
+            for (auto v = 0u; v < vertex_count; ++v) {
+                if (vertex_triangles[v].empty()) { continue; }
+                auto [it, inserted] = first_at.try_emplace(glm::vec3{position(v)}, v);
+                if (inserted == false) {
+                    locked[v]          = true;
+                    locked[it->second] = true;
+                }
+            }
+        }
+
+        std::vector<uint32_t> version(vertex_count, 0u);
+        std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> queue;
+        const auto push = [&](uint32_t from, uint32_t to) {
+            if (locked[from]) { return; }
+            auto q = quadrics[from];
+            q += quadrics[to];
+            queue.push(Collapse{q.evaluate(position(to)), from, to, version[from], version[to]});
+        };
+        for (auto t = 0u; t < triangle_count; ++t) {
+            for (auto i = 0u; i < 3u; ++i) {
+                const auto a = triangles[t * 3u + i], b = triangles[t * 3u + (i + 1u) % 3u];
+                push(a, b);
+                push(b, a);
+            }
+        }
+
+        // Moving from onto to must not flip or collapse any triangle that keeps existing.
+        const auto flips = [&](uint32_t from, uint32_t to) {
+            const auto target = position(to);
+            for (const auto t : vertex_triangles[from]) {
+                if (removed[t]) { continue; }
+                const auto tri = &triangles[t * 3u];
+                if (tri[0] == to || tri[1] == to || tri[2] == to) { continue; }
+
+                glm::dvec3 p[3], moved[3];
+                for (auto i = 0u; i < 3u; ++i) {
+                    p[i]     = position(tri[i]);
+                    moved[i] = tri[i] == from ? target : p[i];
+                }
+                const auto before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                const auto after  = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+                if (glm::dot(before, after) <= 0.) { return true; }
+            }
+            return false;
+        };
+
+        double max_cost{0.};
+        auto alive = triangle_count;
+        while (alive * 3u > target_index_count && queue.empty() == false) {
+            const auto c = queue.top();
+            queue.pop();
+            if (c.from_version != version[c.from] || c.to_version != version[c.to]) { continue; }
+            if (flips(c.from, c.to)) { continue; }
+
+            max_cost = std::max(max_cost, c.cost);
+            quadrics[c.to] += quadrics[c.from];
+            version[c.from]++;
+            version[c.to]++;
+
+            for (const auto t : vertex_triangles[c.from]) {
+                if (removed[t]) { continue; }
+                auto tri = &triangles[t * 3u];
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                    removed[t] = true;
+                    alive--;
+                    continue;
+                }
+                for (auto i = 0u; i < 3u; ++i) {
+                    if (tri[i] == c.from) { tri[i] = c.to; }
+                }
+                vertex_triangles[c.to].push_back(t);
+            }
+            vertex_triangles[c.from].clear();
+
+            std::erase_if(vertex_triangles[c.to], [&](uint32_t t) { return removed[t]; });
+            for (const auto t : vertex_triangles[c.to]) {
+                for (auto i = 0u; i < 3u; ++i) {
+                    const auto v = triangles[t * 3u + i];
+                    if (v == c.to) { continue; }
+                    push(v, c.to);
+                    push(c.to, v);
+                }
+            }
+        }
+
+        out.clear();
+        for (auto t = 0u; t < triangle_count; ++t) {
+            if (removed[t] == false) {
+                out.insert(out.end(), &triangles[t * 3u], &triangles[t * 3u] + 3u);
+            }
+        }
+        return (float)std::sqrt(max_cost);
+    }
+
+    std::vector<MeshLod> build_lods(std::vector<uint32_t> &indices,
+                                    std::span<const float> vertices,
+                                    uint32_t floats_per_vertex) {
+        const auto full_count = (uint32_t)indices.size();
+        const auto vertex_count = (uint32_t)(vertices.size() / floats_per_vertex);
+
+        std::vector<MeshLod> lods{MeshLod{.first_index = 0u, .index_count = full_count}};
+        std::vector<uint32_t> lod;
+        while (lods.size() < MAX_LODS) {
+            const auto previous = lods.back().index_count;
+            const auto target   = previous / 6u * 3u;
+            if (target < 3u) { break; }
+
+            // Every level starts from the full mesh, so errors do not pile up along the chain.
+            const std::span<const uint32_t> full{indices.data(), full_count};
+            const auto error = simplify(full, vertices, floats_per_vertex, target, lod);
+            // Less than a quarter fewer triangles is not worth another draw command.
+            if (lod.size() * 4u > previous * 3u) { break; }
+
+            mesh_optimizer::optimize_vertex_cache(lod, vertex_count);
+            lods.push_back(MeshLod{.first_index = (uint32_t)indices.size(),
+                                   .index_count = (uint32_t)lod.size(),
+                                   .error       = std::max(error, lods.back().error)});
+            indices.insert(indices.end(), lod.begin(), lod.end());
+        }
+        return lods;
+    }
+} // namespace eng::mesh_simplifier
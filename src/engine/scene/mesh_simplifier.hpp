@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <engine/renderer/mesh_lod.hpp>
+
+namespace eng {
+    // Quadric error metric simplification (Garland and Heckbert 1997) restricted to collapsing
+    // a vertex into one of its neighbours, so every level indexes the vertices of the full mesh
+    // and they can all share one vertex range.
+    namespace mesh_simplifier {
+        // Collapses edges until at most target_index_count indices are left or nothing can be
+        // collapsed anymore. Vertices on borders and on attribute seams (several vertices with
+        // the same position) stay in place, so the silhouette and uv mapping do not tear.
+        // Returns the error bound: no vertex that moved is farther than it from any plane of
+        // the triangles it was merged from.
+        float simplify(std::span<const uint32_t> indices,
+                       std::span<const float> vertices,
+                       uint32_t floats_per_vertex,
+                       uint32_t target_index_count,
+                       std::vector<uint32_t> &out);
+
+        // LOD 0 is indices as they are. Every further level targets half the triangles of the
+        // previous one and is appended to indices, the chain ends early once simplification
+        // stops making progress.
+        std::vector<MeshLod> build_lods(std::vector<uint32_t> &indices,
+                                        std::span<const float> vertices,
+                                        uint32_t floats_per_vertex);
+    } // namespace mesh_simplifier
+} // namespace eng
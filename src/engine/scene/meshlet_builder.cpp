@@ -0,0 +1,98 @@
+#include "meshlet_builder.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace eng::meshlet_builder {
+    static void compute_bounds(Meshlet &m,
+                               std::span<const uint32_t> indices,
+                               std::span<const float> vertices,
+                               uint32_t floats_per_vertex) {
+        const auto position = [&](uint32_t v) {
+            const auto p = &vertices[(size_t)v * floats_per_vertex];
+            return glm::vec3{p[0], p[1], p[2]};
+        };
+        const auto tris = indices.subspan(m.first_index, m.index_count);
+
+        glm::vec3 min{position(tris[0])}, max{min};
+        for (const auto v : tris) {
+            min = glm::min(min, position(v));
+            max = glm::max(max, position(v));
+        }
+        const auto center = (min + max) * .5f;
+        float radius{0.f};
+        for (const auto v : tris) { radius = std::max(radius, glm::distance(center, position(v))); }
+        m.sphere = glm::vec4{center, radius};
+
+        glm::vec3 normals_sum{0.f};
+        for (auto t = 0u; t < tris.size(); t += 3u) {
+            const auto a = position(tris[t]), b = position(tris[t + 1u]),
+                       c = position(tris[t + 2u]);
+            const auto n = glm::cross(b - a, c - a);
+            if (const auto len = glm::length(n); len > 0.f) { normals_sum += n / len; }
+        }
+        const auto axis_len = glm::length(normals_sum);
+        if (axis_len <= 0.f) { return; }
+        const auto axis = normals_sum / axis_len;
+
+        float min_dot{1.f};
+        for (auto t = 0u; t < tris.size(); t += 3u) {
+            const auto a = position(tris[t]), b = position(tris[t + 1u]),
+                       c = position(tris[t + 2u]);
+            const auto n = glm::cross(b - a, c - a);
+            if (const auto len = glm::length(n); len > 0.f) {
+                min_dot = std::min(min_dot, glm::dot(n / len, axis));
+            }
+        }
+
+        // Past 90 degrees some triangle faces every direction the cluster can be seen from.
+        const auto cutoff = min_dot <= 0.f ? 1.f : std::sqrt(1.f - min_dot * min_dot);
+        m.cone            = glm::vec4{axis, cutoff};
+    }
+
+    std::vector<Meshlet> build(std::span<const uint32_t> indices,
+                               std::span<const float> vertices,
+                               uint32_t floats_per_vertex) {
+        std::vector<Meshlet> meshlets;
+        if (indices.empty()) { return meshlets; }
+
+        // Meshlet the vertex was last counted in, so membership checks are O(1).
+        std::vector<uint32_t> seen_in(vertices.size() / floats_per_vertex, UINT32_MAX);
+        Meshlet current;
+        uint32_t unique{0u};
+        const auto finish = [&] {
+            compute_bounds(current, indices, vertices, floats_per_vertex);
+            meshlets.push_back(current);
+            current = Meshlet{.first_index = current.first_index + current.index_count};
+            unique  = 0u;
+        };
+
+        for (auto t = 0u; t < indices.size(); t += 3u) {
+            const auto id = (uint32_t)meshlets.size();
+            uint32_t fresh{0u};
+            for (auto c = 0u; c < 3u; ++c) {
+                const auto v = indices[t + c];
+                if (seen_in[v] != id
+                    && std::find(&indices[t], &indices[t] + c, v) == &indices[t] + c) {
+                    fresh++;
+                }
+            }
+            if (unique + fresh > MESHLET_MAX_VERTICES
+                || current.index_count / 3u + 1u > MESHLET_MAX_TRIANGLES) {
+                finish();
+            }
+
+            const auto meshlet = (uint32_t)meshlets.size();
+            for (auto c = 0u; c < 3u; ++c) {
+                auto &s = seen_in[indices[t + c]];
+                if (s != meshlet) {
+                    s = meshlet;
+                    unique++;
+                }
+            }
+            current.index_count += 3u;
+        }
+        finish();
+        return meshlets;
+    }
+} // namespace eng::meshlet_builder
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <engine/renderer/meshlet.hpp>
+
+namespace eng {
+    namespace meshlet_builder {
+        // Splits a triangle list into meshlets in the order it is in, a meshlet ends when the
+        // next triangle would bring it over MESHLET_MAX_VERTICES unique vertices or
+        // MESHLET_MAX_TRIANGLES triangles. Run it after mesh_optimizer::optimize_vertex_cache,
+        // whose order keeps neighbouring triangles together, so meshlets come out compact
+        // without reordering indices. Index ranges are relative to indices.
+        std::vector<Meshlet> build(std::span<const uint32_t> indices,
+                                   std::span<const float> vertices,
+                                   uint32_t floats_per_vertex);
+    } // namespace meshlet_builder
+} // namespace eng
@@ -0,0 +1,307 @@
+#include "scene_importer.hpp"
+
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <assimp/scene.h>
+#include <assimp/Importer.hpp>
+#include <assimp/DefaultIOSystem.h>
+
+#include <engine/engine.hpp>
+#include <engine/scene/mesh_simplifier.hpp>
+#include <engine/scene/meshlet_builder.hpp>
+#include <engine/gpu/texture/texture_baker.hpp>
+
+namespace eng {
+    // Remembers every file Assimp opens, so the cache knows which files a blob was built from.
+    class RecordingIOSystem : public Assimp::DefaultIOSystem {
+      public:
+        Assimp::IOStream *Open(const char *file, const char *mode) override {
+            auto stream = Assimp::DefaultIOSystem::Open(file, mode);
+            if (stream != nullptr) { opened.emplace_back(file); }
+            return stream;
+        }
+
+        std::vector<std::string> opened;
+    };
+
+    class StageTimer {
+      public:
+        // Milliseconds since construction or the previous call.
+        double lap() {
+            const auto now = std::chrono::steady_clock::now();
+            const auto ms  = std::chrono::duration<double, std::milli>(now - _last).count();
+            _last          = now;
+            return ms;
+        }
+
+      private:
+        std::chrono::steady_clock::time_point _last{std::chrono::steady_clock::now()};
+    };
+
+    Object SceneImporter::import(const std::filesystem::path &source,
+                                 uint32_t import_flags,
+                                 ShaderProgram *forward_program) {
+        static constexpr TextureType texture_types[CachedScene::TEXTURE_SLOTS]{
+            TextureType::Diffuse,
+            TextureType::Normal,
+            TextureType::Metallic,
+            TextureType::Roughness,
+            TextureType::Emissive,
+        };
+
+        _timings      = Timings{};
+        _optimization = mesh_optimizer::Report{};
+        StageTimer total, stage;
+
+        const auto key = _cache.key(source, import_flags);
+        auto scene     = _cache.find(key);
+        _timings.cache_lookup = stage.lap();
+        _timings.cache_hit    = scene != nullptr;
+
+        if (scene == nullptr) { scene = _import_geometry(source, key); }
+        if (scene == nullptr) { return Object{}; }
+        stage.lap();
+
+        // Textures come from the texture cache, a file used by many materials (of this or any
+        // other scene) is loaded once. Loading only queues the decode, textures show the
+        // placeholder of the slot they were first seen in until the loader has streamed them in.
+        auto gpu    = Engine::instance().get_gpu_res_mgr();
+        auto loader = Engine::instance().get_texture_loader();
+        auto cache  = Engine::instance().get_texture_cache();
+        const TextureSettings settings{GL_RGB8, GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_LINEAR, 7};
+
+        std::vector<Material *> materials;
+        for (const auto &material : scene->materials()) {
+            auto mat                         = gpu->create_resource(Material{});
+            mat->passes[RenderPass::Forward] = forward_program;
+            for (auto slot = 0u; slot < CachedScene::TEXTURE_SLOTS; ++slot) {
+                const auto &t   = material.textures[slot];
+                const auto type = texture_types[slot];
+                if (t.size == 0u) {
+                    mat->textures[type] = loader->placeholder(type);
+                    continue;
+                }
+                // Prefer what texture_baker made of the file: block compressed, mips included.
+                auto path = source.parent_path() / scene->string(t);
+                if (auto baked = texture_baker::baked_path(path, type);
+                    std::filesystem::exists(baked)) {
+                    path = std::move(baked);
+                }
+                mat->textures[type] = cache->acquire(path, settings, type);
+            }
+            materials.push_back(mat);
+        }
+        _timings.materials = stage.lap();
+
+        // The blob has a record per mesh reference, references to one source mesh share its
+        // geometry ranges and get one Mesh resource.
+        std::vector<Mesh> meshes;
+        std::unordered_map<uint64_t, uint32_t> created;
+        for (const auto &mesh : scene->meshes()) {
+            const auto geometry = (uint64_t)mesh.first_vertex << 32u | mesh.first_index;
+            if (const auto it = created.find(geometry); it != created.end()) {
+                meshes.push_back(meshes[it->second]);
+                continue;
+            }
+            created.emplace(geometry, (uint32_t)meshes.size());
+
+            Mesh &m               = *gpu->create_resource(Mesh{});
+            m.material            = materials[mesh.material]->res_handle();
+            m.mapped_vertices     = scene->vertices(mesh);
+            m.mapped_quantization = mesh.quantization;
+            m.mapped_indices      = scene->indices(mesh);
+            m.mapped_lods         = {mesh.lods, mesh.lod_count};
+            m.mapped_meshlets     = scene->meshlets(mesh);
+            m.backing             = scene;
+            meshes.push_back(m);
+        }
+        _timings.create_resources = stage.lap();
+        _timings.total            = total.lap();
+
+        return Object{meshes};
+    }
+
+    void SceneImporter::unload(const Object &object) {
+        auto gpu   = Engine::instance().get_gpu_res_mgr();
+        auto cache = Engine::instance().get_texture_cache();
+
+        // Meshes and materials go first, textures only once nothing left refers to them.
+        std::unordered_set<uint32_t> materials, meshes;
+        std::vector<Texture *> textures;
+        for (const auto &m : object.meshes) {
+            // References to one source mesh share the resource.
+            if (meshes.insert(m.id).second == false) { continue; }
+            if (materials.insert(m.material.id).second) {
+                for (const auto &[_, texture] : gpu->get_resource(m.material)->textures) {
+                    textures.push_back(texture);
+                }
+                gpu->destroy_resource(m.material);
+            }
+            gpu->destroy_resource(m.res_handle());
+        }
+        for (const auto texture : textures) { cache->release(texture); }
+    }
+
+    std::shared_ptr<const CachedScene> SceneImporter::_import_geometry(
+        const std::filesystem::path &source, const MeshCache::Key &key) {
+        static constexpr aiTextureType texture_slots[CachedScene::TEXTURE_SLOTS]{
+            aiTextureType_DIFFUSE,
+            aiTextureType_NORMALS,
+            aiTextureType_METALNESS,
+            aiTextureType_DIFFUSE_ROUGHNESS,
+            aiTextureType_EMISSIVE,
+        };
+
+        StageTimer stage;
+
+        Assimp::Importer importer;
+        auto io = new RecordingIOSystem;
+        importer.SetIOHandler(io);
+        const auto scene = importer.ReadFile(source.string(), key.import_flags);
+        if (scene == nullptr || scene->mRootNode == nullptr) { return nullptr; }
+        _timings.read = stage.lap();
+
+        SceneData data;
+        data.dependencies = io->opened;
+
+        // Meshes in the order the node tree lists them. Geometry of a mesh referenced by many
+        // nodes is stored once, unique[i] is the i-th distinct aiMesh and its record.
+        std::vector<std::pair<uint32_t, CachedScene::MeshRecord>> unique;
+        std::vector<uint32_t> mesh_refs;
+        {
+            std::unordered_map<uint32_t, uint32_t> seen;
+            std::vector<const aiNode *> stack{scene->mRootNode};
+            uint32_t vertex_total{0u};
+            while (stack.empty() == false) {
+                const auto node = stack.back();
+                stack.pop_back();
+                for (auto i = node->mNumChildren; i > 0u; --i) {
+                    stack.push_back(node->mChildren[i - 1u]);
+                }
+
+                for (auto i = 0u; i < node->mNumMeshes; ++i) {
+                    const auto idx = node->mMeshes[i];
+                    auto [it, inserted] = seen.try_emplace(idx, (uint32_t)unique.size());
+                    if (inserted) {
+                        const auto mesh = scene->mMeshes[idx];
+                        unique.emplace_back(
+                            idx,
+                            CachedScene::MeshRecord{.quantization  = {},
+                                                    .first_vertex  = vertex_total,
+                                                    .vertex_count  = mesh->mNumVertices,
+                                                    .first_index   = 0u,
+                                                    .index_count   = 0u,
+                                                    .material      = mesh->mMaterialIndex,
+                                                    .lod_count     = 0u,
+                                                    .lods          = {},
+                                                    .first_meshlet = 0u,
+                                                    .meshlet_count = 0u});
+                        vertex_total += mesh->mNumVertices;
+                    }
+                    mesh_refs.push_back(it->second);
+                }
+            }
+            data.vertices.resize(vertex_total);
+        }
+        _timings.flatten = stage.lap();
+
+        // Every mesh writes its own range of the vertices, so they need no synchronization. The
+        // float layout only lives in per mesh scratch buffers, which are reordered for the vertex
+        // cache, split into meshlets, simplified into LODs and quantized with the mesh's own
+        // ranges into the packed layout. Index and meshlet counts are only known after that, so
+        // both are joined after.
+        std::vector<mesh_optimizer::Report> reports(unique.size());
+        std::vector<std::vector<uint32_t>> unique_indices(unique.size());
+        std::vector<std::vector<Meshlet>> unique_meshlets(unique.size());
+        std::atomic_bool non_triangle{false};
+        _pool.parallel_for((uint32_t)unique.size(), [&](uint32_t u) {
+            auto &[idx, rec]  = unique[u];
+            const auto mesh   = scene->mMeshes[idx];
+            constexpr auto fv = vertex_format::FLOATS_PER_VERTEX;
+
+            std::vector<float> vertices((size_t)mesh->mNumVertices * fv);
+            auto v = vertices.data();
+            for (auto j = 0u; j < mesh->mNumVertices; ++j, v += fv) {
+                const auto uv = mesh->mTextureCoords[0] ? mesh->mTextureCoords[0][j] : aiVector3D{};
+                const auto t  = mesh->mTangents ? mesh->mTangents[j] : aiVector3D{};
+                const auto b  = mesh->mBitangents ? mesh->mBitangents[j] : aiVector3D{};
+                const auto &p = mesh->mVertices[j];
+                const float vertex[]{p.x, p.y, p.z, uv.x, uv.y, uv.z, t.x, t.y, t.z, b.x, b.y, b.z};
+                memcpy(v, vertex, sizeof(vertex));
+            }
+
+            auto &indices = unique_indices[u];
+            indices.resize((size_t)mesh->mNumFaces * 3u);
+            auto i = indices.data();
+            for (auto j = 0u; j < mesh->mNumFaces; ++j, i += 3) {
+                const auto &face = mesh->mFaces[j];
+                if (face.mNumIndices != 3u) {
+                    non_triangle = true;
+                    return;
+                }
+                i[0] = face.mIndices[0];
+                i[1] = face.mIndices[1];
+                i[2] = face.mIndices[2];
+            }
+
+            reports[u]         = mesh_optimizer::optimize(indices, vertices, fv);
+            unique_meshlets[u] = meshlet_builder::build(indices, vertices, fv);
+
+            const auto lods = mesh_simplifier::build_lods(indices, vertices, fv);
+            rec.lod_count   = (uint32_t)lods.size();
+            std::copy(lods.begin(), lods.end(), rec.lods);
+            rec.index_count = (uint32_t)indices.size();
+
+            rec.quantization = vertex_format::quantization(vertices);
+            vertex_format::pack(vertices, rec.quantization, &data.vertices[rec.first_vertex]);
+        });
+        if (non_triangle) { return nullptr; }
+
+        for (auto u = 0u; u < unique.size(); ++u) {
+            const auto &indices            = unique_indices[u];
+            const auto &meshlets           = unique_meshlets[u];
+            unique[u].second.first_index   = (uint32_t)data.indices.size();
+            unique[u].second.first_meshlet = (uint32_t)data.meshlets.size();
+            unique[u].second.meshlet_count = (uint32_t)meshlets.size();
+            data.indices.insert(data.indices.end(), indices.begin(), indices.end());
+            data.meshlets.insert(data.meshlets.end(), meshlets.begin(), meshlets.end());
+        }
+
+        const auto accumulate = [](mesh_optimizer::VertexCacheStats &sum,
+                                   const mesh_optimizer::VertexCacheStats &add) {
+            sum.misses += add.misses;
+            sum.triangles += add.triangles;
+            sum.vertices += add.vertices;
+        };
+        for (const auto &r : reports) {
+            accumulate(_optimization.before, r.before);
+            accumulate(_optimization.after, r.after);
+        }
+
+        for (const auto u : mesh_refs) { data.meshes.push_back(unique[u].second); }
+
+        data.materials.resize(scene->mNumMaterials);
+        for (auto i = 0u; i < scene->mNumMaterials; ++i) {
+            const auto material = scene->mMaterials[i];
+            for (auto slot = 0u; slot < CachedScene::TEXTURE_SLOTS; ++slot) {
+                aiString path;
+                if (material->GetTextureCount(texture_slots[slot]) == 0u
+                    || material->GetTexture(texture_slots[slot], 0, &path) != aiReturn_SUCCESS) {
+                    continue;
+                }
+                data.materials[i][slot] = path.C_Str();
+            }
+        }
+        _timings.process = stage.lap();
+
+        auto blob      = _cache.store(key, data);
+        _timings.store = stage.lap();
+        return blob;
+    }
+} // namespace eng
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <filesystem>
+
+#include <engine/scene/mesh_cache.hpp>
+#include <engine/scene/mesh_optimizer.hpp>
+#include <engine/types/thread_pool.hpp>
+#include <engine/renderer/renderer.hpp>
+
+namespace eng {
+    class ShaderProgram;
+
+    // Turns a model file into an Object for Renderer::register_object. Geometry comes from the
+    // mesh cache; on a miss Assimp reads the file, the node tree is flattened and meshes are
+    // interleaved, optimized and packed in parallel on the thread pool. Textures go to the
+    // TextureLoader and stream in after import returns. GL resource creation runs on the calling
+    // thread, which has to own the GL context.
+    class SceneImporter {
+      public:
+        // Wall time of every stage of the last import, in milliseconds. Read, flatten, process
+        // and store stay zero on a cache hit.
+        struct Timings {
+            double cache_lookup{0.}, read{0.}, flatten{0.}, process{0.}, store{0.};
+            double materials{0.}, create_resources{0.}, total{0.};
+            bool cache_hit{false};
+        };
+
+        explicit SceneImporter(ThreadPool &pool, MeshCache &cache) : _pool{pool}, _cache{cache} {}
+
+        // Returns an object without meshes if the file could not be imported.
+        Object import(const std::filesystem::path &source,
+                      uint32_t import_flags,
+                      ShaderProgram *forward_program);
+
+        // Destroys the meshes and materials import created for object and releases its
+        // textures. Unregister the object from the renderer first.
+        void unload(const Object &object);
+
+        const Timings &timings() const { return _timings; }
+        // Vertex cache stats of the last import summed over its meshes, zero on a cache hit.
+        const mesh_optimizer::Report &optimization() const { return _optimization; }
+
+      private:
+        std::shared_ptr<const CachedScene> _import_geometry(const std::filesystem::path &source,
+                                                            const MeshCache::Key &key);
+
+        ThreadPool &_pool;
+        MeshCache &_cache;
+        Timings _timings;
+        mesh_optimizer::Report _optimization;
+    };
+} // namespace eng
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <iterator>
+#include <cassert>
+
+namespace eng {
+    // Hands out [offset, offset + size) ranges of some linear storage (elements of a GPU buffer,
+    // for example). Freed ranges go to a free list sorted by offset and get merged with their
+    // neighbours, allocation takes the first free range that fits or grows the storage at the end.
+    class RangeAllocator {
+      public:
+        struct Range {
+            uint32_t offset{0u}, size{0u};
+        };
+
+        Range allocate(uint32_t size) {
+            if (size == 0u) { return Range{}; }
+
+            for (auto it = _free.begin(); it != _free.end(); ++it) {
+                if (it->second < size) { continue; }
+
+                const Range r{it->first, size};
+                if (it->second > size) { _free.emplace(it->first + size, it->second - size); }
+                _free.erase(it);
+                return r;
+            }
+
+            const Range r{_end, size};
+            _end += size;
+            return r;
+        }
+
+        void free(Range r) {
+            if (r.size == 0u) { return; }
+            assert(r.offset + r.size <= _end && "Freeing range outside of the allocator");
+
+            auto next = _free.lower_bound(r.offset);
+            if (next != _free.begin()) {
+                auto prev = std::prev(next);
+                assert(prev->first + prev->second <= r.offset && "Double free");
+                if (prev->first + prev->second == r.offset) {
+                    r.offset = prev->first;
+                    r.size += prev->second;
+                    _free.erase(prev);
+                }
+            }
+            if (next != _free.end() && r.offset + r.size == next->first) {
+                r.size += next->second;
+                _free.erase(next);
+            }
+
+            if (r.offset + r.size == _end) {
+                _end = r.offset;
+            } else {
+                _free.emplace(r.offset, r.size);
+            }
+        }
+
+        // One past the last element that was ever handed out and is not freed at the very end.
+        uint32_t end() const { return _end; }
+
+      private:
+        std::map<uint32_t, uint32_t> _free;
+        uint32_t _end{0u};
+    };
+} // namespace eng
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <cassert>
+
+#include <engine/types/idresource.hpp>
+
+namespace eng {
+    // Elements are kept contiguous, handles stay valid until the element they point to is erased.
+    // Handle id packs slot index (lower INDEX_BITS) and slot generation (upper bits), so a handle
+    // of an erased element never resolves to the element that reuses its slot.
+    template <typename T> class SlotMap {
+      public:
+        static constexpr uint32_t INDEX_BITS = 24u;
+        static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1u;
+        static constexpr uint32_t GEN_MASK   = (1u << (32u - INDEX_BITS)) - 1u;
+
+        Handle<T> insert(T &&t) {
+            uint32_t slot_idx;
+            if (_free_slots.empty() == false) {
+                slot_idx = _free_slots.back();
+                _free_slots.pop_back();
+            } else {
+                slot_idx = (uint32_t)_slots.size();
+                _slots.emplace_back();
+            }
+            assert(slot_idx <= INDEX_MASK && "SlotMap ran out of slots");
+
+            auto &slot     = _slots[slot_idx];
+            slot.dense_idx = (uint32_t)_dense.size();
+            _dense.push_back(std::move(t));
+            _dense_to_slot.push_back(slot_idx);
+
+            return _make_handle(slot_idx, slot.generation);
+        }
+        Handle<T> insert(const T &t) { return insert(T{t}); }
+
+        // Returns dense index that the erased element occupied. Unless it was the last one,
+        // the element previously stored at index size() (after the call) is moved there.
+        uint32_t erase(Handle<T> h) {
+            assert(contains(h) && "Bad handle");
+
+            auto &slot           = _slots[_slot_index(h)];
+            const auto erased_at = slot.dense_idx;
+            const auto last      = (uint32_t)_dense.size() - 1u;
+
+            if (erased_at != last) {
+                _dense[erased_at]         = std::move(_dense[last]);
+                _dense_to_slot[erased_at] = _dense_to_slot[last];
+                _slots[_dense_to_slot[erased_at]].dense_idx = erased_at;
+            }
+            _dense.pop_back();
+            _dense_to_slot.pop_back();
+
+            slot.generation = (slot.generation + 1u) & GEN_MASK;
+            if (slot.generation == 0u) { slot.generation = 1u; }
+            _free_slots.push_back(_slot_index(h));
+
+            return erased_at;
+        }
+
+        bool contains(Handle<T> h) const {
+            const auto idx = _slot_index(h);
+            return idx < _slots.size() && _slots[idx].generation == _generation(h);
+        }
+
+        T *try_get(Handle<T> h) { return contains(h) ? &get(h) : nullptr; }
+        T &get(Handle<T> h) {
+            assert(contains(h) && "Bad handle");
+            return _dense[_slots[_slot_index(h)].dense_idx];
+        }
+        const T &get(Handle<T> h) const {
+            assert(contains(h) && "Bad handle");
+            return _dense[_slots[_slot_index(h)].dense_idx];
+        }
+
+        uint32_t dense_index(Handle<T> h) const { return _slots[_slot_index(h)].dense_idx; }
+        Handle<T> handle_at(uint32_t dense_idx) const {
+            const auto slot_idx = _dense_to_slot[dense_idx];
+            return _make_handle(slot_idx, _slots[slot_idx].generation);
+        }
+        T &get_dense(uint32_t dense_idx) { return _dense[dense_idx]; }
+        const T &get_dense(uint32_t dense_idx) const { return _dense[dense_idx]; }
+
+        void clear() {
+            while (_dense.empty() == false) { erase(handle_at((uint32_t)_dense.size() - 1u)); }
+        }
+
+        auto data() noexcept { return _dense.data(); }
+        auto begin() noexcept { return _dense.begin(); }
+        auto end() noexcept { return _dense.end(); }
+        auto begin() const noexcept { return _dense.cbegin(); }
+        auto end() const noexcept { return _dense.cend(); }
+        auto size() const noexcept { return _dense.size(); }
+        bool empty() const noexcept { return _dense.empty(); }
+
+      private:
+        struct Slot {
+            uint32_t dense_idx{0u};
+            uint32_t generation{1u};
+        };
+
+        static Handle<T> _make_handle(uint32_t slot_idx, uint32_t generation) {
+            return Handle<T>{(generation << INDEX_BITS) | slot_idx};
+        }
+        static uint32_t _slot_index(Handle<T> h) { return h.id & INDEX_MASK; }
+        static uint32_t _generation(Handle<T> h) { return h.id >> INDEX_BITS; }
+
+        std::vector<T> _dense;
+        std::vector<uint32_t> _dense_to_slot;
+        std::vector<Slot> _slots;
+        std::vector<uint32_t> _free_slots;
+    };
+} // namespace eng
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+
+namespace eng {
+    // Fixed set of worker threads pulling jobs from one queue. Jobs must not touch GL - there is
+    // only one context and it belongs to the main thread.
+    class ThreadPool {
+      public:
+        explicit ThreadPool(uint32_t thread_count = default_thread_count()) {
+            for (auto i = 0u; i < thread_count; ++i) {
+                _workers.emplace_back([this] { _work(); });
+            }
+        }
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+        ~ThreadPool() {
+            {
+                std::scoped_lock lock{_mutex};
+                _stopping = true;
+            }
+            _cv.notify_all();
+            for (auto &w : _workers) { w.join(); }
+        }
+
+        template <typename F> auto submit(F &&f) -> std::future<std::invoke_result_t<F>> {
+            using R   = std::invoke_result_t<F>;
+            auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+            auto fut  = task->get_future();
+            {
+                std::scoped_lock lock{_mutex};
+                _jobs.emplace_back([task] { (*task)(); });
+            }
+            _cv.notify_one();
+            return fut;
+        }
+
+        // Calls fn(i) for every i in [0, count) on the workers and the calling thread, returns
+        // once all calls are done.
+        void parallel_for(uint32_t count, const std::function<void(uint32_t)> &fn) {
+            if (count == 0u) { return; }
+
+            std::atomic_uint32_t next{0u};
+            const auto run = [&] {
+                for (auto i = next++; i < count; i = next++) { fn(i); }
+            };
+
+            std::vector<std::future<void>> helpers;
+            const auto helper_count = std::min<uint32_t>(size(), count - 1u);
+            for (auto i = 0u; i < helper_count; ++i) { helpers.push_back(submit(run)); }
+            run();
+            for (auto &h : helpers) { h.get(); }
+        }
+
+        uint32_t size() const { return (uint32_t)_workers.size(); }
+
+        // One worker per hardware thread, minus the one the caller runs on.
+        static uint32_t default_thread_count() {
+            return std::max(std::thread::hardware_concurrency(), 2u) - 1u;
+        }
+
+      private:
+        void _work() {
+            while (true) {
+                std::function<void()> job;
+                {
+                    std::unique_lock lock{_mutex};
+                    _cv.wait(lock, [this] { return _stopping || _jobs.empty() == false; });
+                    if (_jobs.empty()) { return; }
+                    job = std::move(_jobs.front());
+                    _jobs.pop_front();
+                }
+                job();
+            }
+        }
+
+        std::vector<std::thread> _workers;
+        std::deque<std::function<void()>> _jobs;
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        bool _stopping{false};
+    };
+} // namespace eng
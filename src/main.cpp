@@ -16,10 +16,10 @@
 #include <engine/gpu/buffers/buffer.hpp>
 #include <engine/gpu/resource_manager/gpu_res_mgr.hpp>
 #include <engine/gpu/framebuffer/framebuffer.hpp>
+#include <engine/scene/mesh_cache.hpp>
+#include <engine/scene/scene_importer.hpp>
 
 #include <GLFW/glfw3.h>
-#include <assimp/scene.h>
-#include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <stb_image.h>
 #include <imgui/imgui.h>
@@ -45,100 +45,94 @@ int main() {
                                                      | GL_STENCIL_BUFFER_BIT);
 
     auto &prog = *engine.get_gpu_res_mgr()->create_resource(ShaderProgram{"a"});
+    const auto &programs = engine.get_program_cache()->stats();
+    printf("programs: %u from binaries in %.1f ms, %u from source in %.1f ms, %u rejected\n",
+           programs.hits,
+           programs.binary_ms,
+           programs.misses,
+           programs.source_ms,
+           programs.rejected);
 
     {
-        Assimp::Importer i;
-        auto scene
-            = i.ReadFile("3dmodels/bust/scene.gltf",
-                         aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        MeshCache cache{"cache/"};
+        SceneImporter importer{*engine.get_thread_pool(), cache};
+        auto o = importer.import("3dmodels/bust/scene.gltf",
+                                 aiProcess_Triangulate | aiProcess_FlipUVs
+                                     | aiProcess_CalcTangentSpace,
+                                 &prog);
+        assert((o.meshes.empty() == false && "Could not import the model"));
+
+        const auto &t = importer.timings();
+        printf("import (%s): lookup %.1f, read %.1f, flatten %.1f, process %.1f, store %.1f, "
+               "materials %.1f, create %.1f, total %.1f ms\n",
+               t.cache_hit ? "cache hit" : "cache miss",
+               t.cache_lookup,
+               t.read,
+               t.flatten,
+               t.process,
+               t.store,
+               t.materials,
+               t.create_resources,
+               t.total);
+        const auto &opt = importer.optimization();
+        printf("vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+               opt.before.acmr(),
+               opt.after.acmr(),
+               opt.before.atvr(),
+               opt.after.atvr());
 
-        std::vector<Mesh> meshes;
-
-        std::function<void(const aiScene *scene, const aiNode *node)> parse_scene;
-        parse_scene = [&](const aiScene *scene, const aiNode *node) {
-            for (auto i = 0u; i < node->mNumMeshes; ++i) {
-                auto mesh = scene->mMeshes[node->mMeshes[i]];
-
-                std::vector<float> mesh_vertices;
-                std::vector<unsigned> mesh_indices;
-
-                for (auto j = 0u; j < mesh->mNumVertices; ++j) {
-                    auto &v = mesh->mVertices[j];
-
-                    mesh_vertices.push_back(v.x);
-                    mesh_vertices.push_back(v.y);
-                    mesh_vertices.push_back(v.z);
-                    mesh_vertices.push_back(mesh->mTextureCoords[0][j].x);
-                    mesh_vertices.push_back(mesh->mTextureCoords[0][j].y);
-                    mesh_vertices.push_back(mesh->mTextureCoords[0][j].z);
-                    mesh_vertices.push_back(mesh->mTangents[j].x);
-                    mesh_vertices.push_back(mesh->mTangents[j].y);
-                    mesh_vertices.push_back(mesh->mTangents[j].z);
-                    mesh_vertices.push_back(mesh->mBitangents[j].x);
-                    mesh_vertices.push_back(mesh->mBitangents[j].y);
-                    mesh_vertices.push_back(mesh->mBitangents[j].z);
-                }
-
-                for (auto j = 0u; j < mesh->mNumFaces; ++j) {
-                    auto &face = mesh->mFaces[j];
-
-                    assert((face.mNumIndices == 3 && "Accepting only triangular faces"));
-
-                    mesh_indices.push_back(face.mIndices[0]);
-                    mesh_indices.push_back(face.mIndices[1]);
-                    mesh_indices.push_back(face.mIndices[2]);
-                }
-
-                auto material = scene->mMaterials[mesh->mMaterialIndex];
-                aiString path;
-
-                std::array<std::pair<aiTextureType, TextureType>, 5> textures_types{{
-                    {aiTextureType_DIFFUSE, TextureType::Diffuse},
-                    {aiTextureType_NORMALS, TextureType::Normal},
-                    {aiTextureType_METALNESS, TextureType::Metallic},
-                    {aiTextureType_DIFFUSE_ROUGHNESS, TextureType::Roughness},
-                    {aiTextureType_EMISSIVE, TextureType::Emissive},
-                }};
-
-                Material *def_mat = engine.get_gpu_res_mgr()->create_resource(Material{});
-                def_mat->passes[RenderPass::Forward] = &prog;
-
-                for (const auto &[ait, t] : textures_types) {
-                    const auto ait_count = material->GetTextureCount(ait);
-
-                    if (ait_count == 0) { continue; }
-
-                    aiString path;
-                    std::string texture_path{"3dmodels/bust/"};
-
-                    material->GetTexture(ait, 0, &path);
-                    assert((path.length > 0 && "invalid path to texture"));
-                    texture_path += path.C_Str();
-
-                    auto texture         = engine.get_gpu_res_mgr()->create_resource(Texture{
-                        TextureSettings{GL_RGB8, GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_LINEAR, 7},
-                        TextureImageDataDescriptor{texture_path}});
-                    def_mat->textures[t] = texture;
-                }
-
-                Mesh &m    = *engine.get_gpu_res_mgr()->create_resource(Mesh{});
-                m.material = def_mat->res_handle();
-                m.vertices = mesh_vertices;
-                m.indices  = mesh_indices;
-                meshes.push_back(m);
-            }
-
-            for (auto i = 0u; i < node->mNumChildren; ++i) {
-                parse_scene(scene, node->mChildren[i]);
-            }
-        };
-
-        parse_scene(scene, scene->mRootNode);
-
-        Object o{meshes};
         engine.get_renderer()->register_object(&o);
     }
 
+    engine.get_gui()->add_draw([&engine] {
+        const auto &programs = engine.get_program_cache()->stats();
+        ImGui::Begin("Shaders");
+        if (ImGui::Button("reload")) { engine.get_renderer()->reload_shaders(); }
+        ImGui::Text("programs: %u from binaries in %.1f ms, %u from source in %.1f ms",
+                    programs.hits,
+                    programs.binary_ms,
+                    programs.misses,
+                    programs.source_ms);
+        const auto &uniforms = ShaderProgram::uniform_stats();
+        ImGui::Text("uniforms: %u set by name, %u by handle, %u GL calls, %u before caching",
+                    uniforms.set_by_name,
+                    uniforms.set_by_handle,
+                    uniforms.gl_calls(),
+                    uniforms.gl_calls_uncached());
+        ImGui::End();
+    });
+
+    engine.get_gui()->add_draw([&engine] {
+        const auto loader = engine.get_texture_loader();
+        const auto cache  = engine.get_texture_cache()->stats();
+        ImGui::Begin("Textures");
+        ImGui::Text("streaming: %u pending, %.1f MB uploaded",
+                    loader->pending(),
+                    loader->uploaded_bytes() / 1048576.0);
+        ImGui::Text("cache: %u hits, %u misses, %.0f%% hit ratio, %.1f MB saved",
+                    cache.hits,
+                    cache.misses,
+                    cache.hit_ratio() * 100.f,
+                    cache.bytes_saved / 1048576.0);
+
+        auto &residency      = engine.get_renderer()->texture_residency;
+        const auto resident  = residency.stats();
+        static int budget_mb = (int)(residency.budget >> 20);
+        if (ImGui::SliderInt("residency budget (MB)", &budget_mb, 16, 4096)) {
+            residency.budget = (size_t)budget_mb << 20;
+        }
+        ImGui::Text("residency: %u textures, %u evicted, %.1f MB resident",
+                    resident.textures,
+                    resident.evicted,
+                    resident.resident_bytes / 1048576.0);
+        ImGui::Text("calls: %llu resident, %llu non-resident, %llu skipped, %llu evictions",
+                    (unsigned long long)resident.make_resident_calls,
+                    (unsigned long long)resident.make_non_resident_calls,
+                    (unsigned long long)resident.skipped_calls,
+                    (unsigned long long)resident.evictions);
+        ImGui::End();
+    });
+
     engine.start();
 
     return 0;
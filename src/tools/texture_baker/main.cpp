@@ -0,0 +1,227 @@
+// Bakes images into block compressed DDS files with a full mip chain, next to the source as
+// <image>.<type>.dds, where the scene importer picks them up instead of the source for slots of
+// that type.
+//
+//   texture_baker [--type diffuse|normal|metallic|roughness|emissive]
+//                 [--format bc1|bc3|bc4|bc5|bc7] [--channel r|g|b|a]
+//                 [--filter box|kaiser|lanczos] [--threads n] [--bench] images...
+//
+// --type picks the format and mip settings the engine expects for that material slot (diffuse
+// by default), --format, --filter and --channel override them. --channel is the source channel
+// BC4 stores, green for roughness and red for everything else unless given.
+// --bench writes nothing and times mip generation with every filter and thread count instead.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <engine/types/thread_pool.hpp>
+#include <engine/gpu/texture/texture_baker.hpp>
+
+using namespace eng;
+using block_compression::BlockFormat;
+
+static const char *format_name(BlockFormat format) {
+    static constexpr const char *names[]{"BC1", "BC3", "BC4", "BC5", "BC7"};
+    return names[(uint32_t)format];
+}
+
+// Over the channels the format stores, of level 0.
+static double psnr(BlockFormat format,
+                   const std::vector<uint8_t> &source,
+                   const dds::Image &image,
+                   uint32_t channels) {
+    const auto decoded
+        = block_compression::decode(format, image.data.data(), image.width, image.height);
+    double error{0.0};
+    for (size_t i = 0u; i < decoded.size(); i += 4u) {
+        for (auto c = 0u; c < channels; ++c) {
+            const double d = (double)decoded[i + c] - (double)source[i + c];
+            error += d * d;
+        }
+    }
+    error /= (double)(decoded.size() / 4u * channels);
+    return error == 0.0 ? INFINITY : 10.0 * std::log10(255.0 * 255.0 / error);
+}
+
+// Mip chain generation throughput of every filter, on 1, 2, 4... threads up to the hardware's.
+static void benchmark(const std::string &input,
+                      const std::vector<uint8_t> &source,
+                      uint32_t width,
+                      uint32_t height,
+                      mip_generator::Settings mips) {
+    static constexpr const char *names[]{"box", "kaiser", "lanczos"};
+
+    const auto hardware = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<uint32_t> thread_counts;
+    for (auto n = 1u; n < hardware; n *= 2u) { thread_counts.push_back(n); }
+    thread_counts.push_back(hardware);
+
+    printf("%s: %ux%u mip chain\n", input.c_str(), width, height);
+    for (auto f = 0u; f < std::size(names); ++f) {
+        mips.filter = (mip_generator::Filter)f;
+        for (const auto n : thread_counts) {
+            ThreadPool pool{n - 1u};
+            auto best = INFINITY;
+            for (auto run = 0u; run < 3u; ++run) {
+                const auto start = std::chrono::steady_clock::now();
+                mip_generator::generate(source.data(), width, height, mips, &pool);
+                best = std::min(best,
+                                std::chrono::duration<float, std::milli>(
+                                    std::chrono::steady_clock::now() - start)
+                                    .count());
+            }
+            printf("  %-8s %2u threads: %7.1f ms, %8.2f MPixel/s\n",
+                   names[f],
+                   n,
+                   best,
+                   (double)width * height / (best * 1000.0));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    static constexpr std::pair<std::string_view, TextureType> types[]{
+        {"diffuse", TextureType::Diffuse},
+        {"normal", TextureType::Normal},
+        {"metallic", TextureType::Metallic},
+        {"roughness", TextureType::Roughness},
+        {"emissive", TextureType::Emissive},
+    };
+    static constexpr std::string_view formats[]{"bc1", "bc3", "bc4", "bc5", "bc7"};
+    static constexpr std::string_view filters[]{"box", "kaiser", "lanczos"};
+    static constexpr std::string_view channels{"rgba"};
+
+    // Picked by name from a table, -1 if value is not in it.
+    const auto find = [](std::span<const std::string_view> names, std::string_view value) {
+        const auto it = std::find(names.begin(), names.end(), value);
+        return it == names.end() ? -1 : (int)(it - names.begin());
+    };
+
+    auto type = TextureType::Diffuse;
+    int format{-1}, filter{-1}, channel{-1};
+    bool bench{false};
+    auto threads = ThreadPool::default_thread_count();
+    std::vector<std::string> inputs;
+    for (auto i = 1; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+        const auto value = i + 1 < argc ? std::string_view{argv[i + 1]} : std::string_view{};
+        bool known{true};
+        if (arg == "--type") {
+            known = false;
+            for (const auto &[name, t] : types) {
+                if (name == value) {
+                    type  = t;
+                    known = true;
+                }
+            }
+            ++i;
+        } else if (arg == "--format") {
+            format = find(formats, value);
+            known  = format >= 0;
+            ++i;
+        } else if (arg == "--filter") {
+            filter = find(filters, value);
+            known  = filter >= 0;
+            ++i;
+        } else if (arg == "--channel") {
+            channel = value.size() == 1u ? (int)channels.find(value[0]) : -1;
+            known   = channel >= 0;
+            ++i;
+        } else if (arg == "--threads") {
+            threads = (uint32_t)std::max(std::atoi(value.data() ? value.data() : "0"), 1) - 1u;
+            ++i;
+        } else if (arg == "--bench") {
+            bench = true;
+        } else {
+            inputs.emplace_back(arg);
+        }
+        if (known == false) {
+            fprintf(stderr, "Bad value for %s: %s\n", argv[i - 1], value.data() ? argv[i] : "");
+            return 1;
+        }
+    }
+    if (inputs.empty()) {
+        fprintf(stderr,
+                "usage: texture_baker [--type diffuse|normal|metallic|roughness|emissive]\n"
+                "                     [--format bc1|bc3|bc4|bc5|bc7] [--channel r|g|b|a]\n"
+                "                     [--filter box|kaiser|lanczos] [--threads n] [--bench]\n"
+                "                     images...\n");
+        return 1;
+    }
+
+    auto settings = texture_baker::settings_for(type);
+    if (channel >= 0) { settings.source_channel = (uint32_t)channel; }
+    if (format >= 0) { settings.format = (BlockFormat)format; }
+    if (filter >= 0) { settings.mips.filter = (mip_generator::Filter)filter; }
+
+    // --threads counts the calling thread, which takes part in ThreadPool::parallel_for.
+    ThreadPool pool{threads};
+    auto failed = 0;
+    for (const auto &input : inputs) {
+        int x, y, n;
+        auto pixels = stbi_load(input.c_str(), &x, &y, &n, 4);
+        if (pixels == nullptr) {
+            fprintf(stderr, "Image not found at path: %s\n", input.c_str());
+            failed++;
+            continue;
+        }
+        const std::vector<uint8_t> source{pixels, pixels + (size_t)x * y * 4u};
+        stbi_image_free(pixels);
+        if (bench) {
+            benchmark(input, source, x, y, settings.mips);
+            continue;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto image = texture_baker::bake(source.data(), x, y, settings, &pool);
+        const auto ms
+            = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                  .count();
+
+        const auto output = texture_baker::baked_path(input, type);
+        if (dds::write(output, image) == false) {
+            failed++;
+            continue;
+        }
+
+        // PSNR of what BC4 stores is measured against the channel it was given.
+        auto reference = source;
+        if (settings.format == BlockFormat::BC4) {
+            for (size_t i = 0u; i < reference.size(); i += 4u) {
+                reference[i] = source[i + settings.source_channel];
+            }
+        }
+        size_t pixel_count{0u};
+        for (auto i = 0u; i < image.mip_count(); ++i) {
+            pixel_count += (size_t)std::max(x >> i, 1) * std::max(y >> i, 1);
+        }
+        printf("%s -> %s: %s %dx%d, %u mips, %zu bytes (%.1fx smaller than RGBA8), %.1f ms, "
+               "%.2f MPixel/s, PSNR %.2f dB\n",
+               input.c_str(),
+               output.string().c_str(),
+               format_name(settings.format),
+               x,
+               y,
+               image.mip_count(),
+               image.data.size(),
+               (double)pixel_count * 4.0 / (double)image.data.size(),
+               ms,
+               (double)pixel_count / (ms * 1000.0),
+               psnr(settings.format,
+                    reference,
+                    image,
+                    block_compression::channel_count(settings.format)));
+    }
+    return failed == 0 ? 0 : 1;
+}
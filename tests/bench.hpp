@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+#include <limits>
+
+namespace test {
+    // Results go here, so the compiler cannot drop the work that produced them.
+    inline volatile uint64_t sink{0u};
+
+    inline double elapsed_ms(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+    }
+
+    // Fastest of runs calls of fn, in milliseconds.
+    template <typename F> double best_ms(uint32_t runs, F &&fn) {
+        auto best = std::numeric_limits<double>::max();
+        for (auto i = 0u; i < runs; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            best = std::min(best, elapsed_ms(start));
+        }
+        return best;
+    }
+} // namespace test
@@ -0,0 +1,47 @@
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <engine/renderer/culling.hpp>
+
+#include "bench.hpp"
+
+using namespace eng;
+
+// 1M random spheres in a 200 unit cube around a 90 degree camera, about a fifth of them visible.
+int main() {
+    constexpr auto count = 1'000'000u, runs = 15u;
+
+    std::mt19937 rng{3u};
+    std::uniform_real_distribution<float> u{-100.f, 100.f};
+    culling::SphereSoA spheres;
+    spheres.resize(count);
+    for (auto i = 0u; i < count; ++i) {
+        spheres.set(i, glm::vec4{u(rng), u(rng), u(rng), std::abs(u(rng)) * .02f});
+    }
+    const auto up      = glm::vec3{0.f, 1.f, 0.f};
+    const auto view    = glm::lookAt(glm::vec3{0.f}, glm::vec3{.3f, .1f, -1.f}, up);
+    const auto pv      = glm::perspective(glm::radians(90.f), 16.f / 9.f, .1f, 100.f) * view;
+    const auto frustum = culling::Frustum::from_matrix(pv);
+
+    std::vector<uint32_t> out(count);
+    const auto time = [&](const char *name, auto path) {
+        uint32_t visible{0u};
+        const auto ms = test::best_ms(runs, [&] { visible = path(frustum, spheres, out.data()); });
+        std::printf("  %-7s %5.2f ns per sphere, %u visible\n", name, ms * 1e6 / count, visible);
+    };
+
+    std::printf("Frustum culling of %u spheres:\n", count);
+    time("scalar", culling::frustum_cull_scalar);
+    time("sse", culling::frustum_cull_sse);
+    if (culling::has_avx()) {
+        time("avx", culling::frustum_cull_avx);
+    } else {
+        std::printf("  avx     not supported by this CPU\n");
+    }
+}
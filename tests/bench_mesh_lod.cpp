@@ -0,0 +1,87 @@
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <engine/renderer/renderer.hpp>
+#include <engine/renderer/culling.hpp>
+#include <engine/scene/mesh_simplifier.hpp>
+
+#include "test_meshes.hpp"
+
+using namespace eng;
+
+// Triangles drawn per frame with and without LODs: a camera flies low over a 32x32 grid of
+// 16k triangle spheres at 1080p with a 90 degree fovy, 200 frames through cull_instances.
+int main() {
+    constexpr auto frames = 200u, grid = 32u;
+
+    auto mesh       = test::bumpy_sphere(64u, 128u);
+    const auto lods = mesh_simplifier::build_lods(
+        mesh.indices, mesh.vertices, vertex_format::FLOATS_PER_VERTEX);
+    glm::vec4 errors{std::numeric_limits<float>::max()};
+    std::printf("LODs:");
+    for (auto k = 0u; k < lods.size(); ++k) {
+        errors[k] = lods[k].error;
+        std::printf(" %u triangles (error %.4f)", lods[k].index_count / 3u, lods[k].error);
+    }
+    std::printf("\n");
+
+    std::vector<glm::mat4> transforms;
+    for (auto x = 0u; x < grid; ++x) {
+        for (auto z = 0u; z < grid; ++z) {
+            transforms.push_back(glm::translate(
+                glm::mat4{1.f}, glm::vec3{(float)x * 4.f - 64.f, 0.f, -(float)z * 4.f}));
+        }
+    }
+    const std::vector<uint32_t> batches(transforms.size(), 0u);
+    const glm::vec4 bounds{0.f, 0.f, 0.f, 1.05f};
+
+    // Pixels per unit of error at distance 1, as Renderer computes lod_factor.
+    const auto pixels = 1080.f / (2.f * std::tan(glm::radians(90.f) * .5f));
+    for (const auto max_error_pixels : {1.f, 4.f}) {
+        uint64_t full{0u}, drawn{0u};
+        for (auto f = 0u; f < frames; ++f) {
+            const glm::vec3 camera{0.f, 2.f, 10.f - (float)f * .7f};
+            const auto pv = glm::perspective(glm::radians(90.f), 16.f / 9.f, .01f, 100.f)
+                            * glm::lookAt(camera, camera + glm::vec3{0.f, 0.f, -1.f},
+                                          glm::vec3{0.f, 1.f, 0.f});
+
+            DrawElementsIndirectCommand commands[MAX_LODS];
+            for (auto k = 0u; k < MAX_LODS; ++k) {
+                commands[k] = DrawElementsIndirectCommand{
+                    .count          = lods[std::min<size_t>(k, lods.size() - 1u)].index_count,
+                    .instance_count = 0u,
+                    .first_index    = 0u,
+                    .base_vertex    = 0u,
+                    .base_instance  = k * (uint32_t)transforms.size()};
+            }
+            std::vector<uint32_t> visible(transforms.size() * MAX_LODS);
+            culling::cull_instances(commands,
+                                    transforms,
+                                    batches,
+                                    std::span{&bounds, 1u},
+                                    std::span{&errors, 1u},
+                                    pv,
+                                    camera,
+                                    pixels / max_error_pixels,
+                                    nullptr,
+                                    visible);
+
+            for (const auto &c : commands) {
+                drawn += (uint64_t)c.count / 3u * c.instance_count;
+                full += (uint64_t)lods[0].index_count / 3u * c.instance_count;
+            }
+        }
+        std::printf("  max error %.0f px: %.2fM -> %.2fM triangles per frame (%.1f%%)\n",
+                    max_error_pixels,
+                    (double)full / frames / 1e6,
+                    (double)drawn / frames / 1e6,
+                    100. * (double)drawn / (double)full);
+    }
+}
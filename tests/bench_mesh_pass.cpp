@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "bench.hpp"
+#include "mesh_pass_scene.hpp"
+
+using namespace eng;
+
+// Objects registered in a stream into a large scene: every frame a few come in and a few go,
+// and the pass refreshes. Cost per frame of both batching modes.
+static void stream_into_scene(uint32_t scene_size, uint32_t frames) {
+    test::PassScene scene{400u, 8u};
+    std::mt19937 rng{1u};
+
+    for (const auto mode : {BatchingMode::Full, BatchingMode::Incremental}) {
+        MeshPass pass;
+        pass.batching_mode = mode;
+        std::vector<Handle<RenderObject>> live;
+        for (auto i = 0u; i < scene_size; ++i) {
+            live.push_back(scene.add(rng() % 400u, rng() % 8u));
+            pass.unbatched.push_back(live.back());
+        }
+        pass.refresh();
+
+        double total_ms{0.0};
+        for (auto frame = 0u; frame < frames; ++frame) {
+            for (auto i = 0u; i < 10u; ++i) {
+                live.push_back(scene.add(rng() % 400u, rng() % 8u));
+                pass.unbatched.push_back(live.back());
+            }
+            for (auto i = 0u; i < 3u; ++i) {
+                const auto k = rng() % live.size();
+                pass.remove(live[k]);
+                live[k] = live.back();
+                live.pop_back();
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            pass.refresh();
+            total_ms += test::elapsed_ms(start);
+        }
+        std::printf("  %-11s %8.3f ms per frame\n",
+                    mode == BatchingMode::Full ? "full" : "incremental",
+                    total_ms / frames);
+    }
+}
+
+// A pass of one object per unique mesh/material pair, refreshed from scratch, which looks up
+// every pair once. Next to it, the lookup as it was before batch ids were hashed: a linear scan
+// over the pairs seen so far.
+static void unique_pairs(uint32_t pairs) {
+    const auto materials = 10u, meshes = pairs / materials;
+    test::PassScene scene{meshes, materials};
+    std::vector<Handle<RenderObject>> objects;
+    for (auto i = 0u; i < pairs; ++i) {
+        objects.push_back(scene.add(i / materials, i % materials));
+    }
+
+    const auto hashed = test::best_ms(3u, [&] {
+        MeshPass pass;
+        pass.unbatched = objects;
+        pass.refresh();
+        test::sink     = pass.indirect_batches.size();
+    });
+
+    std::printf("  %6u pairs: refresh %8.2f ms", pairs, hashed);
+    if (pairs > 10'000u) {
+        std::printf(", linear scan skipped (quadratic)\n");
+        return;
+    }
+    const auto linear = test::best_ms(3u, [&] {
+        std::vector<std::pair<Handle<Mesh>, Handle<Material>>> ids;
+        for (auto i = 0u; i < pairs; ++i) {
+            const std::pair key{scene.meshes[i / materials], scene.materials[i % materials]};
+            if (std::find(ids.begin(), ids.end(), key) == ids.end()) { ids.push_back(key); }
+        }
+        test::sink = ids.size();
+    });
+    std::printf(", linear scan lookups alone %8.2f ms\n", linear);
+}
+
+int main() {
+    std::printf("MeshPass::refresh of one object per unique mesh/material pair:\n");
+    for (const auto pairs : {1'000u, 10'000u, 100'000u}) { unique_pairs(pairs); }
+
+    std::printf("MeshPass::refresh, 10 objects in and 3 out per frame:\n");
+    for (const auto size : {10'000u, 50'000u}) {
+        std::printf(" %u objects\n", size);
+        stream_into_scene(size, 100u);
+    }
+}
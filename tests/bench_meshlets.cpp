@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <set>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <engine/renderer/culling.hpp>
+#include <engine/scene/mesh_optimizer.hpp>
+#include <engine/scene/meshlet_builder.hpp>
+
+#include "test_meshes.hpp"
+
+using namespace eng;
+
+// How a 147k triangle sphere splits into meshlets after vertex cache optimization, and how much
+// of it cluster culling still draws on an orbit around a non-uniformly scaled instance, next to
+// how much of it actually faces the camera.
+int main() {
+    constexpr auto fv = vertex_format::FLOATS_PER_VERTEX;
+    auto mesh         = test::bumpy_sphere(192u, 384u);
+    mesh_optimizer::optimize(mesh.indices, mesh.vertices, fv);
+    const auto meshlets = meshlet_builder::build(mesh.indices, mesh.vertices, fv);
+
+    size_t max_vertices{0u}, vertices{0u};
+    uint32_t max_triangles{0u}, triangles{0u}, with_cone{0u};
+    for (const auto &m : meshlets) {
+        const std::set<uint32_t> unique{mesh.indices.begin() + m.first_index,
+                                        mesh.indices.begin() + m.first_index + m.index_count};
+        max_vertices  = std::max(max_vertices, unique.size());
+        vertices     += unique.size();
+        max_triangles = std::max(max_triangles, m.index_count / 3u);
+        triangles    += m.index_count / 3u;
+        with_cone    += m.cone.w < 1.f ? 1u : 0u;
+    }
+    std::printf("%u triangles -> %zu meshlets: at most %zu vertices and %u triangles, on average "
+                "%.1f and %.1f, %.0f%% with a usable cone\n",
+                triangles,
+                meshlets.size(),
+                max_vertices,
+                max_triangles,
+                (double)vertices / (double)meshlets.size(),
+                (double)triangles / (double)meshlets.size(),
+                100. * with_cone / (double)meshlets.size());
+
+    const auto center    = glm::vec3{2.f, 0.f, -1.f};
+    const auto transform = glm::scale(glm::translate(glm::mat4{1.f}, center), {2.f, 1.f, 1.5f});
+    std::vector<uint32_t> out(meshlets.size());
+    double drawn{0.}, front{0.};
+    constexpr auto steps = 8u;
+    for (auto k = 0u; k < steps; ++k) {
+        const auto a       = (float)k * .785f;
+        const auto camera  = center + 5.f * glm::vec3{std::cos(a), .3f, std::sin(a)};
+        const auto view    = glm::lookAt(camera, center, glm::vec3{0.f, 1.f, 0.f});
+        const auto pv      = glm::perspective(glm::radians(60.f), 16.f / 9.f, .1f, 100.f) * view;
+        const auto frustum = culling::Frustum::from_matrix(pv);
+
+        const auto count
+            = culling::cull_meshlets(meshlets, transform, &frustum, camera, out.data());
+        for (auto i = 0u; i < count; ++i) { drawn += meshlets[out[i]].index_count / 3u; }
+
+        for (auto t = 0u; t < mesh.indices.size(); t += 3u) {
+            const auto p = [&](uint32_t c) {
+                return glm::vec3{transform * glm::vec4{mesh.position(mesh.indices[t + c]), 1.f}};
+            };
+            const auto v0 = p(0u), v1 = p(1u), v2 = p(2u);
+            if (glm::dot(glm::cross(v1 - v0, v2 - v0), v0 - camera) < 0.f) { front += 1.; }
+        }
+    }
+    std::printf("orbit: meshlets drawn cover %.1f%% of the triangles, %.1f%% face the camera\n",
+                100. * drawn / steps / triangles,
+                100. * front / steps / triangles);
+}
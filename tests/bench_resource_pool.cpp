@@ -0,0 +1,73 @@
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <engine/engine.hpp>
+#include <engine/renderer/renderer.hpp>
+
+#include "bench.hpp"
+#include "gl_stubs.hpp"
+#include "legacy_res_mgr.hpp"
+
+using namespace eng;
+
+// Shuffled Mesh handle lookups, the pattern the renderer has when walking pass objects. The old
+// manager resolves through a type_index map and a binary search, the pool with one load.
+static void lookups(uint32_t count) {
+    constexpr auto passes = 20u;
+    std::mt19937 rng{count};
+
+    test::LegacyResMgr legacy;
+    GpuResMgr gpu;
+    std::vector<Handle<Mesh>> legacy_handles, handles;
+    for (auto i = 0u; i < count; ++i) {
+        legacy_handles.push_back(legacy.create_resource(Mesh{})->res_handle());
+        handles.push_back(gpu.create_resource(Mesh{})->res_handle());
+    }
+    std::shuffle(legacy_handles.begin(), legacy_handles.end(), rng);
+    std::shuffle(handles.begin(), handles.end(), rng);
+
+    const auto lookup_ns = [&](auto &mgr, const auto &hs) {
+        return test::best_ms(passes, [&] {
+                   uint64_t sum = 0u;
+                   for (const auto h : hs) { sum += mgr.get_resource(h)->id; }
+                   test::sink = sum;
+               })
+               * 1e6 / count;
+    };
+
+    std::printf("  %6u meshes: %7.1f ns old vs %5.1f ns pool per lookup\n", count,
+                lookup_ns(legacy, legacy_handles), lookup_ns(gpu, handles));
+}
+
+// Destroying every resource in random order. Release swaps the last live object into the hole,
+// so the cost per destroy should not grow with the pool.
+static void destroys(uint32_t count) {
+    constexpr auto runs = 3u;
+    std::mt19937 rng{count};
+    auto best = 1e30;
+    for (auto run = 0u; run < runs; ++run) {
+        GpuResMgr gpu;
+        std::vector<Handle<Mesh>> handles;
+        for (auto i = 0u; i < count; ++i) {
+            handles.push_back(gpu.create_resource(Mesh{})->res_handle());
+        }
+        std::shuffle(handles.begin(), handles.end(), rng);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto h : handles) { gpu.destroy_resource(h); }
+        best = std::min(best, test::elapsed_ms(start));
+    }
+    std::printf("  %6u meshes: %5.1f ns per destroy\n", count, best * 1e6 / count);
+}
+
+int main() {
+    test::stub_gl();
+    std::printf("GpuResMgr::get_resource, old type_index/sorted vector path vs resource pool:\n");
+    for (const auto count : {1'000u, 100'000u}) { lookups(count); }
+    std::printf("GpuResMgr::destroy_resource of every mesh in random order:\n");
+    for (const auto count : {1'000u, 100'000u}) { destroys(count); }
+}
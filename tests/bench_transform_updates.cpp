@@ -0,0 +1,125 @@
+#include <cstdint>
+#include <cstdio>
+#include <array>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include <engine/renderer/culling.hpp>
+
+#include "bench.hpp"
+#include "mesh_pass_scene.hpp"
+
+using namespace eng;
+
+// CPU side of moving objects, as Renderer does it, with GL left out: the full instance data
+// rebuild every frame something moved, next to set_transform queueing dirty instances and
+// _upload_transforms packing them. The instance layouts match InstanceData and TransformUpdate.
+struct Instance {
+    std::array<float, 12> transform;
+    uint32_t material;
+};
+struct Update {
+    std::array<float, 12> transform;
+    uint32_t instance;
+};
+
+static std::array<float, 12> affine_rows(const glm::mat4 &m) {
+    std::array<float, 12> rows;
+    for (auto r = 0u; r < 3u; ++r) {
+        for (auto c = 0u; c < 4u; ++c) { rows[r * 4u + c] = m[c][r]; }
+    }
+    return rows;
+}
+
+int main() {
+    constexpr auto count = 100'000u, moving = count / 100u, frames = 200u;
+    constexpr auto meshes = 50u, materials = 7u;
+
+    test::PassScene scene{meshes, materials};
+    std::mt19937 rng{1u};
+    MeshPass pass;
+    std::vector<Handle<RenderObject>> objects;
+    for (auto i = 0u; i < count; ++i) {
+        objects.push_back(scene.add(rng() % meshes, rng() % materials));
+        pass.unbatched.push_back(objects.back());
+    }
+    pass.refresh();
+
+    std::unordered_map<uint32_t, glm::vec4> bounds;
+    for (const auto m : scene.meshes) { bounds[m] = glm::vec4{0.f, 0.f, 0.f, 1.f}; }
+
+    std::unordered_map<uint32_t, uint32_t> instance_index;
+    std::vector<glm::mat4> instance_transforms(count);
+    culling::SphereSoA instance_bounds;
+    instance_bounds.resize(count);
+
+    // Instance data and bookkeeping for every instance, what render() does on a rebuild.
+    const auto rebuild = [&] {
+        instance_index.clear();
+        std::vector<Instance> data(pass.flat_batches.size());
+        for (auto i = 0u; i < pass.flat_batches.size(); ++i) {
+            const auto &po = pass.pass_objects.get_dense(pass.flat_batches[i].object);
+            const auto r   = scene.gpu->get_resource(po.render_object);
+            data[i]        = Instance{affine_rows(r->transform), pass.flat_batches[i].batch_id};
+            instance_index[r->id]  = i;
+            instance_transforms[i] = r->transform;
+            instance_bounds.set(i, culling::transform_sphere(r->transform, bounds.at(r->mesh)));
+        }
+        return data.size() * sizeof(Instance);
+    };
+    rebuild();
+
+    const auto sparse = [&](std::vector<uint32_t> &dirty) {
+        std::sort(dirty.begin(), dirty.end());
+        dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+        std::vector<Update> updates;
+        updates.reserve(dirty.size());
+        for (const auto i : dirty) {
+            const auto &po = pass.pass_objects.get_dense(pass.flat_batches[i].object);
+            const auto r   = scene.gpu->get_resource(po.render_object);
+            updates.push_back(Update{affine_rows(r->transform), i});
+            instance_transforms[i] = r->transform;
+            instance_bounds.set(i, culling::transform_sphere(r->transform, bounds.at(r->mesh)));
+        }
+        dirty.clear();
+        return updates.size() * sizeof(Update);
+    };
+
+    double full_ms{0.}, sparse_ms{0.};
+    size_t full_bytes{0u}, sparse_bytes{0u};
+    std::vector<uint32_t> dirty;
+    for (auto frame = 0u; frame < frames; ++frame) {
+        std::vector<std::pair<Handle<RenderObject>, glm::mat4>> moves;
+        for (auto k = 0u; k < moving; ++k) {
+            auto t = glm::mat4{1.f};
+            t[3]   = glm::vec4{(float)(rng() % 100u), 0.f, 0.f, 1.f};
+            moves.emplace_back(objects[rng() % count], t);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &[h, t] : moves) { scene.gpu->get_resource(h)->transform = t; }
+        full_bytes += rebuild();
+        full_ms += test::elapsed_ms(start);
+
+        start = std::chrono::steady_clock::now();
+        for (const auto &[h, t] : moves) {
+            scene.gpu->get_resource(h)->transform = t;
+            if (auto it = instance_index.find(h.id); it != instance_index.end()) {
+                dirty.push_back(it->second);
+            }
+        }
+        sparse_bytes += sparse(dirty);
+        sparse_ms += test::elapsed_ms(start);
+    }
+
+    std::printf("Moving %u of %u objects per frame, %u frames:\n", moving, count, frames);
+    std::printf("  full rebuild %7.3f ms per frame, %8.1f KB uploaded per frame\n",
+                full_ms / frames, full_bytes / 1e3 / frames);
+    std::printf("  sparse       %7.3f ms per frame, %8.1f KB uploaded per frame\n",
+                sparse_ms / frames, sparse_bytes / 1e3 / frames);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdio>
+
+// Checks for the CPU tests. A failed CHECK prints where and what failed and the test goes on,
+// main returns test::result() so ctest sees the failure.
+namespace test {
+    inline int failures{0};
+
+    inline int result() {
+        if (failures > 0) { std::printf("%d check(s) failed\n", failures); }
+        return failures > 0 ? 1 : 0;
+    }
+} // namespace test
+
+#define CHECK(expr)                                                                                \
+    do {                                                                                           \
+        if (!(expr)) {                                                                             \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr);                   \
+            test::failures++;                                                                      \
+        }                                                                                          \
+    } while (false)
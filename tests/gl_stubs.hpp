@@ -0,0 +1,17 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Without a context glad leaves every GL entry point null. Engine objects tests create only
+// release GL objects they never got, so deleting is all that needs to go somewhere.
+namespace test {
+    inline void APIENTRY delete_object(GLuint) {}
+    inline void APIENTRY delete_objects(GLsizei, const GLuint *) {}
+
+    inline void stub_gl() {
+        glad_glDeleteProgram  = delete_object;
+        glad_glDeleteShader   = delete_object;
+        glad_glDeleteTextures = delete_objects;
+        glad_glDeleteBuffers  = delete_objects;
+    }
+} // namespace test
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cassert>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+
+#include <engine/types/sorted_vec.hpp>
+#include <engine/types/idresource.hpp>
+
+namespace test {
+    // GpuResMgr as it was before typed resource pools: a std::type_index map of sorted vectors of
+    // pointers to separately allocated objects. Kept only so bench_resource_pool can time the
+    // two side by side.
+    class LegacyResMgr {
+      public:
+        ~LegacyResMgr() {
+            for (auto &[_, c] : _containers) {
+                for (auto &e : c) { delete e; }
+            }
+        }
+
+        template <typename Resource> Resource *create_resource(Resource &&rsc) {
+            return static_cast<Resource *>(
+                _get_storage<Resource>().insert(new Resource{std::move(rsc)}));
+        }
+
+        template <typename Resource> Resource *get_resource(eng::Handle<Resource> handle) {
+            auto &storage = _get_storage<Resource>();
+            auto p_data   = storage.try_find(handle, [](auto &&a, auto &&b) {
+                uint32_t _a, _b;
+
+                // clang-format off
+                if constexpr (std::is_pointer_v<std::remove_reference_t<decltype(a)>>) { _a = a->id; }
+                else { _a = a.id; }
+                if constexpr (std::is_pointer_v<std::remove_reference_t<decltype(b)>>) { _b = b->id; }
+                else { _b = b.id; }
+                // clang-format on
+
+                return _a < _b;
+            });
+
+            assert(p_data != nullptr && "Bad handle");
+
+            return static_cast<Resource *>(*p_data);
+        }
+
+      private:
+        struct _sort_func_t {
+            bool operator()(auto &&a, auto &&b) const { return a->id < b->id; }
+        };
+        using _storage_t   = eng::SortedVector<eng::IdWrapper *, _sort_func_t>;
+
+        template <typename Resource> _storage_t &_get_storage() {
+            auto ti = std::type_index{typeid(Resource)};
+
+            if (_containers.contains(ti) == false) { _containers[ti]; }
+
+            return _containers.at(ti);
+        }
+
+        std::unordered_map<std::type_index, _storage_t> _containers;
+    };
+} // namespace test
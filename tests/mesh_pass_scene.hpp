@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <engine/engine.hpp>
+#include <engine/renderer/renderer.hpp>
+
+#include "gl_stubs.hpp"
+
+namespace test {
+    // Meshes and materials for render objects to pick from, every material in the forward pass
+    // with the same program. The engine's resource manager lives as long as the scene.
+    struct PassScene {
+        PassScene(uint32_t mesh_count, uint32_t material_count) {
+            stub_gl();
+            auto &engine        = eng::Engine::instance();
+            engine._gpu_res_mgr = std::make_unique<eng::GpuResMgr>();
+            gpu                 = engine.get_gpu_res_mgr();
+
+            const auto program = gpu->create_resource(eng::ShaderProgram{});
+            for (auto i = 0u; i < material_count; ++i) {
+                auto m = gpu->create_resource(eng::Material{});
+                m->passes[eng::RenderPass::Forward] = program;
+                materials.push_back(m->res_handle());
+            }
+            for (auto i = 0u; i < mesh_count; ++i) {
+                meshes.push_back(gpu->create_resource(eng::Mesh{})->res_handle());
+            }
+        }
+        PassScene(const PassScene &) = delete;
+        PassScene &operator=(const PassScene &) = delete;
+        ~PassScene() { eng::Engine::instance()._gpu_res_mgr.reset(); }
+
+        eng::Handle<eng::RenderObject> add(uint32_t mesh, uint32_t material) {
+            return gpu
+                ->create_resource(eng::RenderObject{
+                    0u, meshes[mesh], materials[material], glm::mat4{1.f}})
+                ->res_handle();
+        }
+
+        eng::GpuResMgr *gpu{nullptr};
+        std::vector<eng::Handle<eng::Mesh>> meshes;
+        std::vector<eng::Handle<eng::Material>> materials;
+    };
+} // namespace test
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+
+#include <engine/gpu/resource_manager/gpu_res_mgr.hpp>
+#include <engine/gpu/shaderprogram/program_cache.hpp>
+#include <engine/types/thread_pool.hpp>
+
+namespace eng {
+    // Stands in for engine/engine.hpp in tests. Only the services CPU side code reaches through
+    // Engine::instance(), no window, camera or renderer. Tests create the ones they use.
+    class Engine {
+      public:
+        static Engine &instance() {
+            static Engine engine;
+            return engine;
+        }
+
+        GpuResMgr *get_gpu_res_mgr() { return _gpu_res_mgr.get(); }
+        ProgramCache *get_program_cache() { return _program_cache.get(); }
+        ThreadPool *get_thread_pool() { return _thread_pool.get(); }
+
+        std::unique_ptr<GpuResMgr> _gpu_res_mgr;
+        std::unique_ptr<ProgramCache> _program_cache;
+        std::unique_ptr<ThreadPool> _thread_pool;
+    };
+} // namespace eng
@@ -0,0 +1,153 @@
+#include <cstdint>
+#include <cfloat>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <engine/renderer/renderer.hpp>
+#include <engine/renderer/culling.hpp>
+
+#include "check.hpp"
+
+using namespace eng;
+
+static std::mt19937 rng{5u};
+
+static float uniform(float a, float b) { return std::uniform_real_distribution<float>{a, b}(rng); }
+static glm::vec3 uniform3(float a, float b) {
+    return glm::vec3{uniform(a, b), uniform(a, b), uniform(a, b)};
+}
+
+// A perspective or orthographic camera at a random place, looking in a random direction.
+static glm::mat4 random_pv() {
+    const auto eye    = uniform3(-20.f, 20.f);
+    const auto target = eye + uniform3(-1.f, 1.f) + glm::vec3{0.f, 0.f, 1e-3f};
+    const auto view   = glm::lookAt(eye, target, glm::vec3{0.f, 1.f, 0.f});
+    if (rng() % 4u == 0u) {
+        const auto e = uniform(5.f, 30.f);
+        return glm::ortho(-e, e, -e * .6f, e * .6f, .1f, uniform(20.f, 80.f)) * view;
+    }
+    return glm::perspective(uniform(.5f, 2.f), uniform(.5f, 2.f), .1f, uniform(20.f, 200.f))
+           * view;
+}
+
+// Spheres around the frustum. Every fourth one is placed against one of the planes: center right
+// on it, exactly one radius in front or behind it, or just inside or outside of that.
+static culling::SphereSoA random_spheres(const culling::Frustum &f, size_t n) {
+    culling::SphereSoA s;
+    s.resize(n);
+    for (auto i = 0u; i < n; ++i) {
+        auto center   = uniform3(-60.f, 60.f);
+        const float r = uniform(0.f, 4.f);
+        if (i % 4u == 0u) {
+            const auto &p    = f.planes[rng() % 6u];
+            const auto n3    = glm::vec3{p};
+            const float at[] = {0.f, r, -r, r * .999f, -r * .999f, -r * 1.001f};
+            center -= n3 * (glm::dot(n3, center) + p.w);
+            center += n3 * at[rng() % 6u];
+        }
+        s.set(i, glm::vec4{center, r});
+    }
+    return s;
+}
+
+// The SIMD paths must give exactly what the scalar path and Frustum::intersects give, sphere
+// counts not being multiples of the SIMD width included.
+static void simd_matches_scalar() {
+    for (auto round = 0u; round < 200u; ++round) {
+        const auto f       = culling::Frustum::from_matrix(random_pv());
+        const auto spheres = random_spheres(f, 1000u + rng() % 64u);
+
+        std::vector<uint32_t> reference;
+        for (auto i = 0u; i < spheres.size(); ++i) {
+            const glm::vec4 s{spheres.x[i], spheres.y[i], spheres.z[i], spheres.r[i]};
+            if (f.intersects(s)) { reference.push_back(i); }
+        }
+
+        std::vector<uint32_t> out(spheres.size());
+        const auto check_path = [&](auto path) {
+            out.resize(path(f, spheres, out.data()));
+            CHECK(out == reference);
+            out.resize(spheres.size());
+        };
+        check_path(culling::frustum_cull_scalar);
+        check_path(culling::frustum_cull_sse);
+        if (culling::has_avx()) { check_path(culling::frustum_cull_avx); }
+        check_path(culling::frustum_cull);
+    }
+}
+
+// cull_instances against planes taken straight from the matrix rows: visible instances are on
+// the inner side of every plane, culled ones fully outside one of them (both up to rounding).
+// Each visible instance shows up once, in the command of its batch and the LOD select_lod picks.
+static void cull_instances_matches_brute_force() {
+    constexpr auto batches = 5u, instances = 2000u;
+    const auto pv     = random_pv();
+    const auto camera = glm::vec3{glm::inverse(pv) * glm::vec4{0.f, 0.f, -1.f, 1.f}};
+
+    std::vector<glm::vec4> bounds, errors;
+    for (auto b = 0u; b < batches; ++b) {
+        bounds.push_back(glm::vec4{uniform3(-1.f, 1.f), uniform(.5f, 3.f)});
+        errors.push_back(glm::vec4{0.f, .01f, .05f, b % 2u ? .2f : FLT_MAX});
+    }
+    std::vector<glm::mat4> transforms;
+    std::vector<uint32_t> instance_batches;
+    for (auto i = 0u; i < instances; ++i) {
+        auto t = glm::translate(glm::mat4{1.f}, uniform3(-60.f, 60.f));
+        t      = glm::scale(t, glm::vec3{uniform(.2f, 2.f), uniform(.2f, 2.f), uniform(.2f, 2.f)});
+        transforms.push_back(t);
+        instance_batches.push_back(rng() % batches);
+    }
+
+    std::vector<DrawElementsIndirectCommand> commands(batches * MAX_LODS);
+    for (auto c = 0u; c < commands.size(); ++c) { commands[c].base_instance = c * instances; }
+    std::vector<uint32_t> visible(commands.size() * instances, UINT32_MAX);
+    culling::cull_instances(commands,
+                            transforms,
+                            instance_batches,
+                            bounds,
+                            errors,
+                            pv,
+                            camera,
+                            100.f,
+                            nullptr,
+                            visible);
+
+    std::vector<uint32_t> seen(instances, 0u);
+    for (auto c = 0u; c < commands.size(); ++c) {
+        for (auto k = 0u; k < commands[c].instance_count; ++k) {
+            const auto i      = visible[commands[c].base_instance + k];
+            const auto batch  = instance_batches[i];
+            const auto sphere = culling::transform_sphere(transforms[i], bounds[batch]);
+            CHECK(c == batch * MAX_LODS
+                           + culling::select_lod(sphere, bounds[batch].w, camera, errors[batch],
+                                                 100.f));
+            seen[i]++;
+        }
+    }
+
+    const auto rows = glm::transpose(pv);
+    const glm::vec4 planes[] = {rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+                                rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2]};
+    for (auto i = 0u; i < instances; ++i) {
+        const auto sphere = culling::transform_sphere(transforms[i], bounds[instance_batches[i]]);
+        auto nearest      = FLT_MAX;
+        for (const auto &p : planes) {
+            const auto d = (glm::dot(glm::vec3{p}, glm::vec3{sphere}) + p.w)
+                           / glm::length(glm::vec3{p});
+            nearest      = std::min(nearest, d + sphere.w);
+        }
+        CHECK(seen[i] <= 1u);
+        if (seen[i] == 1u) { CHECK(nearest >= -1e-3f); }
+        if (seen[i] == 0u) { CHECK(nearest <= 1e-3f); }
+    }
+}
+
+int main() {
+    simd_matches_scalar();
+    for (auto round = 0u; round < 20u; ++round) { cull_instances_matches_brute_force(); }
+    return test::result();
+}
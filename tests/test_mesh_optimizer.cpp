@@ -0,0 +1,78 @@
+#include <cstdint>
+#include <array>
+#include <tuple>
+#include <vector>
+#include <algorithm>
+
+#include <engine/scene/mesh_optimizer.hpp>
+
+#include "check.hpp"
+#include "test_meshes.hpp"
+
+using namespace eng;
+
+// Triangles by the positions of their corners, rotated so the smallest corner comes first:
+// the same multiset before and after means the same surface with the same winding, however
+// triangles and vertices were reordered.
+using Corner   = std::tuple<float, float, float, float, float>;
+using Triangle = std::array<Corner, 3>;
+
+static std::vector<Triangle> triangles(const test::MeshData &m) {
+    constexpr auto fv = vertex_format::FLOATS_PER_VERTEX;
+    std::vector<Triangle> out;
+    for (auto t = 0u; t < m.indices.size(); t += 3u) {
+        Triangle tri;
+        for (auto k = 0u; k < 3u; ++k) {
+            const auto v = &m.vertices[(size_t)m.indices[t + k] * fv];
+            tri[k]       = Corner{v[0], v[1], v[2], v[3], v[4]};
+        }
+        std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()), tri.end());
+        out.push_back(tri);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// Both an exporter-like row order and a shuffled order end up near the 0.5 - 0.7 ACMR Tipsify
+// gets on regular grids, without changing the surface, and vertices end up in first use order.
+static void optimizes_grid(bool shuffled) {
+    auto mesh = test::sphere_grid(64u, 64u);
+    if (shuffled) { test::shuffle_triangles(mesh, 3u); }
+    const auto before = triangles(mesh);
+
+    const auto report = mesh_optimizer::optimize(
+        mesh.indices, mesh.vertices, vertex_format::FLOATS_PER_VERTEX);
+
+    CHECK(report.before.triangles == mesh.indices.size() / 3u);
+    CHECK(report.after.acmr() < report.before.acmr());
+    CHECK(report.after.acmr() < .7f);
+    CHECK(report.after.atvr() < 1.4f);
+    if (shuffled) { CHECK(report.before.acmr() > 2.5f); }
+
+    const auto after = mesh_optimizer::analyze_vertex_cache(mesh.indices, mesh.vertex_count());
+    CHECK(after.misses == report.after.misses);
+    CHECK(triangles(mesh) == before);
+
+    uint32_t next{0u};
+    for (const auto i : mesh.indices) {
+        CHECK(i <= next);
+        if (i == next) { next++; }
+    }
+}
+
+// A cache of 16 only misses first uses of a quad's vertices, a cache of one vertex hits only
+// when the same vertex comes twice in a row.
+static void analyze_counts_fifo_misses() {
+    const std::vector<uint32_t> quad{0u, 1u, 2u, 2u, 1u, 3u};
+    const auto full = mesh_optimizer::analyze_vertex_cache(quad, 4u);
+    CHECK(full.misses == 4u && full.triangles == 2u && full.vertices == 4u);
+    const auto tiny = mesh_optimizer::analyze_vertex_cache(quad, 4u, 1u);
+    CHECK(tiny.misses == 5u);
+}
+
+int main() {
+    optimizes_grid(false);
+    optimizes_grid(true);
+    analyze_counts_fifo_misses();
+    return test::result();
+}
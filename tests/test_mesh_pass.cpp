@@ -0,0 +1,134 @@
+#include <cstdint>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "mesh_pass_scene.hpp"
+
+using namespace eng;
+
+// Flat batches sorted by batch id and each pointing at a pass object of its batch, indirect
+// batches covering them back to back, and exactly the render objects in live batched.
+static void check_consistent(const MeshPass &pass, std::vector<Handle<RenderObject>> live) {
+    std::vector<Handle<RenderObject>> batched;
+    for (auto i = 0u; i < pass.flat_batches.size(); ++i) {
+        const auto &fb = pass.flat_batches[i];
+        const auto &po = pass.pass_objects.get_dense(fb.object);
+        CHECK(po.batch_id == fb.batch_id);
+        CHECK(i == 0u || pass.flat_batches[i - 1u].batch_id <= fb.batch_id);
+        batched.push_back(po.render_object);
+    }
+    std::sort(batched.begin(), batched.end());
+    std::sort(live.begin(), live.end());
+    CHECK(batched == live);
+
+    uint32_t first{0u};
+    for (const auto &ib : pass.indirect_batches) {
+        CHECK(ib.first == first && ib.count > 0u);
+        for (auto i = ib.first; i < ib.first + ib.count && i < pass.flat_batches.size(); ++i) {
+            CHECK(pass.flat_batches[i].batch_id == ib.batch_id);
+            CHECK(pass.pass_objects.get_dense(pass.flat_batches[i].object).mesh == ib.mesh);
+        }
+        first += ib.count;
+    }
+    CHECK(first == pass.flat_batches.size());
+}
+
+static bool same_batches(const MeshPass &a, const MeshPass &b) {
+    if (a.indirect_batches.size() != b.indirect_batches.size()
+        || a.flat_batches.size() != b.flat_batches.size()) {
+        return false;
+    }
+    for (auto i = 0u; i < a.indirect_batches.size(); ++i) {
+        const auto &x = a.indirect_batches[i], &y = b.indirect_batches[i];
+        if (x.batch_id != y.batch_id || x.first != y.first || x.count != y.count
+            || x.mesh != y.mesh) {
+            return false;
+        }
+    }
+    for (auto i = 0u; i < a.flat_batches.size(); ++i) {
+        if (a.flat_batches[i].batch_id != b.flat_batches[i].batch_id) { return false; }
+    }
+    return true;
+}
+
+// Objects stream in with removals in between, incremental refreshes have to end up with the
+// batches a full rebuild makes.
+static void incremental_matches_full() {
+    test::PassScene scene{40u, 6u};
+    MeshPass incremental, full;
+    full.batching_mode = BatchingMode::Full;
+
+    std::mt19937 rng{1u};
+    std::vector<Handle<RenderObject>> live;
+    for (auto frame = 0u; frame < 300u; ++frame) {
+        for (auto i = rng() % 20u; i > 0u; --i) {
+            const auto ro = scene.add(rng() % 40u, rng() % 6u);
+            incremental.unbatched.push_back(ro);
+            full.unbatched.push_back(ro);
+            live.push_back(ro);
+        }
+        // Every few frames a burst of removals, emptying some batches entirely.
+        for (auto i = frame % 7u == 0u ? rng() % 40u : rng() % 4u; i > 0u && !live.empty(); --i) {
+            const auto k = rng() % live.size();
+            incremental.remove(live[k]);
+            full.remove(live[k]);
+            live.erase(live.begin() + k);
+        }
+
+        incremental.refresh();
+        full.refresh();
+        CHECK(same_batches(incremental, full));
+        check_consistent(incremental, live);
+    }
+
+    // Down to nothing and back.
+    for (const auto ro : live) { incremental.remove(ro); }
+    incremental.refresh();
+    CHECK(incremental.flat_batches.empty() && incremental.indirect_batches.empty());
+    const auto ro = scene.add(0u, 0u);
+    incremental.unbatched.push_back(ro);
+    incremental.refresh();
+    check_consistent(incremental, {ro});
+}
+
+// Batch id of the first pass object of ro's batch.
+static uint32_t batch_of(const MeshPass &pass, Handle<RenderObject> ro) {
+    for (auto i = 0u; i < pass.pass_objects.size(); ++i) {
+        const auto &po = pass.pass_objects.get_dense(i);
+        if (po.render_object == ro) { return po.batch_id; }
+    }
+    return UINT32_MAX;
+}
+
+// Ids belong to a mesh/material pair for good: emptying a batch leaves the others' ids alone,
+// and the pair gets its old id back when it returns.
+static void batch_ids_are_stable() {
+    test::PassScene scene{4u, 2u};
+    MeshPass pass;
+
+    const auto a = scene.add(0u, 0u), b = scene.add(1u, 0u), c = scene.add(1u, 1u);
+    pass.unbatched = {a, b, c};
+    pass.refresh();
+    const auto id_a = batch_of(pass, a), id_b = batch_of(pass, b), id_c = batch_of(pass, c);
+    CHECK(id_a != id_b && id_b != id_c && id_a != id_c);
+
+    pass.remove(b);
+    pass.refresh();
+    CHECK(batch_of(pass, a) == id_a && batch_of(pass, c) == id_c);
+    CHECK(pass.indirect_batches.size() == 2u);
+
+    const auto b2 = scene.add(1u, 0u), d = scene.add(3u, 1u);
+    pass.unbatched = {d, b2};
+    pass.refresh();
+    CHECK(batch_of(pass, b2) == id_b);
+    CHECK(batch_of(pass, d) != id_a && batch_of(pass, d) != id_b && batch_of(pass, d) != id_c);
+    check_consistent(pass, {a, c, b2, d});
+}
+
+int main() {
+    incremental_matches_full();
+    batch_ids_are_stable();
+    return test::result();
+}
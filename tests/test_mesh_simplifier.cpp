@@ -0,0 +1,107 @@
+#include <cstdint>
+#include <cfloat>
+#include <span>
+#include <algorithm>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <engine/scene/mesh_simplifier.hpp>
+
+#include "check.hpp"
+#include "test_meshes.hpp"
+
+using namespace eng;
+
+// Distance from p to triangle abc (Ericson, Real-Time Collision Detection 5.1.5).
+static float point_triangle_distance(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+    const auto ab = b - a, ac = c - a, ap = p - a;
+    const auto d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.f && d2 <= 0.f) { return glm::length(p - a); }
+
+    const auto bp = p - b;
+    const auto d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.f && d4 <= d3) { return glm::length(p - b); }
+
+    const auto vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) {
+        return glm::length(p - (a + ab * (d1 / (d1 - d3))));
+    }
+
+    const auto cp = p - c;
+    const auto d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.f && d5 <= d6) { return glm::length(p - c); }
+
+    const auto vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) {
+        return glm::length(p - (a + ac * (d2 / (d2 - d6))));
+    }
+
+    const auto va = d3 * d6 - d5 * d4;
+    if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f) {
+        return glm::length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+    }
+
+    const auto denom = 1.f / (va + vb + vc);
+    return glm::length(p - (a + ab * (vb * denom) + ac * (vc * denom)));
+}
+
+// Builds the LODs of mesh, appending their indices. Every level has fewer triangles than the one
+// before and only indexes the mesh's vertices. No vertex of the full mesh is farther from
+// a level's surface than the error the level reports.
+static std::vector<MeshLod> check_lods(test::MeshData &mesh) {
+    constexpr auto fv = vertex_format::FLOATS_PER_VERTEX;
+    const auto full   = mesh.indices;
+    const auto lods   = mesh_simplifier::build_lods(mesh.indices, mesh.vertices, fv);
+
+    CHECK(lods.size() >= 3u && lods.size() <= MAX_LODS);
+    CHECK(lods[0].first_index == 0u && lods[0].index_count == full.size() && lods[0].error == 0.f);
+    for (auto k = 1u; k < lods.size(); ++k) {
+        CHECK(lods[k].index_count < lods[k - 1u].index_count);
+        CHECK(lods[k].error >= lods[k - 1u].error);
+        CHECK(lods[k].first_index + lods[k].index_count <= mesh.indices.size());
+
+        const auto level
+            = std::span{mesh.indices}.subspan(lods[k].first_index, lods[k].index_count);
+        auto worst = 0.f;
+        for (const auto i : level) { CHECK(i < mesh.vertex_count()); }
+        for (auto v = 0u; v < mesh.vertex_count(); ++v) {
+            auto nearest = FLT_MAX;
+            for (auto t = 0u; t < level.size(); t += 3u) {
+                nearest = std::min(nearest,
+                                   point_triangle_distance(mesh.position(v),
+                                                           mesh.position(level[t]),
+                                                           mesh.position(level[t + 1u]),
+                                                           mesh.position(level[t + 2u])));
+            }
+            worst = std::max(worst, nearest);
+        }
+        CHECK(worst <= lods[k].error + 1e-5f);
+    }
+    return lods;
+}
+
+// Border vertices are locked, every level still has all of them.
+static void keeps_borders() {
+    constexpr auto n = 48u;
+    auto mesh        = test::terrain(n);
+    const auto lods  = check_lods(mesh);
+
+    for (const auto &lod : lods) {
+        std::vector<bool> used(mesh.vertex_count(), false);
+        for (auto i = lod.first_index; i < lod.first_index + lod.index_count; ++i) {
+            used[mesh.indices[i]] = true;
+        }
+        for (auto k = 0u; k <= n; ++k) {
+            CHECK(used[k] && used[n * (n + 1u) + k]);
+            CHECK(used[k * (n + 1u)] && used[k * (n + 1u) + n]);
+        }
+    }
+}
+
+int main() {
+    auto sphere = test::bumpy_sphere(24u, 48u);
+    check_lods(sphere);
+    keeps_borders();
+    return test::result();
+}
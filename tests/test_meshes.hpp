@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <numbers>
+
+#include <glm/glm.hpp>
+
+#include <engine/renderer/vertex_format.hpp>
+
+namespace test {
+    // Triangle list in the importer's float layout, see vertex_format::FLOATS_PER_VERTEX.
+    struct MeshData {
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+
+        uint32_t vertex_count() const {
+            return (uint32_t)(vertices.size() / eng::vertex_format::FLOATS_PER_VERTEX);
+        }
+        glm::vec3 position(uint32_t v) const {
+            const auto p = &vertices[(size_t)v * eng::vertex_format::FLOATS_PER_VERTEX];
+            return glm::vec3{p[0], p[1], p[2]};
+        }
+        void add_vertex(glm::vec3 p, glm::vec2 uv = glm::vec2{0.f}) {
+            const float v[]{p.x, p.y, p.z, uv.x, uv.y, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+            for (const auto f : v) { vertices.push_back(f); }
+        }
+    };
+
+    // Unit sphere as a rows x cols grid of quads in row order, like exporters write them. The
+    // seam column and the pole rows have their own vertices, as they would with uvs.
+    inline MeshData sphere_grid(uint32_t rows, uint32_t cols) {
+        constexpr auto pi = std::numbers::pi_v<float>;
+        MeshData m;
+        for (auto i = 0u; i <= rows; ++i) {
+            for (auto j = 0u; j <= cols; ++j) {
+                const auto th = pi * (float)i / (float)rows, ph = 2.f * pi * (float)j / (float)cols;
+                m.add_vertex(glm::vec3{std::sin(th) * std::cos(ph),
+                                       std::cos(th),
+                                       std::sin(th) * std::sin(ph)},
+                             glm::vec2{(float)j / (float)cols, (float)i / (float)rows});
+            }
+        }
+        for (auto i = 0u; i < rows; ++i) {
+            for (auto j = 0u; j < cols; ++j) {
+                const auto a = i * (cols + 1u) + j, b = a + 1u, c = a + cols + 1u, d = c + 1u;
+                m.indices.insert(m.indices.end(), {a, c, b, b, c, d});
+            }
+        }
+        return m;
+    }
+
+    // Closed, welded sphere with bumps on it (a pole vertex at each end, rings of cols vertices
+    // in between), so it has no borders and the simplifier can collapse anywhere.
+    inline MeshData bumpy_sphere(uint32_t rows, uint32_t cols) {
+        constexpr auto pi = std::numbers::pi_v<float>;
+        MeshData m;
+        m.add_vertex(glm::vec3{0.f, 1.f, 0.f});
+        for (auto i = 1u; i < rows; ++i) {
+            for (auto j = 0u; j < cols; ++j) {
+                const auto th = pi * (float)i / (float)rows, ph = 2.f * pi * (float)j / (float)cols;
+                const auto r  = 1.f + .05f * std::sin(5.f * ph) * std::sin(4.f * th);
+                m.add_vertex(r * glm::vec3{std::sin(th) * std::cos(ph),
+                                           std::cos(th),
+                                           std::sin(th) * std::sin(ph)});
+            }
+        }
+        m.add_vertex(glm::vec3{0.f, -1.f, 0.f});
+
+        const auto south = m.vertex_count() - 1u;
+
+        // Vertex j of ring i, rings start at 1.
+        const auto at = [cols](uint32_t i, uint32_t j) { return 1u + (i - 1u) * cols + j % cols; };
+        for (auto j = 0u; j < cols; ++j) {
+            m.indices.insert(m.indices.end(), {0u, at(1u, j + 1u), at(1u, j)});
+            m.indices.insert(m.indices.end(), {south, at(rows - 1u, j), at(rows - 1u, j + 1u)});
+        }
+        for (auto i = 1u; i + 1u < rows; ++i) {
+            for (auto j = 0u; j < cols; ++j) {
+                const auto a = at(i, j), b = at(i, j + 1u);
+                const auto c = at(i + 1u, j), d = at(i + 1u, j + 1u);
+                m.indices.insert(m.indices.end(), {a, b, c, b, d, c});
+            }
+        }
+        return m;
+    }
+
+    // Height field over the unit square, n x n quads. Its outer edge is a border.
+    inline MeshData terrain(uint32_t n) {
+        MeshData m;
+        for (auto i = 0u; i <= n; ++i) {
+            for (auto j = 0u; j <= n; ++j) {
+                const auto h = .1f * std::sin((float)i * .2f) * std::cos((float)j * .15f);
+                m.add_vertex(glm::vec3{(float)i / (float)n, h, (float)j / (float)n});
+            }
+        }
+        for (auto i = 0u; i < n; ++i) {
+            for (auto j = 0u; j < n; ++j) {
+                const auto a = i * (n + 1u) + j, b = a + 1u, c = a + n + 1u, d = c + 1u;
+                m.indices.insert(m.indices.end(), {a, b, c, b, d, c});
+            }
+        }
+        return m;
+    }
+
+    // Same triangles in random order, what a mesh without any care for the vertex cache has.
+    inline void shuffle_triangles(MeshData &m, uint32_t seed) {
+        std::vector<uint32_t> order(m.indices.size() / 3u);
+        for (auto t = 0u; t < order.size(); ++t) { order[t] = t; }
+        std::shuffle(order.begin(), order.end(), std::mt19937{seed});
+
+        std::vector<uint32_t> shuffled;
+        shuffled.reserve(m.indices.size());
+        for (const auto t : order) {
+            shuffled.insert(shuffled.end(), &m.indices[t * 3u], &m.indices[t * 3u + 3u]);
+        }
+        m.indices = std::move(shuffled);
+    }
+} // namespace test
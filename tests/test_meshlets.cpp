@@ -0,0 +1,131 @@
+#include <cstdint>
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <engine/renderer/culling.hpp>
+#include <engine/scene/mesh_optimizer.hpp>
+#include <engine/scene/meshlet_builder.hpp>
+
+#include "check.hpp"
+#include "test_meshes.hpp"
+
+using namespace eng;
+
+static constexpr auto fv = vertex_format::FLOATS_PER_VERTEX;
+
+// Triangle t of mesh, as seen from camera, after transform.
+static bool front_facing(const test::MeshData &mesh,
+                         uint32_t t,
+                         const glm::mat4 &transform,
+                         glm::vec3 camera) {
+    const auto p = [&](uint32_t k) {
+        return glm::vec3{transform * glm::vec4{mesh.position(mesh.indices[t + k]), 1.f}};
+    };
+    const auto a = p(0u), b = p(1u), c = p(2u);
+    return glm::dot(glm::cross(b - a, c - a), a - camera) < 0.f;
+}
+
+// Meshlets cover the index list in order without gaps, stay within the vertex and triangle
+// limits and their spheres hold all their vertices.
+static void builder_limits(const test::MeshData &mesh, const std::vector<Meshlet> &meshlets) {
+    uint32_t covered{0u};
+    for (const auto &m : meshlets) {
+        CHECK(m.first_index == covered && m.index_count % 3u == 0u && m.index_count > 0u);
+        covered += m.index_count;
+
+        const std::set<uint32_t> unique{mesh.indices.begin() + m.first_index,
+                                        mesh.indices.begin() + m.first_index + m.index_count};
+        CHECK(unique.size() <= MESHLET_MAX_VERTICES);
+        CHECK(m.index_count / 3u <= MESHLET_MAX_TRIANGLES);
+        for (const auto v : unique) {
+            CHECK(glm::distance(mesh.position(v), glm::vec3{m.sphere}) <= m.sphere.w * 1.0001f);
+        }
+    }
+    CHECK(covered == mesh.indices.size());
+}
+
+// The same triangle over and over only ever has 3 vertices, so meshlets end on the triangle
+// limit instead.
+static void triangle_limit() {
+    test::MeshData mesh;
+    mesh.add_vertex(glm::vec3{0.f});
+    mesh.add_vertex(glm::vec3{1.f, 0.f, 0.f});
+    mesh.add_vertex(glm::vec3{0.f, 1.f, 0.f});
+    for (auto t = 0u; t < 300u; ++t) { mesh.indices.insert(mesh.indices.end(), {0u, 1u, 2u}); }
+
+    const auto meshlets = meshlet_builder::build(mesh.indices, mesh.vertices, fv);
+    CHECK(meshlets.size() == 3u);
+    CHECK(meshlets[0].index_count == MESHLET_MAX_TRIANGLES * 3u);
+    builder_limits(mesh, meshlets);
+}
+
+// A cone culled meshlet has no triangle facing the camera, for cameras all around the mesh.
+// cull_meshlets, with a non-uniformly scaled instance, only drops meshlets that are outside
+// the frustum or have no front facing triangle, and keeps the order of the ones it returns.
+static void cone_and_cluster_culling(const test::MeshData &mesh,
+                                     const std::vector<Meshlet> &meshlets) {
+    std::mt19937 rng{3u};
+    std::uniform_real_distribution<float> u{-6.f, 6.f};
+    const auto identity = glm::mat4{1.f};
+    uint32_t culled{0u};
+    for (auto round = 0u; round < 100u; ++round) {
+        const glm::vec3 camera{u(rng), u(rng), u(rng)};
+        if (glm::length(camera) < 1.2f) { continue; }
+        for (const auto &m : meshlets) {
+            if (culling::cone_culled(m, camera) == false) { continue; }
+            culled++;
+            for (auto t = m.first_index; t < m.first_index + m.index_count; t += 3u) {
+                CHECK(front_facing(mesh, t, identity, camera) == false);
+            }
+        }
+    }
+    CHECK(culled > 0u);
+
+    const auto center    = glm::vec3{2.f, 0.f, -1.f};
+    const auto transform = glm::scale(glm::translate(glm::mat4{1.f}, center), {2.f, 1.f, 1.5f});
+    std::vector<uint32_t> out(meshlets.size());
+    for (auto k = 0u; k < 8u; ++k) {
+        // Narrow lens looking a bit off center, so some meshlets fall outside the frustum.
+        const auto a       = (float)k * .785f;
+        const auto camera  = center + 5.f * glm::vec3{std::cos(a), .3f, std::sin(a)};
+        const auto target  = center + glm::vec3{0.f, 0.f, .5f};
+        const auto view    = glm::lookAt(camera, target, glm::vec3{0.f, 1.f, 0.f});
+        const auto pv      = glm::perspective(glm::radians(30.f), 16.f / 9.f, .1f, 100.f) * view;
+        const auto frustum = culling::Frustum::from_matrix(pv);
+
+        const auto count
+            = culling::cull_meshlets(meshlets, transform, &frustum, camera, out.data());
+        CHECK(count > 0u && count < meshlets.size());
+        std::vector<bool> kept(meshlets.size(), false);
+        for (auto i = 0u; i < count; ++i) {
+            CHECK(i == 0u || out[i] > out[i - 1u]);
+            kept[out[i]] = true;
+        }
+        for (auto i = 0u; i < meshlets.size(); ++i) {
+            if (kept[i]) { continue; }
+            const auto &m = meshlets[i];
+            if (frustum.intersects(culling::transform_sphere(transform, m.sphere)) == false) {
+                continue;
+            }
+            for (auto t = m.first_index; t < m.first_index + m.index_count; t += 3u) {
+                CHECK(front_facing(mesh, t, transform, camera) == false);
+            }
+        }
+    }
+}
+
+int main() {
+    auto mesh = test::bumpy_sphere(48u, 96u);
+    mesh_optimizer::optimize(mesh.indices, mesh.vertices, fv);
+    const auto meshlets = meshlet_builder::build(mesh.indices, mesh.vertices, fv);
+
+    builder_limits(mesh, meshlets);
+    triangle_limit();
+    cone_and_cluster_culling(mesh, meshlets);
+    return test::result();
+}
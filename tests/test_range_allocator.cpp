@@ -0,0 +1,60 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <engine/types/range_allocator.hpp>
+
+#include "check.hpp"
+
+using namespace eng;
+
+// Random allocations and frees of random sizes, with an owner per element of the storage:
+// ranges never overlap, stay below end(), freed space gets reused and freeing everything
+// shrinks the storage back to nothing.
+static void churn() {
+    RangeAllocator alloc;
+    std::vector<RangeAllocator::Range> live;
+    std::vector<uint32_t> owner;
+    std::mt19937 rng{11u};
+    uint32_t peak = 0u;
+
+    const auto check_ranges = [&] {
+        std::fill(owner.begin(), owner.end(), 0u);
+        for (auto i = 0u; i < live.size(); ++i) {
+            CHECK(live[i].offset + live[i].size <= alloc.end());
+            if (owner.size() < alloc.end()) { owner.resize(alloc.end(), 0u); }
+            for (auto e = live[i].offset; e < live[i].offset + live[i].size; ++e) {
+                CHECK(owner[e] == 0u);
+                owner[e] = i + 1u;
+            }
+        }
+    };
+
+    for (auto step = 1u; step <= 5'000u; ++step) {
+        if (live.empty() || rng() % 2u == 0u) {
+            live.push_back(alloc.allocate(1u + rng() % 64u));
+        } else {
+            const auto k = rng() % live.size();
+            alloc.free(live[k]);
+            live[k] = live.back();
+            live.pop_back();
+        }
+        peak = std::max(peak, alloc.end());
+        if (step % 100u == 0u) { check_ranges(); }
+    }
+
+    // Frees are about as frequent as allocations, so at most a few hundred ranges are live at once.
+    // Without reuse the storage would grow to the sum of every allocation (~2500 * 32 elements).
+    CHECK(peak < 8'000u);
+
+    for (const auto r : live) { alloc.free(r); }
+    CHECK(alloc.end() == 0u);
+    CHECK(alloc.allocate(8u).offset == 0u);
+    CHECK(alloc.allocate(0u).size == 0u);
+}
+
+int main() {
+    churn();
+    return test::result();
+}
@@ -0,0 +1,88 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <engine/gpu/resource_manager/gpu_res_mgr.hpp>
+
+#include "check.hpp"
+
+using namespace eng;
+
+struct Counted : public IdResource<Counted> {
+    Counted() = default;
+    explicit Counted(uint32_t value) : value{value} {}
+    Counted(Counted &&o) noexcept : value{o.value} { o.value = 0u; }
+    ~Counted() override {
+        if (value != 0u) { destroyed++; }
+    }
+
+    uint32_t value{0u};
+    static inline uint32_t destroyed{0u};
+};
+
+// Released handles stop resolving right away, the object itself goes deletion_delay frames later
+// and its slot comes back with a new generation.
+static void stale_handles() {
+    GpuResMgr gpu;
+    gpu.set_deletion_delay(2u);
+    Counted::destroyed = 0u;
+
+    const auto a = gpu.create_resource(Counted{1u})->res_handle();
+    const auto b = gpu.create_resource(Counted{2u})->res_handle();
+    CHECK(gpu.contains(a) && gpu.try_get_resource(a) == gpu.get_resource(a));
+
+    gpu.destroy_resource(a);
+    CHECK(gpu.contains(a) == false && gpu.try_get_resource(a) == nullptr);
+    CHECK(gpu.get_resource(b)->value == 2u && gpu.count<Counted>() == 1u);
+
+    gpu.next_frame();
+    CHECK(Counted::destroyed == 0u);
+    gpu.next_frame();
+    CHECK(Counted::destroyed == 1u);
+
+    const auto c = gpu.create_resource(Counted{3u})->res_handle();
+    CHECK((c.id & ResourcePool<Counted>::INDEX_MASK) == (a.id & ResourcePool<Counted>::INDEX_MASK));
+    CHECK(c != a && gpu.try_get_resource(a) == nullptr && gpu.get_resource(c)->value == 3u);
+}
+
+// Random inserts and releases against a plain list of live handles: every live handle resolves
+// to its own object, alive() holds exactly the live objects and stale handles resolve to nothing.
+static void churn() {
+    ResourcePool<Counted> pool;
+    std::vector<std::pair<Handle<Counted>, uint32_t>> live;
+    std::vector<Handle<Counted>> dead;
+    std::mt19937 rng{7u};
+
+    for (auto step = 1u; step <= 20'000u; ++step) {
+        if (live.empty() || rng() % 5u < 3u) {
+            live.emplace_back(pool.insert(Counted{step})->res_handle(), step);
+        } else {
+            const auto k = rng() % live.size();
+            pool.destroy(pool.release(live[k].first));
+            dead.push_back(live[k].first);
+            live[k] = live.back();
+            live.pop_back();
+        }
+
+        if (step % 500u != 0u) { continue; }
+        CHECK(pool.size() == live.size());
+        for (const auto &[h, value] : live) {
+            CHECK(pool.contains(h) && pool.get(h)->value == value && pool.get(h)->id == h.id);
+        }
+        for (const auto h : dead) { CHECK(pool.try_get(h) == nullptr); }
+
+        std::vector<uint32_t> alive_values, live_values;
+        for (const auto r : pool.alive()) { alive_values.push_back(r->value); }
+        for (const auto &[_, value] : live) { live_values.push_back(value); }
+        std::sort(alive_values.begin(), alive_values.end());
+        std::sort(live_values.begin(), live_values.end());
+        CHECK(alive_values == live_values);
+    }
+}
+
+int main() {
+    stale_handles();
+    churn();
+    return test::result();
+}
@@ -0,0 +1,57 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <engine/types/slot_map.hpp>
+
+#include "check.hpp"
+
+using namespace eng;
+
+// Random inserts and erases against a plain list of live handles. Every live handle resolves to
+// its own value, dense storage holds exactly the live values, dense_index/handle_at agree, and
+// erased handles never resolve again, even once their slot is reused.
+static void churn() {
+    SlotMap<uint32_t> map;
+    std::vector<std::pair<Handle<uint32_t>, uint32_t>> live;
+    std::vector<Handle<uint32_t>> erased;
+    std::mt19937 rng{3u};
+
+    for (auto step = 1u; step <= 20'000u; ++step) {
+        if (live.empty() || rng() % 5u < 3u) {
+            live.emplace_back(map.insert(step), step);
+        } else {
+            const auto k     = rng() % live.size();
+            const auto moved = map.handle_at((uint32_t)map.size() - 1u);
+            const auto at    = map.erase(live[k].first);
+            if (moved != live[k].first) { CHECK(map.dense_index(moved) == at); }
+            erased.push_back(live[k].first);
+            live[k] = live.back();
+            live.pop_back();
+        }
+
+        if (step % 500u != 0u) { continue; }
+        CHECK(map.size() == live.size());
+        for (const auto &[h, value] : live) {
+            CHECK(map.contains(h) && map.get(h) == value);
+            CHECK(map.handle_at(map.dense_index(h)) == h);
+        }
+        for (const auto h : erased) { CHECK(map.try_get(h) == nullptr); }
+
+        std::vector<uint32_t> dense{map.begin(), map.end()}, values;
+        for (const auto &[_, value] : live) { values.push_back(value); }
+        std::sort(dense.begin(), dense.end());
+        std::sort(values.begin(), values.end());
+        CHECK(dense == values);
+    }
+
+    map.clear();
+    CHECK(map.empty());
+    for (const auto &[h, _] : live) { CHECK(map.contains(h) == false); }
+}
+
+int main() {
+    churn();
+    return test::result();
+}
@@ -0,0 +1,59 @@
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <engine/gpu/texture/texture_baker.hpp>
+
+#include "check.hpp"
+
+using namespace eng;
+using block_compression::BlockFormat;
+
+// A packed metallic/roughness image: constant metallic in red, a roughness ramp in green.
+static constexpr uint32_t size{16u};
+static constexpr uint8_t metallic{40u};
+
+static std::vector<uint8_t> packed_image() {
+    std::vector<uint8_t> rgba((size_t)size * size * 4u);
+    for (auto y = 0u; y < size; ++y) {
+        for (auto x = 0u; x < size; ++x) {
+            const auto i = ((size_t)y * size + x) * 4u;
+            rgba[i + 0u] = metallic;
+            rgba[i + 1u] = (uint8_t)(x * 16u + 8u);
+            rgba[i + 2u] = 255u;
+            rgba[i + 3u] = 255u;
+        }
+    }
+    return rgba;
+}
+
+// Baked with the default settings of its slot, BC4 holds the channel the renderer reads from the
+// source image: red for metallic, green for roughness.
+static void default_channels() {
+    const auto source = packed_image();
+    for (const auto type : {TextureType::Metallic, TextureType::Roughness}) {
+        const auto settings = texture_baker::settings_for(type);
+        CHECK(settings.format == BlockFormat::BC4);
+
+        const auto image   = texture_baker::bake(source.data(), size, size, settings);
+        const auto decoded = block_compression::decode(
+            BlockFormat::BC4, image.data.data(), image.width, image.height);
+        const auto channel = type == TextureType::Roughness ? 1u : 0u;
+        for (size_t i = 0u; i < decoded.size(); i += 4u) {
+            CHECK(std::abs((int)decoded[i] - (int)source[i + channel]) <= 2);
+        }
+    }
+}
+
+// Slots sharing one source image bake to files of their own.
+static void baked_paths() {
+    const auto metallic_path  = texture_baker::baked_path("a/mr.png", TextureType::Metallic);
+    const auto roughness_path = texture_baker::baked_path("a/mr.png", TextureType::Roughness);
+    CHECK(metallic_path == "a/mr.metallic.dds" && roughness_path == "a/mr.roughness.dds");
+}
+
+int main() {
+    default_channels();
+    baked_paths();
+    return test::result();
+}
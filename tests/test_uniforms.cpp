@@ -0,0 +1,218 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+#include <engine/engine.hpp>
+#include <engine/gpu/shaderprogram/shader.hpp>
+
+#include "check.hpp"
+#include "gl_stubs.hpp"
+
+using namespace eng;
+
+// Fake driver. Every program links with the uniforms below, at their location plus
+// location_offset as it was when the program linked. "blk.m" is a member of a uniform block.
+static const std::vector<std::pair<std::string, GLint>> active_uniforms{
+    {"v", 0}, {"p", 1}, {"view_pos", 2}, {"planes[0]", 3}, {"level", 9}, {"blk.m", -1}};
+static GLint location_offset{0};
+static std::map<GLuint, GLint> program_offsets;
+static GLuint next_object{1u};
+
+// GL calls the shader programs made, and the first float of the last value set per location.
+static uint32_t location_lookups{0u}, uniform_uploads{0u};
+static std::map<GLint, float> uploaded;
+
+static void APIENTRY get_integer(GLenum, GLint *v) { *v = 0; }
+static const GLubyte *APIENTRY get_string(GLenum) { return (const GLubyte *)"test"; }
+static GLuint APIENTRY create_program() {
+    program_offsets[next_object] = location_offset;
+    return next_object++;
+}
+static GLuint APIENTRY create_shader(GLenum) { return next_object++; }
+static void APIENTRY shader_source(GLuint, GLsizei, const GLchar *const *, const GLint *) {}
+static void APIENTRY object_call(GLuint) {}
+static void APIENTRY attach_shader(GLuint, GLuint) {}
+static void APIENTRY program_parameter(GLuint, GLenum, GLint) {}
+static void APIENTRY get_program(GLuint, GLenum e, GLint *v) { *v = e == GL_LINK_STATUS; }
+static GLint APIENTRY get_uniform_location(GLuint, const GLchar *) {
+    location_lookups++;
+    return -1;
+}
+static void APIENTRY get_interface(GLuint, GLenum, GLenum e, GLint *v) {
+    *v = e == GL_ACTIVE_RESOURCES ? (GLint)active_uniforms.size() : 32;
+}
+static void APIENTRY get_resource(
+    GLuint program, GLenum, GLuint i, GLsizei, const GLenum *, GLsizei, GLsizei *, GLint *v) {
+    const auto location = active_uniforms[i].second;
+    *v                  = location < 0 ? -1 : location + program_offsets[program];
+}
+static void APIENTRY get_resource_name(
+    GLuint, GLenum, GLuint i, GLsizei, GLsizei *length, GLchar *name) {
+    const auto &n = active_uniforms[i].first;
+    std::memcpy(name, n.c_str(), n.size() + 1u);
+    *length = (GLsizei)n.size();
+}
+static void upload(GLint location, float value) {
+    uniform_uploads++;
+    if (location >= 0) { uploaded[location] = value; }
+}
+static void APIENTRY uniform_1i(GLint l, GLsizei, const GLint *v) { upload(l, (float)*v); }
+static void APIENTRY uniform_fv(GLint l, GLsizei, const GLfloat *v) { upload(l, *v); }
+static void APIENTRY uniform_matrix(GLint l, GLsizei, GLboolean, const GLfloat *v) {
+    upload(l, *v);
+}
+
+static void stub_driver() {
+    test::stub_gl();
+    glad_glGetIntegerv            = get_integer;
+    glad_glGetString              = get_string;
+    glad_glCreateProgram          = create_program;
+    glad_glCreateShader           = create_shader;
+    glad_glShaderSource           = shader_source;
+    glad_glCompileShader          = object_call;
+    glad_glAttachShader           = attach_shader;
+    glad_glProgramParameteri      = program_parameter;
+    glad_glLinkProgram            = object_call;
+    glad_glGetProgramiv           = get_program;
+    glad_glUseProgram             = object_call;
+    glad_glGetUniformLocation     = get_uniform_location;
+    glad_glGetProgramInterfaceiv  = get_interface;
+    glad_glGetProgramResourceiv   = get_resource;
+    glad_glGetProgramResourceName = get_resource_name;
+    glad_glUniform1iv             = uniform_1i;
+    glad_glUniform1fv             = uniform_fv;
+    glad_glUniform3fv             = uniform_fv;
+    glad_glUniform4fv             = uniform_fv;
+    glad_glUniformMatrix4fv       = uniform_matrix;
+}
+
+static const UniformHandle<glm::mat4> U_VIEW{"v"}, U_PROJECTION{"p"};
+static const UniformHandle<glm::vec3> U_VIEW_POS{"view_pos"};
+static const UniformHandle<int> U_LEVEL{"level"};
+
+// Values land at the locations the driver reported, whichever way they are set. Arrays resolve
+// through their base name, block members and unknown names go to -1 where GL ignores them.
+static void locations() {
+    ShaderProgram program{"u"};
+    program.use();
+    uploaded.clear();
+
+    const std::array<glm::vec4, 6> planes{glm::vec4{5.f}};
+    program.set("v", glm::mat4{1.f});
+    program.set(U_PROJECTION, glm::mat4{2.f});
+    program.set(U_VIEW_POS, glm::vec3{3.f});
+    program.set("planes", std::span<const glm::vec4>{planes});
+    program.set("level", 4);
+    CHECK(uploaded[0] == 1.f && uploaded[1] == 2.f && uploaded[2] == 3.f);
+    CHECK(uploaded[3] == 5.f && uploaded[9] == 4.f);
+
+    program.set("blk.m", 6.f);
+    program.set("missing", 6.f);
+    CHECK(uploaded.size() == 5u);
+    CHECK(location_lookups == 0u);
+}
+
+// A frame of the forward pass: the camera uniforms of every batch, set by name and then through
+// handles. Both make one GL call per set() and no location lookups, where every set() used to
+// call glGetUniformLocation first.
+static void call_counts() {
+    static constexpr uint32_t batches{64u};
+    std::vector<ShaderProgram> programs;
+    for (auto i = 0u; i < 4u; ++i) { programs.emplace_back("u"); }
+    for (auto &p : programs) { p.use(); }
+    ShaderProgram::next_frame();
+
+    const glm::mat4 m{1.f};
+    const glm::vec3 v{1.f};
+    const auto frame = [&](bool by_handle) {
+        location_lookups = uniform_uploads = 0u;
+        for (auto i = 0u; i < batches; ++i) {
+            auto &p = programs[i * programs.size() / batches];
+            p.use();
+            if (by_handle) {
+                p.set(U_VIEW, m);
+                p.set(U_PROJECTION, m);
+                p.set(U_VIEW_POS, v);
+            } else {
+                p.set("v", m);
+                p.set("p", m);
+                p.set("view_pos", v);
+            }
+        }
+        ShaderProgram::next_frame();
+        return ShaderProgram::uniform_stats();
+    };
+
+    const auto by_name = frame(false);
+    CHECK(by_name.set_by_name == 3u * batches && by_name.set_by_handle == 0u);
+    CHECK(by_name.introspection_calls == 0u && by_name.gl_calls() == uniform_uploads);
+    CHECK(location_lookups == 0u);
+
+    const auto by_handle = frame(true);
+    CHECK(by_handle.set_by_handle == 3u * batches && by_handle.set_by_name == 0u);
+    CHECK(by_handle.introspection_calls == 0u && by_handle.gl_calls() == uniform_uploads);
+    CHECK(location_lookups == 0u);
+
+    std::printf("%u batches: %u GL calls by name, %u by handle, %u with a lookup per set()\n",
+                batches,
+                by_name.gl_calls(),
+                by_handle.gl_calls(),
+                by_name.gl_calls_uncached());
+}
+
+// Handles resolve again against the locations of the new program once a rebuild is swapped in,
+// and reading its uniforms is counted in that frame.
+static void relink() {
+    ShaderProgram program{"u"};
+    program.use();
+    program.set(U_LEVEL, 1);
+    CHECK(uploaded[9 + location_offset] == 1.f);
+    ShaderProgram::next_frame();
+
+    location_offset = 16;
+    program.recompile();
+    while (program.is_compiling()) { program.use(); }
+    uploaded.clear();
+    program.set(U_LEVEL, 2);
+    CHECK(uploaded.size() == 1u && uploaded[9 + location_offset] == 2.f);
+
+    ShaderProgram::next_frame();
+    const auto &stats = ShaderProgram::uniform_stats();
+    // Two interface queries, a location per uniform and a name per uniform with a location.
+    CHECK(stats.introspection_calls == 2u + 6u + 5u);
+    CHECK(stats.set_by_handle == 1u);
+    location_offset = 0;
+}
+
+int main() {
+    stub_driver();
+
+    // Programs are read from shaders/ under the working directory.
+    const auto dir = std::filesystem::temp_directory_path() / "engine_test_uniforms";
+    std::filesystem::create_directories(dir / "shaders");
+    std::filesystem::current_path(dir);
+    std::ofstream{"shaders/u.vert"} << "vertex";
+    std::ofstream{"shaders/u.frag"} << "fragment";
+
+    auto &engine          = Engine::instance();
+    engine._program_cache = std::make_unique<ProgramCache>(dir / "cache");
+    engine._thread_pool   = std::make_unique<ThreadPool>(1u);
+
+    locations();
+    call_counts();
+    relink();
+
+    engine._thread_pool.reset();
+    engine._program_cache.reset();
+    std::filesystem::current_path(dir.parent_path());
+    std::filesystem::remove_all(dir);
+    return test::result();
+}
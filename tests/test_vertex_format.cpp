@@ -0,0 +1,80 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <engine/renderer/vertex_format.hpp>
+
+#include "check.hpp"
+
+using namespace eng;
+
+// Random vertices with differently sized ranges per axis round trip through PackedVertex within
+// half a quantization step of their mesh's range, tangent frames within half a 10 bit step.
+static void round_trip() {
+    constexpr auto count = 10'000u;
+    constexpr auto fv    = vertex_format::FLOATS_PER_VERTEX;
+
+    std::mt19937 rng{1u};
+    std::uniform_real_distribution<float> d{-3.f, 5.f}, u{0.f, 4.f};
+    std::vector<float> vertices;
+    for (auto i = 0u; i < count; ++i) {
+        const auto t = glm::normalize(glm::vec3{d(rng), d(rng), d(rng)});
+        const auto b = glm::normalize(glm::vec3{d(rng), d(rng), d(rng)});
+        const float v[fv]{d(rng) * 10.f, d(rng), d(rng) * .1f, u(rng), u(rng) - 2.f, 0.f,
+                          t.x,           t.y,    t.z,          b.x,    b.y,          b.z};
+        vertices.insert(vertices.end(), v, v + fv);
+    }
+
+    const auto q = vertex_format::quantization(vertices);
+    std::vector<PackedVertex> packed(count);
+    vertex_format::pack(vertices, q, packed.data());
+
+    // Half a step of the snorm grid plus float rounding of offset + c * scale.
+    const auto pos_tolerance     = glm::vec3{q.position_scale} * (.5f / 32767.f) + 1e-5f;
+    const auto uv_tolerance      = glm::vec2{q.uv.z, q.uv.w} * (.5f / 32767.f) + 1e-6f;
+    const auto tangent_tolerance = .5f / 511.f + 1e-6f;
+    for (auto i = 0u; i < count; ++i) {
+        const auto v = &vertices[i * fv];
+        const auto p = vertex_format::unpack_position(packed[i], q);
+        CHECK(glm::all(glm::lessThanEqual(glm::abs(p - glm::vec3{v[0], v[1], v[2]}),
+                                          pos_tolerance)));
+        const auto uv = vertex_format::unpack_uv(packed[i], q);
+        CHECK(glm::all(glm::lessThanEqual(glm::abs(uv - glm::vec2{v[3], v[4]}), uv_tolerance)));
+
+        const auto t = vertex_format::unpack_tangent(packed[i].tangent);
+        const auto b = vertex_format::unpack_tangent(packed[i].bitangent);
+        CHECK(glm::all(glm::lessThanEqual(glm::abs(t - glm::vec3{v[6], v[7], v[8]}),
+                                          glm::vec3{tangent_tolerance})));
+        CHECK(glm::all(glm::lessThanEqual(glm::abs(b - glm::vec3{v[9], v[10], v[11]}),
+                                          glm::vec3{tangent_tolerance})));
+    }
+}
+
+// Range ends map to exactly -1 and 1, so the extremes come back exactly. A flat mesh keeps
+// scale 0 and every vertex unpacks to the single position it has.
+static void exact_cases() {
+    constexpr auto fv = vertex_format::FLOATS_PER_VERTEX;
+    std::vector<float> line(2u * fv, 0.f);
+    line[0]      = -2.f;
+    line[fv + 0] = 6.f;
+    auto q       = vertex_format::quantization(line);
+    PackedVertex packed[2];
+    vertex_format::pack(line, q, packed);
+    CHECK(packed[0].position[0] == -32767 && packed[1].position[0] == 32767);
+    CHECK(vertex_format::unpack_position(packed[0], q).x == -2.f);
+    CHECK(vertex_format::unpack_position(packed[1], q).x == 6.f);
+
+    std::vector<float> flat(2u * fv, 1.f);
+    q = vertex_format::quantization(flat);
+    vertex_format::pack(flat, q, packed);
+    CHECK(vertex_format::unpack_position(packed[1], q) == glm::vec3{1.f});
+    CHECK(vertex_format::unpack_uv(packed[1], q) == glm::vec2{1.f});
+}
+
+int main() {
+    round_trip();
+    exact_cases();
+    return test::result();
+}